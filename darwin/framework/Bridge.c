@@ -19,8 +19,29 @@ extern void stop_listening(void);
 extern void connect_device(const char* identifier);
 extern void disconnect_device(const char* identifier);
 extern void send_data(const char* identifier, uint32_t data_size, uint8_t* data);
+extern void set_write_mode(uint32_t mode, uint32_t max_in_flight);
 extern void reset(void);
 
+static GDDataCallbackFunction s_data_callback = NULL;
+static GDEventCallbackFunction s_event_callback = NULL;
+
+static void install_data_callback(void) {
+    GDDataCallbackFunction dataCallback = s_data_callback;
+    GDEventCallbackFunction eventCallback = s_event_callback;
+    
+    set_data_callback(^(const char* identifier, uint32_t data_size, uint8_t* data) {
+        if (dataCallback) {
+            dataCallback(identifier, data_size, data);
+        }
+        if (eventCallback) {
+            GDEvent event;
+            if (godice_decode_packet(data_size, data, &event)) {
+                eventCallback(identifier, &event);
+            }
+        }
+    });
+}
+
 void godice_set_callbacks(GDDeviceFoundCallbackFunction deviceFoundCallback,
                           GDDataCallbackFunction dataReceivedCallback,
                           GDDeviceConnectedCallbackFunction deviceConnectedCallback,
@@ -31,9 +52,8 @@ void godice_set_callbacks(GDDeviceFoundCallbackFunction deviceFoundCallback,
         deviceFoundCallback(identifier, name);
     });
     
-    set_data_callback(^(const char* identifier, uint32_t data_size, uint8_t* data) {
-        dataReceivedCallback(identifier, data_size, data);
-    });
+    s_data_callback = dataReceivedCallback;
+    install_data_callback();
     
     set_device_connected_callback(^(const char* identifier) {
         deviceConnectedCallback(identifier);
@@ -48,6 +68,11 @@ void godice_set_callbacks(GDDeviceFoundCallbackFunction deviceFoundCallback,
     });
 }
 
+void godice_set_event_callback(GDEventCallbackFunction eventCallback) {
+    s_event_callback = eventCallback;
+    install_data_callback();
+}
+
 void godice_set_logger(GDLogger logger) {
     set_logger(^(const char* str) {
         logger(str);
@@ -74,6 +99,10 @@ void godice_send(const char* identifier, uint32_t data_size, uint8_t* data) {
     send_data(identifier, data_size, data);
 }
 
+void godice_set_write_mode(uint32_t mode, uint32_t max_in_flight) {
+    set_write_mode(mode, max_in_flight);
+}
+
 void godice_reset(void) {
     reset();
 }
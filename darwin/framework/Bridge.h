@@ -9,10 +9,11 @@
 #ifndef GodiceFramework_Darwin_Framework_Bridge_h
 #define GodiceFramework_Darwin_Framework_Bridge_h
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
-extern “C” {
+extern "C" {
 #endif
 
 typedef void (*GDDeviceFoundCallbackFunction)(const char* identifier, const char* name);
@@ -23,19 +24,68 @@ typedef void (*GDDeviceDisconnectedCallbackFunction)(const char* identifier);
 typedef void (*GDListenerStoppedCallbackFunction)(void);
 typedef void (*GDLogger)(const char* str);
 
+// Decoded die messages; kept in sync with windows/GoDiceDll/GoDiceDll.h
+typedef enum GDEventType {
+    GD_EVENT_UNKNOWN = 0,
+    GD_EVENT_ROLL_STARTED = 1,
+    GD_EVENT_STABLE = 2,
+    GD_EVENT_FAKE_STABLE = 3,
+    GD_EVENT_TILT_STABLE = 4,
+    GD_EVENT_MOVE_STABLE = 5,
+    GD_EVENT_BATTERY_LEVEL = 6,
+    GD_EVENT_COLOR = 7,
+} GDEventType;
+
+typedef struct GDEvent {
+    uint32_t type;
+    int8_t x;
+    int8_t y;
+    int8_t z;
+    uint8_t value;
+} GDEvent;
+
+typedef void (*GDEventCallbackFunction)(const char* identifier, const GDEvent* event);
+
+typedef enum GDDieType {
+    GD_DIE_D6 = 0,
+    GD_DIE_D20 = 1,
+    GD_DIE_D10 = 2,
+    GD_DIE_D10X = 3,
+    GD_DIE_D4 = 4,
+    GD_DIE_D8 = 5,
+    GD_DIE_D12 = 6,
+} GDDieType;
+
+typedef struct GDVector {
+    int8_t x;
+    int8_t y;
+    int8_t z;
+} GDVector;
+
+typedef enum GDWriteMode {
+    GD_WRITE_WITHOUT_RESPONSE = 0,
+    GD_WRITE_WITH_RESPONSE = 1,
+} GDWriteMode;
+
 void godice_set_callbacks(GDDeviceFoundCallbackFunction deviceFoundCallback,
                           GDDataCallbackFunction dataReceivedCallback,
                           GDDeviceConnectedCallbackFunction deviceConnectedCallback,
                           GDDeviceConnectionFailedCallbackFunction deviceConnectionFailedCallback,
                           GDDeviceDisconnectedCallbackFunction deviceDisconnectedCallback,
                           GDListenerStoppedCallbackFunction listenerStoppedCallback);
+void godice_set_event_callback(GDEventCallbackFunction eventCallback);
 void godice_set_logger(GDLogger logger);
 void godice_start_listening(void);
 void godice_stop_listening(void);
 void godice_connect(const char* identifier);
 void godice_disconnect(const char* identifier);
 void godice_send(const char* identifier, uint32_t data_size, uint8_t* data);
+// max_in_flight is ignored here: CoreBluetooth paces writes without response itself
+void godice_set_write_mode(uint32_t mode, uint32_t max_in_flight);
 void godice_reset(void);
+bool godice_decode_packet(uint32_t data_size, const uint8_t* data, GDEvent* event);
+uint8_t godice_classify_face(uint32_t die_type, GDVector vector);
+void godice_classify_faces(uint32_t die_type, uint32_t count, const GDVector* vectors, uint8_t* faces);
     
 #ifdef __cplusplus
 }
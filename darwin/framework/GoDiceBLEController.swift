@@ -17,6 +17,7 @@ public class GoDiceBLEController: NSObject {
     private static let notifyUUID = CBUUID(string: "6e400003-b5a3-f393-e0a9-e50e24dcca9e")
     
     private var sessions: [String : DiceSession] = [:]
+    private var writeType: CBCharacteristicWriteType = .withoutResponse
     
     public typealias DeviceFoundCallback = (String, String) -> Void
     public typealias DataCallback = (String, Data) -> Void
@@ -71,9 +72,18 @@ public class GoDiceBLEController: NSObject {
     }
     
     public func sendData(identifier: String, data: Data) -> Void {
-        if let session = sessions[identifier] {
-            logger("Sending data!\n")
-            session.peripheral.writeValue(data, for: session.writeCharacteristic, type: .withResponse)
+        queue.async {
+            if let session = self.sessions[identifier] {
+                self.logger("Sending data!\n")
+                session.send(message: data, type: self.writeType)
+            }
+        }
+    }
+    
+    // Writes without response are paced by CoreBluetooth's own buffer, so there is no in-flight limit here
+    public func setWriteType(_ type: CBCharacteristicWriteType) -> Void {
+        queue.async {
+            self.writeType = type
         }
     }
     
@@ -137,6 +147,10 @@ public class GoDiceBLEController: NSObject {
         let logger: Logger
         var writeCharacteristic: CBCharacteristic!
         
+        // Commands waiting for the link, oldest first
+        private var outbound: [(message: Data, type: CBCharacteristicWriteType)] = []
+        private var awaitingResponse = false
+        
         init(peripheral: CBPeripheral,
              connectedCallback: @escaping(CBPeripheral) -> Void,
              connectionFailedCallback: @escaping(CBPeripheral) -> Void,
@@ -155,8 +169,74 @@ public class GoDiceBLEController: NSObject {
             peripheral.discoverServices([GoDiceBLEController.serviceUUID])
         }
         
-        func send(message: Data) -> Void {
-            peripheral.writeValue(message, for: writeCharacteristic, type: .withResponse)
+        // A newer LED command replaces one still waiting, and so does a repeated
+        // battery or color request; see godice::protocol::command_class
+        static func commandClass(_ message: Data) -> UInt8 {
+            guard let first = message.first else {
+                return 0
+            }
+            switch first {
+            case 8, 16:
+                return 8
+            case 3, 23:
+                return message.count == 1 ? first : 0
+            default:
+                return 0
+            }
+        }
+        
+        func send(message: Data, type: CBCharacteristicWriteType) -> Void {
+            let kind = DiceSession.commandClass(message)
+            if kind != 0, let index = outbound.firstIndex(where: { DiceSession.commandClass($0.message) == kind }) {
+                outbound[index] = (message, type)
+            } else {
+                outbound.append((message, type))
+            }
+            sendWaiting()
+        }
+        
+        func dropWaiting() -> Void {
+            outbound.removeAll()
+            awaitingResponse = false
+        }
+        
+        private func sendWaiting() -> Void {
+            guard writeCharacteristic != nil else {
+                return
+            }
+            while !awaitingResponse, let next = outbound.first {
+                let type = supportedWriteType(next.type)
+                if type == .withoutResponse && !peripheral.canSendWriteWithoutResponse {
+                    return
+                }
+                outbound.removeFirst()
+                peripheral.writeValue(next.message, for: writeCharacteristic, type: type)
+                awaitingResponse = type == .withResponse
+            }
+        }
+        
+        // A die whose write characteristic lacks the requested kind of write gets the other
+        private func supportedWriteType(_ requested: CBCharacteristicWriteType) -> CBCharacteristicWriteType {
+            let properties = writeCharacteristic.properties
+            if requested == .withoutResponse && !properties.contains(.writeWithoutResponse) {
+                return .withResponse
+            }
+            if requested == .withResponse && !properties.contains(.write) {
+                return .withoutResponse
+            }
+            return requested
+        }
+        
+        func peripheral(_ peripheral: CBPeripheral, didWriteValueFor characteristic: CBCharacteristic, error: Error?) {
+            if let error = error {
+                logger("Write failed: \(error.localizedDescription)")
+            }
+            awaitingResponse = false
+            sendWaiting()
+        }
+        
+        func peripheralIsReady(toSendWriteWithoutResponse peripheral: CBPeripheral) {
+            sendWaiting()
         }
         
         func peripheral(_ peripheral: CBPeripheral, didDiscoverServices error: Error?) {
@@ -179,8 +259,17 @@ public class GoDiceBLEController: NSObject {
                     logger("Unable to find write characteristic")
                     return
                 }
+                guard !writeCH.properties.isDisjoint(with: [.write, .writeWithoutResponse]) else {
+                    logger("Write characteristic takes neither kind of write")
+                    connectionFailedCallback(peripheral)
+                    return
+                }
+                if !writeCH.properties.contains(.writeWithoutResponse) {
+                    logger("Write characteristic has no writeWithoutResponse property, writing with response")
+                }
                 writeCharacteristic = writeCH
                 peripheral.setNotifyValue(true, for: notifyCH)
+                sendWaiting()
                 
                 connectedCallback(peripheral)
             } else {
@@ -253,6 +342,7 @@ extension GoDiceBLEController: CBCentralManagerDelegate, CBPeripheralDelegate {
     public func centralManager(_ central: CBCentralManager, didDisconnectPeripheral peripheral: CBPeripheral, error: Error?) {
         logger("Received error \(error?.localizedDescription ?? "unknown")")
         
+        sessions[peripheral.identifier.uuidString]?.dropWaiting()
         deviceDisconnectedCallback(peripheral.identifier.uuidString)
     }
     
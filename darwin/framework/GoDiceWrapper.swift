@@ -78,6 +78,11 @@ func SendData(identifier: UnsafePointer<CChar>, byteCount: UInt32, rawBytes: Uns
     btc.sendData(identifier: String(cString: identifier), data: Data(bytes: rawBytes, count: Int(byteCount)))
 }
 
+@_cdecl("set_write_mode")
+func SetWriteMode(mode: UInt32, maxInFlight: UInt32) -> Void {
+    btc.setWriteType(mode == 1 ? .withResponse : .withoutResponse)
+}
+
 @_cdecl("start_listening")
 func StartListening() -> Void {
     btc.listening = true
@@ -13,70 +13,47 @@ public class DiceInterface : MonoBehaviour
 {
     IDiceInterfaceImports diceInterfaceImports = new NativeDiceInterfaceImports();
 
-    private static byte[] rollVector(List<byte> rawData) {
-        if (rawData.Count < 1) {
-            Debug.Log("rollVector: no data");
-            return null;
-        }
-        byte firstByte = rawData[0];
-        if (firstByte != 83) {
-            Debug.Log("rollVector: first byte is not 83");
-            return null;
-        }
-        if (rawData.Count != 4) {
-            Debug.Log("rollVector: data length is not 4");
-            return null;
+    // Raw packets are only used for the connection notification; everything else
+    // arrives already decoded through DelegateEventReceived.
+    private static void DelegateMessageReceived(string name, List<byte> byteList) {
+        if (_singleton != null && byteList.Count == 0 && _singleton.connectionCallback != null) {
+            _singleton.connectionCallback(name);
         }
-        return new byte[] { rawData[1], rawData[2], rawData[3] };
     }
-    
-    private static void DelegateMessageReceived(string name, List<byte> byteList) {
-        if (_singleton != null) {
-            if (byteList.Count == 0) {
-                if (_singleton.connectionCallback != null) {
-                    _singleton.connectionCallback(name);
-                    return;
-                }
-            } else {
-                byte firstByte = byteList[0];
 
-                switch (firstByte) {
-                    case 82:
-                        // Roll started
-                        break;
-                    case 66:
-                        // Battery level
-                        break;
-                    case 67:
-                        // Color (fetched)
-                        break;
-                    case 83: {
-                        var roll = rollVector(byteList);
-                        if (roll != null && _singleton.rollCallback != null) {
-                            _singleton.rollCallback(name, roll[0], roll[1], roll[2]);
-                        }
-                        break;
-                    }
-                    case 70:
-                    case 84:
-                    case 77: {
-                        byteList.RemoveAt(0);
-                        var roll = rollVector(byteList);
-                        if (roll != null && _singleton.rollCallback != null) {
-                            _singleton.rollCallback(name, roll[0], roll[1], roll[2]);
-                        }
-                        break;
-                    }
-                    default:
-                        Debug.Log("Not yet handled");
-                        break;
+    private static void DelegateEventReceived(string name, GoDiceEvent diceEvent) {
+        if (_singleton == null) {
+            return;
+        }
+
+        switch (diceEvent.type) {
+            case GoDiceEventType.RollStarted:
+            case GoDiceEventType.BatteryLevel:
+            case GoDiceEventType.Color:
+                break;
+            case GoDiceEventType.Stable:
+            case GoDiceEventType.FakeStable:
+            case GoDiceEventType.TiltStable:
+            case GoDiceEventType.MoveStable:
+                if (_singleton.rollCallback != null) {
+                    _singleton.rollCallback(name, (byte)diceEvent.x, (byte)diceEvent.y, (byte)diceEvent.z);
                 }
-            }
+                break;
+            default:
+                Debug.Log("Not yet handled");
+                break;
         }
     }
 
     private static DiceInterface _singleton = null;
 
+    // Where the native side supports it, events wait in its queue and Update drains them
+    // on the main thread; otherwise they arrive through the delegates above on the
+    // framework's callback thread
+    private const uint PollCapacity = 4096;
+    private bool polling = false;
+    private readonly GoDicePollEvent[] polledEvents = new GoDicePollEvent[256];
+
     public delegate void ConnectionCallback(string name);
     public delegate void RollCallback(string name, byte x, byte y, byte z);
     
@@ -84,7 +61,9 @@ public class DiceInterface : MonoBehaviour
     public RollCallback rollCallback = null;
     
     public void StartListening() {
+        polling = diceInterfaceImports.EnablePolling(PollCapacity);
         diceInterfaceImports.SetCallback(DelegateMessageReceived);
+        diceInterfaceImports.SetEventCallback(DelegateEventReceived);
         diceInterfaceImports.StartListening();
     }
     
@@ -100,6 +79,32 @@ public class DiceInterface : MonoBehaviour
     // Update is called once per frame
     void Update()
     {
-        
+        if (!polling) {
+            return;
+        }
+
+        int count;
+        while ((count = diceInterfaceImports.PollEvents(polledEvents)) > 0) {
+            for (int i = 0; i < count; i++) {
+                HandlePolledEvent(ref polledEvents[i]);
+            }
+        }
+    }
+
+    private void HandlePolledEvent(ref GoDicePollEvent polled) {
+        switch (polled.type) {
+            case GoDicePollEventType.Connected:
+                if (connectionCallback != null) {
+                    connectionCallback(polled.device.ToString());
+                }
+                break;
+            case GoDicePollEventType.Data:
+                if (polled.diceEvent.type != GoDiceEventType.Unknown) {
+                    DelegateEventReceived(polled.device.ToString(), polled.diceEvent);
+                }
+                break;
+            default:
+                break;
+        }
     }
 }
@@ -1,10 +1,56 @@
+using System;
 using System.Collections.Generic;
+using System.Runtime.InteropServices;
 
 namespace UnityGoDiceInterface {
+    // Mirrors GDEventType in GoDiceDll.h / Bridge.h
+    public enum GoDiceEventType : UInt32 {
+        Unknown = 0,
+        RollStarted = 1,
+        Stable = 2,
+        FakeStable = 3,
+        TiltStable = 4,
+        MoveStable = 5,
+        BatteryLevel = 6,
+        Color = 7,
+    }
+
+    // Mirrors GDEvent; blittable so it crosses the native boundary without marshalling
+    [StructLayout(LayoutKind.Sequential)]
+    public struct GoDiceEvent {
+        public GoDiceEventType type;
+        public sbyte x;
+        public sbyte y;
+        public sbyte z;
+        public byte value;
+    }
+
+    // Mirrors GDPollEventType
+    public enum GoDicePollEventType : UInt32 {
+        DeviceFound = 0,
+        Connected = 1,
+        ConnectionFailed = 2,
+        Disconnected = 3,
+        Data = 4,
+        ListenerStopped = 5,
+    }
+
+    // Mirrors the leading fields of GDPollEvent. The raw packet and the device name follow
+    // them natively; Size keeps the array stride right without needing unsafe fixed buffers.
+    [StructLayout(LayoutKind.Sequential, Size = 80)]
+    public struct GoDicePollEvent {
+        public UInt64 device;
+        public GoDicePollEventType type;
+        public UInt32 dataSize;
+        public GoDiceEvent diceEvent;
+    }
+
     public interface IDiceInterfaceImports {
         delegate void DelegateMessage(string name, List<byte> bytes);
+        delegate void DelegateEvent(string name, GoDiceEvent diceEvent);
         
         protected static DelegateMessage Delegate;
+        protected static DelegateEvent EventDelegate;
         
         public void StartListening();
   
@@ -13,5 +59,19 @@ namespace UnityGoDiceInterface {
         public void SetCallback(IDiceInterfaceImports.DelegateMessage delegateMessage) {
             Delegate = delegateMessage;
         }
+
+        public void SetEventCallback(IDiceInterfaceImports.DelegateEvent delegateEvent) {
+            EventDelegate = delegateEvent;
+        }
+
+        // Returns false where the native side cannot queue events for polling
+        public bool EnablePolling(UInt32 capacity) {
+            return false;
+        }
+
+        // Fills events from the front and returns how many were filled
+        public int PollEvents(GoDicePollEvent[] events) {
+            return 0;
+        }
     }
 }
\ No newline at end of file
@@ -17,6 +17,7 @@ namespace UnityGoDiceInterface {
 #endif
         
         private delegate void MonoDelegateMessage(string name, UInt32 byteCount, IntPtr bytePtr);
+        private delegate void MonoDelegateEvent(string name, ref GoDiceEvent diceEvent);
     
         [DllImport (dllName: BundleName, EntryPoint = "godice_start_listening")]
         private static extern void _NativeBridgeStartListening();
@@ -27,6 +28,27 @@ namespace UnityGoDiceInterface {
         [DllImport (dllName: BundleName, EntryPoint = "godice_set_callback")]
         private static extern void _NativeBridgeSetCallback(MonoDelegateMessage monoDelegateMessage);
 
+        [DllImport (dllName: BundleName, EntryPoint = "godice_set_event_callback")]
+        private static extern void _NativeBridgeSetEventCallback(MonoDelegateEvent monoDelegateEvent);
+
+#if UNITY_STANDALONE_WIN || UNITY_EDITOR_WIN
+        [DllImport (dllName: BundleName, EntryPoint = "godice_enable_polling")]
+        private static extern void _NativeBridgeEnablePolling(UInt32 capacity);
+
+        [DllImport (dllName: BundleName, EntryPoint = "godice_poll_events")]
+        private static extern UInt32 _NativeBridgePollEvents([Out] GoDicePollEvent[] events, UInt32 maxEvents);
+
+        public bool EnablePolling(UInt32 capacity) {
+            _NativeBridgeEnablePolling(capacity);
+            return true;
+        }
+
+        // The array is blittable, so it is pinned and filled in place
+        public int PollEvents(GoDicePollEvent[] events) {
+            return (int)_NativeBridgePollEvents(events, (UInt32)events.Length);
+        }
+#endif
+
         private static List<byte> BytesFromRawPointer(UInt32 byteCount, IntPtr bytes) {
             byte[] array = new byte[byteCount];
             if (byteCount > 0)
@@ -38,13 +60,25 @@ namespace UnityGoDiceInterface {
     
         [MonoPInvokeCallback(typeof(MonoDelegateMessage))]
         private static void MonoDelegateMessageReceived(string name, UInt32 byteCount, IntPtr bytePtr) {
+            // Packets with a payload are delivered decoded through the event callback; skip the managed copy
+            if (byteCount > 0 && IDiceInterfaceImports.EventDelegate != null) {
+                return;
+            }
             if (IDiceInterfaceImports.Delegate != null) {
                 IDiceInterfaceImports.Delegate(name, BytesFromRawPointer(byteCount, bytePtr));
             }
         }
         
+        [MonoPInvokeCallback(typeof(MonoDelegateEvent))]
+        private static void MonoDelegateEventReceived(string name, ref GoDiceEvent diceEvent) {
+            if (IDiceInterfaceImports.EventDelegate != null) {
+                IDiceInterfaceImports.EventDelegate(name, diceEvent);
+            }
+        }
+        
         public void StartListening() {
             _NativeBridgeSetCallback(MonoDelegateMessageReceived);
+            _NativeBridgeSetEventCallback(MonoDelegateEventReceived);
             _NativeBridgeStartListening();
         }
         
@@ -0,0 +1,159 @@
+// ConnectBenchmark.cpp
+//
+// Measures time-to-all-connected through godice_connect for a room of dice,
+// sweeping the connection scheduler's concurrency limit. The fake transport
+// injects a fixed delay into each stage (link + GATT discovery, then enabling
+// notifications) and, like a real adapter, serialises operations on one die
+// while letting different dice proceed in parallel.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../GoDiceDll/GoDiceDll.h"
+#include "../GoDiceDll/Transport.h"
+
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+static constexpr int k_dice = 20;
+static constexpr milliseconds k_connect_delay(150);
+static constexpr milliseconds k_subscribe_delay(40);
+static constexpr uint32_t k_limits[] = { 1, 2, 4, 8, 20 };
+static constexpr uint64_t k_first_address = 0xC0EC00000000ull;
+
+class DelayTransport final : public Transport
+{
+private:
+    const int dice_;
+    TransportListener* listener_ = nullptr;
+
+    std::mutex mutex_;
+    std::vector<std::thread> workers_;
+    std::unique_ptr<std::mutex[]> die_locks_;
+
+    void after(uint64_t address, milliseconds delay, TransportCompletion completion)
+    {
+        std::scoped_lock lk(mutex_);
+        workers_.emplace_back([this, address, delay, completion = std::move(completion)]
+        {
+            {
+                std::scoped_lock die_lock(die_locks_[address - k_first_address]);
+                std::this_thread::sleep_for(delay);
+            }
+            completion(true);
+        });
+    }
+
+public:
+    explicit DelayTransport(int dice) : dice_(dice), die_locks_(new std::mutex[dice]) {}
+
+    ~DelayTransport() override
+    {
+        std::scoped_lock lk(mutex_);
+        for (auto& worker : workers_)
+        {
+            worker.join();
+        }
+    }
+
+    void set_listener(TransportListener* listener) override { listener_ = listener; }
+
+    void start_discovery() override
+    {
+        for (int i = 0; i < dice_; i++)
+        {
+            listener_->on_advertisement(k_first_address + i, "GoDice_DELAY_K_v04", -50);
+        }
+    }
+
+    void stop_discovery() override { listener_->on_discovery_stopped(); }
+
+    void connect(uint64_t address, TransportCompletion completion) override { after(address, k_connect_delay, std::move(completion)); }
+    void subscribe(uint64_t address, TransportCompletion completion) override { after(address, k_subscribe_delay, std::move(completion)); }
+    void write(uint64_t, const uint8_t*, uint32_t, WriteMode, TransportCompletion completion) override { completion(true); }
+    void disconnect(uint64_t, TransportCompletion completion) override { completion(true); }
+    void reset() override {}
+};
+
+static std::mutex g_found_mutex;
+static std::vector<std::string> g_found;
+static std::atomic<int> g_connected = 0;
+static std::atomic<int> g_failed = 0;
+
+static void device_found(const char* identifier, const char*)
+{
+    std::scoped_lock lk(g_found_mutex);
+    for (const auto& found : g_found)
+    {
+        if (found == identifier) return;
+    }
+    g_found.emplace_back(identifier);
+}
+
+static void device_connected(const char*) { g_connected.fetch_add(1); }
+static void device_connection_failed(const char*) { g_failed.fetch_add(1); }
+
+static auto time_to_all_connected(uint32_t limit) -> double
+{
+    {
+        std::scoped_lock lk(g_found_mutex);
+        g_found.clear();
+    }
+    g_connected = 0;
+    g_failed = 0;
+
+    install_transport(std::make_unique<DelayTransport>(k_dice));
+    godice_set_max_concurrent_connections(limit);
+    godice_start_listening();
+
+    std::vector<std::string> identifiers;
+    while (identifiers.size() < k_dice)
+    {
+        std::this_thread::yield();
+        std::scoped_lock lk(g_found_mutex);
+        identifiers = g_found;
+    }
+
+    const auto start = steady_clock::now();
+    for (const auto& identifier : identifiers)
+    {
+        godice_connect(identifier.c_str());
+    }
+    while (g_connected.load() + g_failed.load() < k_dice)
+    {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    const auto elapsed = std::chrono::duration<double, std::milli>(steady_clock::now() - start).count();
+
+    godice_stop_listening();
+    return elapsed;
+}
+
+int main()
+{
+    godice_set_callbacks(device_found, nullptr, device_connected, device_connection_failed, nullptr, nullptr);
+
+    const double per_die = static_cast<double>((k_connect_delay + k_subscribe_delay).count());
+    std::printf("%d dice, %.0f ms per die (connect %lld ms + subscribe %lld ms)\n", k_dice, per_die,
+                static_cast<long long>(k_connect_delay.count()), static_cast<long long>(k_subscribe_delay.count()));
+
+    double serial = 0;
+    for (const uint32_t limit : k_limits)
+    {
+        const double elapsed = time_to_all_connected(limit);
+        if (limit == 1)
+        {
+            serial = elapsed;
+        }
+        std::printf("max concurrent %-2u  all connected in %7.1f ms  (%.1fx vs 1)%s\n", limit, elapsed, serial / elapsed,
+                    g_failed.load() > 0 ? "  FAILURES" : "");
+    }
+
+    return 0;
+}
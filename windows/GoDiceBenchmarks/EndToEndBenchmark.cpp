@@ -0,0 +1,377 @@
+// EndToEndBenchmark.cpp
+//
+// Drives the public godice_* API against a synthetic transport: dice are
+// discovered and connected through the normal calls, then notifications are
+// pushed in from the transport side and timed until they reach the data
+// callback. Sweeps the number of dice and prints the results as JSON, to
+// stdout or to the file named by the first argument.
+//
+// Two latency figures are reported per sweep point: "latency_ns" sends one
+// packet at a time (the usual BLE case, where the callback thread is idle
+// between packets), "saturated_latency_ns" is measured during the throughput
+// run with up to k_max_in_flight packets queued.
+//
+// Every point runs twice, the second time with traffic capture writing to a
+// file in the temp directory, to show what capture adds per packet.
+// "capture_dropped" counts records the capture writer could not keep up with.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "../GoDiceDll/GoDiceDll.h"
+#include "../GoDiceDll/Transport.h"
+
+using std::chrono::steady_clock;
+
+static std::atomic<uint64_t> g_allocations = 0;
+
+static auto counted_malloc(size_t size) -> void*
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size > 0 ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size) { return counted_malloc(size); }
+void* operator new[](size_t size) { return counted_malloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+static constexpr int k_dice_counts[] = { 1, 10, 100, 500 };
+static constexpr int k_warmup_packets = 5000;
+static constexpr int k_paced_packets = 20000;
+static constexpr int k_saturated_packets = 200000;
+static constexpr uint64_t k_max_in_flight = 256;
+// Send times are looked up by sequence number; must exceed k_max_in_flight
+static constexpr uint32_t k_sent_window = 1 << 16;
+static constexpr uint64_t k_first_address = 0xBE0C00000000ull;
+
+static auto now_ns() -> uint64_t
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static auto process_cpu_seconds() -> double
+{
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    const auto ticks = [](const FILETIME& t) { return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime; };
+    return (ticks(kernel) + ticks(user)) * 100e-9;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+// Advertises every die as soon as discovery starts and completes every operation
+// immediately, so the numbers measure the framework rather than a radio.
+class SyntheticTransport final : public Transport
+{
+private:
+    const int dice_;
+    TransportListener* listener_ = nullptr;
+
+public:
+    explicit SyntheticTransport(int dice) : dice_(dice) {}
+
+    void set_listener(TransportListener* listener) override { listener_ = listener; }
+
+    void start_discovery() override
+    {
+        for (int i = 0; i < dice_; i++)
+        {
+            listener_->on_advertisement(k_first_address + i, "GoDice_BENCH_K_v04", -50);
+        }
+    }
+
+    void stop_discovery() override { listener_->on_discovery_stopped(); }
+
+    void connect(uint64_t, TransportCompletion completion) override { completion(true); }
+    void subscribe(uint64_t, TransportCompletion completion) override { completion(true); }
+    void write(uint64_t, const uint8_t*, uint32_t, WriteMode, TransportCompletion completion) override { completion(true); }
+    void disconnect(uint64_t, TransportCompletion completion) override { completion(true); }
+    void reset() override {}
+
+    // 'S' stable message; the vector bytes carry a 24-bit sequence number
+    void notify(int die, uint32_t sequence)
+    {
+        const uint8_t packet[] = {
+            'S',
+            static_cast<uint8_t>(sequence),
+            static_cast<uint8_t>(sequence >> 8),
+            static_cast<uint8_t>(sequence >> 16),
+        };
+        listener_->on_notification(k_first_address + die, packet, sizeof(packet));
+    }
+};
+
+static std::mutex g_found_mutex;
+static std::vector<std::string> g_found;
+static std::atomic<int> g_connected = 0;
+
+static uint64_t g_sent_ns[k_sent_window];
+static std::vector<uint64_t> g_latencies;
+static std::atomic<uint64_t> g_received = 0;
+
+static void device_found(const char* identifier, const char*)
+{
+    std::lock_guard lk(g_found_mutex);
+    g_found.emplace_back(identifier);
+}
+
+static void data_received(const char*, uint32_t data_size, uint8_t* data)
+{
+    if (data_size != 4) return;
+
+    const uint32_t sequence = data[1] | (data[2] << 8) | (data[3] << 16);
+    const uint64_t latency = now_ns() - g_sent_ns[sequence % k_sent_window];
+    if (g_latencies.size() < g_latencies.capacity())
+    {
+        g_latencies.push_back(latency);
+    }
+    g_received.fetch_add(1, std::memory_order_release);
+}
+
+static void device_connected(const char*) { g_connected.fetch_add(1); }
+static void device_connection_failed(const char* identifier) { std::fprintf(stderr, "connection to %s failed\n", identifier); }
+static void device_disconnected(const char*) {}
+static void listener_stopped() {}
+
+struct Percentiles
+{
+    uint64_t p50 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+};
+
+static auto percentiles(std::vector<uint64_t> samples) -> Percentiles
+{
+    if (samples.empty()) return {};
+
+    std::sort(samples.begin(), samples.end());
+    const auto at = [&](double q) { return samples[static_cast<size_t>(q * (samples.size() - 1))]; };
+    return { at(0.50), at(0.99), at(0.999) };
+}
+
+struct RunResult
+{
+    int dice = 0;
+    bool capture = false;
+    uint64_t capture_dropped = 0;
+    double packets_per_second = 0;
+    double allocations_per_packet = 0;
+    double cpu_ns_per_packet = 0;
+    Percentiles latency;
+    Percentiles saturated_latency;
+};
+
+static void wait_until(const std::atomic<uint64_t>& counter, uint64_t target)
+{
+    while (counter.load(std::memory_order_acquire) < target)
+    {
+        std::this_thread::yield();
+    }
+}
+
+// Sums the Dropped records (kind 8) the capture writer left in the file
+static auto read_capture_dropped(const std::string& path) -> uint64_t
+{
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) return 0;
+
+    uint64_t dropped = 0;
+    uint8_t header[24];
+    std::fseek(file, 32, SEEK_SET);
+    while (std::fread(header, 1, sizeof(header), file) == sizeof(header) && header[16] != 0)
+    {
+        const uint16_t size = header[20] | (header[21] << 8);
+        uint8_t payload[64] = {};
+        std::fread(payload, 1, (size + 7) & ~7, file);
+        if (header[16] == 8)
+        {
+            uint64_t lost = 0;
+            std::memcpy(&lost, payload, sizeof(lost));
+            dropped += lost;
+        }
+    }
+    std::fclose(file);
+    return dropped;
+}
+
+// Sends packets round-robin across the dice, keeping at most max_in_flight undelivered
+static void stream(SyntheticTransport& transport, int dice, int packets, uint64_t max_in_flight, uint32_t& sequence)
+{
+    const uint64_t first = g_received.load();
+    for (int i = 0; i < packets; i++)
+    {
+        while (first + i - g_received.load(std::memory_order_acquire) >= max_in_flight)
+        {
+            std::this_thread::yield();
+        }
+
+        const uint32_t seq = sequence++ & 0xFFFFFF;
+        g_sent_ns[seq % k_sent_window] = now_ns();
+        transport.notify(i % dice, seq);
+    }
+    wait_until(g_received, first + packets);
+}
+
+static auto run(int dice, const std::string& capture_path) -> RunResult
+{
+    {
+        std::lock_guard lk(g_found_mutex);
+        g_found.clear();
+    }
+    g_connected = 0;
+
+    auto owned = std::make_unique<SyntheticTransport>(dice);
+    SyntheticTransport& transport = *owned;
+    install_transport(std::move(owned));
+
+    godice_start_listening();
+    std::vector<std::string> identifiers;
+    while (identifiers.size() < static_cast<size_t>(dice))
+    {
+        std::this_thread::yield();
+        std::lock_guard lk(g_found_mutex);
+        identifiers = g_found;
+    }
+    for (const auto& identifier : identifiers)
+    {
+        godice_connect(identifier.c_str());
+    }
+    while (g_connected.load() < dice)
+    {
+        std::this_thread::yield();
+    }
+
+    RunResult result;
+    result.dice = dice;
+    result.capture = !capture_path.empty();
+    uint32_t sequence = 0;
+
+    if (result.capture)
+    {
+        GDCaptureConfig config{};
+        config.max_files = 1;
+        if (!godice_start_capture(capture_path.c_str(), &config))
+        {
+            std::fprintf(stderr, "could not start capture at %s\n", capture_path.c_str());
+        }
+    }
+
+    g_latencies.clear();
+    g_latencies.reserve(k_warmup_packets);
+    stream(transport, dice, k_warmup_packets, k_max_in_flight, sequence);
+
+    g_latencies.clear();
+    g_latencies.reserve(k_paced_packets);
+    stream(transport, dice, k_paced_packets, 1, sequence);
+    result.latency = percentiles(g_latencies);
+
+    g_latencies.clear();
+    g_latencies.reserve(k_saturated_packets);
+
+    const uint64_t allocations_before = g_allocations.load();
+    const double cpu_before = process_cpu_seconds();
+    const auto start = steady_clock::now();
+    stream(transport, dice, k_saturated_packets, k_max_in_flight, sequence);
+    const double elapsed = std::chrono::duration<double>(steady_clock::now() - start).count();
+    const double cpu = process_cpu_seconds() - cpu_before;
+    const uint64_t allocations = g_allocations.load() - allocations_before;
+
+    result.packets_per_second = k_saturated_packets / elapsed;
+    result.allocations_per_packet = static_cast<double>(allocations) / k_saturated_packets;
+    result.cpu_ns_per_packet = cpu * 1e9 / k_saturated_packets;
+    result.saturated_latency = percentiles(g_latencies);
+
+    if (result.capture)
+    {
+        godice_stop_capture();
+        result.capture_dropped = read_capture_dropped(capture_path);
+        std::filesystem::remove(capture_path);
+    }
+
+    godice_stop_listening();
+    return result;
+}
+
+static void print_percentiles(FILE* out, const char* name, const Percentiles& p)
+{
+    std::fprintf(out, "      \"%s\": { \"p50\": %llu, \"p99\": %llu, \"p999\": %llu }", name,
+                 static_cast<unsigned long long>(p.p50),
+                 static_cast<unsigned long long>(p.p99),
+                 static_cast<unsigned long long>(p.p999));
+}
+
+int main(int argc, char* argv[])
+{
+    FILE* out = stdout;
+    if (argc > 1 && (out = std::fopen(argv[1], "w")) == nullptr)
+    {
+        std::perror(argv[1]);
+        return 1;
+    }
+
+    godice_set_callbacks(device_found, data_received, device_connected, device_connection_failed, device_disconnected, listener_stopped);
+
+    const std::string capture_path = (std::filesystem::temp_directory_path() / "godice_end_to_end.capture").string();
+
+    std::vector<RunResult> results;
+    for (const int dice : k_dice_counts)
+    {
+        results.push_back(run(dice, {}));
+        results.push_back(run(dice, capture_path));
+    }
+
+    std::fprintf(out, "{\n  \"benchmark\": \"end_to_end\",\n  \"packets_per_run\": %d,\n  \"runs\": [\n", k_saturated_packets);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const RunResult& r = results[i];
+        std::fprintf(out, "    {\n");
+        std::fprintf(out, "      \"dice\": %d,\n", r.dice);
+        std::fprintf(out, "      \"capture\": %s,\n", r.capture ? "true" : "false");
+        if (r.capture)
+        {
+            std::fprintf(out, "      \"capture_dropped\": %llu,\n", static_cast<unsigned long long>(r.capture_dropped));
+        }
+        std::fprintf(out, "      \"packets_per_second\": %.0f,\n", r.packets_per_second);
+        std::fprintf(out, "      \"allocations_per_packet\": %.4f,\n", r.allocations_per_packet);
+        std::fprintf(out, "      \"cpu_ns_per_packet\": %.1f,\n", r.cpu_ns_per_packet);
+        print_percentiles(out, "latency_ns", r.latency);
+        std::fprintf(out, ",\n");
+        print_percentiles(out, "saturated_latency_ns", r.saturated_latency);
+        std::fprintf(out, "\n    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+
+    if (out != stdout)
+    {
+        std::fclose(out);
+    }
+    return 0;
+}
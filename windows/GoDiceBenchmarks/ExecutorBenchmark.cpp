@@ -0,0 +1,392 @@
+// ExecutorBenchmark.cpp
+//
+// Scaling of the work-stealing Executor across 1, 2, 4 and 8 threads: producers
+// spread synthetic work items (a fixed amount of arithmetic each) over 64 strands, as
+// if each strand were a die. Every strand must run its items in the order they were
+// enqueued, or the process exits non-zero.
+//
+// Then the case the strands are for: one die whose callback is slow. On a single
+// WorkQueue every other die's callbacks wait behind it; with a strand per die they
+// only wait for a free thread.
+//
+// Last, a discovery storm: device found callbacks arrive faster than one strand can run
+// them while a die sends rolls. Queued at one priority the rolls wait behind the whole
+// backlog; in the data lane they only wait for the callback already running. The other
+// way round, a flood of data must not starve discovery past its lane's deadline.
+//
+// And a host that stops taking callbacks for a while: a strand stuck in one task while
+// 100000 device found callbacks for 20 dice arrive from 4 producer threads, under each
+// GDOverflowPolicy and with coalescing. Blocking parks the producers for the whole
+// stall, so the process uses next to no CPU during it; the others keep the lane at its
+// capacity and the producers free. Racing producers must never queue past the
+// capacity, or the process exits non-zero.
+//
+// Scaling is bounded by the hardware threads printed first; pin with --affinity <mask>.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../GoDiceDll/Executor.h"
+#include "../GoDiceDll/WorkQueue.h"
+
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+
+static constexpr int k_strands = 64;
+static constexpr int k_producers = 4;
+static constexpr int k_items_per_producer = 100000;
+static constexpr int k_work_iterations = 500;
+
+static constexpr int k_dice = 16;
+static constexpr int k_rounds = 200;
+static constexpr auto k_slow_callback = std::chrono::microseconds(2000);
+
+static constexpr int k_stalled_items = 100000;
+static constexpr int k_stalled_dice = 20;
+static constexpr int k_stalled_producers = 4;
+static constexpr auto k_stall = std::chrono::milliseconds(200);
+
+static constexpr int k_ticks = 1000;
+static constexpr auto k_tick_interval = std::chrono::microseconds(500);
+
+static std::atomic<uint64_t> g_sink = 0;
+
+// Roughly a microsecond of work that the compiler cannot drop
+static void synthetic_work(uint64_t seed)
+{
+    uint64_t x = seed | 1;
+    for (int i = 0; i < k_work_iterations; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+    }
+    g_sink.fetch_add(x & 1, std::memory_order_relaxed);
+}
+
+struct alignas(64) StrandState
+{
+    std::unique_ptr<Strand> strand;
+    // Only touched by the strand's own items, which never run at once
+    uint64_t next = 0;
+    uint64_t errors = 0;
+};
+
+static auto scaling(uint32_t threads, uint64_t affinity_mask, double baseline) -> std::pair<bool, double>
+{
+    GDExecutorConfig config = Executor::default_config();
+    config.threads = threads;
+    config.affinity_mask = affinity_mask;
+
+    StrandStats stats;
+    std::atomic<int64_t> executed = 0;
+    const int64_t total = static_cast<int64_t>(k_producers) * k_items_per_producer;
+    std::vector<StrandState> strands(k_strands);
+    uint64_t steals = 0;
+
+    steady_clock::time_point start;
+    {
+        Executor executor(config, "Benchmark");
+        for (auto& state : strands)
+        {
+            state.strand = std::make_unique<Strand>("Strand", stats, Strand::k_default_capacity, &executor);
+        }
+
+        // Each producer owns a quarter of the strands, so each strand has one producer and a defined order
+        std::vector<std::thread> producers;
+        start = steady_clock::now();
+        for (int p = 0; p < k_producers; p++)
+        {
+            producers.emplace_back([&strands, &executed, p]
+            {
+                uint64_t sequences[k_strands / k_producers] = {};
+                for (int i = 0; i < k_items_per_producer; i++)
+                {
+                    const int slot = i % (k_strands / k_producers);
+                    StrandState& state = strands[p * (k_strands / k_producers) + slot];
+                    state.strand->enqueue([&state, &executed, sequence = sequences[slot]++]
+                    {
+                        synthetic_work(sequence);
+                        if (sequence != state.next)
+                        {
+                            state.errors++;
+                        }
+                        state.next = sequence + 1;
+                        executed.fetch_add(1, std::memory_order_relaxed);
+                    });
+                }
+            });
+        }
+        for (auto& t : producers)
+        {
+            t.join();
+        }
+        while (executed.load(std::memory_order_relaxed) < total)
+        {
+            std::this_thread::yield();
+        }
+        steals = executor.steals();
+    }
+    const double elapsed = std::chrono::duration<double>(steady_clock::now() - start).count();
+
+    uint64_t errors = 0;
+    for (const auto& state : strands)
+    {
+        errors += state.errors;
+    }
+    const double rate = total / elapsed;
+    std::printf("threads=%-2u %10.0f items/s  speedup %5.2fx  steals %8" PRIu64 "  out of order %" PRIu64 "\n",
+                threads, rate, baseline > 0 ? rate / baseline : 1.0, steals, errors);
+    return { errors == 0, rate };
+}
+
+// Every round each die gets one callback; die 0's takes k_slow_callback. Reports how long
+// the other dice's callbacks waited from enqueue until they ran.
+template <typename Enqueue>
+static void slow_callback(const char* label, Enqueue enqueue)
+{
+    std::vector<int64_t> samples;
+    samples.reserve(k_rounds * (k_dice - 1));
+    std::mutex samples_mutex;
+    std::atomic<int> done = 0;
+
+    for (int round = 0; round < k_rounds; round++)
+    {
+        for (int die = 0; die < k_dice; die++)
+        {
+            const auto enqueued = steady_clock::now();
+            enqueue(die, [&samples, &samples_mutex, &done, die, enqueued]
+            {
+                if (die == 0)
+                {
+                    std::this_thread::sleep_for(k_slow_callback);
+                }
+                else
+                {
+                    const auto waited = std::chrono::duration_cast<nanoseconds>(steady_clock::now() - enqueued).count();
+                    std::scoped_lock lk(samples_mutex);
+                    samples.push_back(waited);
+                }
+                done.fetch_add(1, std::memory_order_release);
+            });
+        }
+        // One round per slow callback, so the slow die alone keeps up
+        std::this_thread::sleep_for(k_slow_callback + std::chrono::microseconds(500));
+    }
+    while (done.load(std::memory_order_acquire) < k_rounds * k_dice)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) { return samples[static_cast<size_t>(p * (samples.size() - 1))] / 1000.0; };
+    std::printf("%-22s other dice wait  p50=%8.1fus  p99=%8.1fus  max=%8.1fus\n",
+                label, percentile(0.50), percentile(0.99), percentile(1.0));
+}
+
+// Floods one strand at `flood_priority` while queueing a tick at `tick_priority` every k_tick_interval
+static void storm(const char* label, WorkPriority flood_priority, WorkPriority tick_priority, uint64_t affinity_mask)
+{
+    GDExecutorConfig config = Executor::default_config();
+    config.threads = 2;
+    config.affinity_mask = affinity_mask;
+
+    StrandStats stats;
+    std::vector<int64_t> samples(k_ticks);
+    std::atomic<int> ticked = 0;
+    std::atomic<bool> storming = true;
+    std::atomic<int64_t> found = 0;
+    std::atomic<int64_t> queued = 0;
+    {
+        auto executor = std::make_unique<Executor>(config, "Benchmark");
+        Strand callbacks("Strand", stats, 1024, executor.get());
+
+        std::thread flood([&callbacks, &storming, &found, &queued, flood_priority]
+        {
+            for (uint64_t i = 0; storming.load(std::memory_order_relaxed); i++)
+            {
+                queued.fetch_add(1, std::memory_order_relaxed);
+                callbacks.enqueue([&found, i]
+                {
+                    synthetic_work(i);
+                    found.fetch_add(1, std::memory_order_relaxed);
+                }, flood_priority);
+            }
+        });
+
+        for (int i = 0; i < k_ticks; i++)
+        {
+            std::this_thread::sleep_for(k_tick_interval);
+            const auto enqueued = steady_clock::now();
+            callbacks.enqueue([&samples, &ticked, enqueued, i]
+            {
+                samples[i] = std::chrono::duration_cast<nanoseconds>(steady_clock::now() - enqueued).count();
+                ticked.fetch_add(1, std::memory_order_release);
+            }, tick_priority);
+        }
+        while (ticked.load(std::memory_order_acquire) < k_ticks)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        storming = false;
+        flood.join();
+        while (found.load(std::memory_order_relaxed) < queued.load(std::memory_order_relaxed))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        executor.reset();
+    }
+
+    GDQueueStats snapshot;
+    stats.snapshot(snapshot);
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) { return samples[static_cast<size_t>(p * (samples.size() - 1))] / 1000.0; };
+    std::printf("%-30s tick wait  p50=%8.1fus  p99=%8.1fus  max=%8.1fus  flood max wait %6.1fms  promoted %" PRIu64 "\n",
+                label, percentile(0.50), percentile(0.99), percentile(1.0),
+                snapshot.priority_wait[static_cast<size_t>(flood_priority)].max_ns / 1e6, snapshot.promoted);
+}
+
+static auto stalled_consumer(const char* label, const GDQueueConfig& queue_config, bool keyed, uint64_t affinity_mask) -> bool
+{
+    GDExecutorConfig config = Executor::default_config();
+    config.threads = 2;
+    config.affinity_mask = affinity_mask;
+
+    StrandStats stats;
+    std::atomic<int64_t> ran = 0;
+    double producer_ms = 0;
+    double stall_cpu_ms = 0;
+    uint64_t depth_at_end = 0;
+    {
+        auto executor = std::make_unique<Executor>(config, "Benchmark");
+        Strand strand("Strand", stats, 1024, executor.get());
+        strand.configure(WorkPriority::Discovery, queue_config);
+
+        std::atomic<bool> stalled = false;
+        std::atomic<bool> stall_over = false;
+        strand.enqueue([&stalled, &stall_over, &stall_cpu_ms]
+        {
+            const std::clock_t cpu_start = std::clock();
+            stalled = true;
+            std::this_thread::sleep_for(k_stall);
+            stall_cpu_ms = 1000.0 * static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+            stall_over = true;
+        });
+        while (!stalled.load())
+        {
+            std::this_thread::yield();
+        }
+
+        const auto start = steady_clock::now();
+        std::vector<std::thread> producers;
+        for (int p = 0; p < k_stalled_producers; p++)
+        {
+            producers.emplace_back([&, p]
+            {
+                for (int i = p; i < k_stalled_items; i += k_stalled_producers)
+                {
+                    auto item = [&ran, i] { synthetic_work(i); ran.fetch_add(1, std::memory_order_relaxed); };
+                    if (keyed)
+                    {
+                        strand.enqueue_latest(1 + i % k_stalled_dice, item, WorkPriority::Discovery);
+                    }
+                    else
+                    {
+                        strand.enqueue(item, WorkPriority::Discovery);
+                    }
+                }
+            });
+        }
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+        producer_ms = std::chrono::duration<double, std::milli>(steady_clock::now() - start).count();
+
+        // Not counting the stalled task itself, if it is still running
+        const bool still_stalled = !stall_over.load();
+        GDQueueStats snapshot;
+        stats.snapshot(snapshot);
+        depth_at_end = snapshot.depth - (still_stalled && snapshot.depth > 0 ? 1 : 0);
+        while (true)
+        {
+            stats.snapshot(snapshot);
+            if (snapshot.depth == 0) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        executor.reset();
+    }
+
+    GDQueueStats snapshot;
+    stats.snapshot(snapshot);
+    std::printf("%-30s producers %7.1fms  cpu in the stall %5.1fms  queued behind the stall %6" PRIu64 "  ran %6" PRId64 "  dropped %6" PRIu64 "  coalesced %6" PRIu64 "\n",
+                label, producer_ms, stall_cpu_ms, depth_at_end, ran.load(), snapshot.dropped, snapshot.coalesced);
+    return depth_at_end <= queue_config.capacity;
+}
+
+int main(int argc, char* argv[])
+{
+    uint64_t affinity_mask = 0;
+    if (argc == 3 && std::strcmp(argv[1], "--affinity") == 0)
+    {
+        affinity_mask = std::strtoull(argv[2], nullptr, 0);
+    }
+
+    const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("hardware threads: %u\n\n", hw);
+
+    bool ok = true;
+    double baseline = 0;
+    for (const uint32_t threads : { 1u, 2u, 4u, 8u })
+    {
+        const auto [ordered, rate] = scaling(threads, affinity_mask, baseline);
+        ok = ordered && ok;
+        if (baseline == 0)
+        {
+            baseline = rate;
+        }
+    }
+    std::printf("\n");
+
+    {
+        WorkQueue queue("Benchmark", WorkQueueBackend::LockFree);
+        slow_callback("one WorkQueue", [&queue](int, WorkItem&& item) { queue.enqueue(std::move(item)); });
+    }
+    {
+        GDExecutorConfig config = Executor::default_config();
+        config.threads = 4;
+        config.affinity_mask = affinity_mask;
+        StrandStats stats;
+        std::vector<std::unique_ptr<Strand>> strands;
+        Executor executor(config, "Benchmark");
+        for (int die = 0; die < k_dice; die++)
+        {
+            strands.push_back(std::make_unique<Strand>("Strand", stats, Strand::k_default_capacity, &executor));
+        }
+        slow_callback("a strand per die", [&strands](int die, WorkItem&& item) { strands[die]->enqueue(std::move(item)); });
+    }
+    std::printf("\n");
+
+    storm("rolls as discovery", WorkPriority::Discovery, WorkPriority::Discovery, affinity_mask);
+    storm("rolls in the data lane", WorkPriority::Discovery, WorkPriority::Data, affinity_mask);
+    storm("discovery under a data flood", WorkPriority::Data, WorkPriority::Discovery, affinity_mask);
+    std::printf("\n");
+
+    ok = stalled_consumer("block at 1024", { 1024, GD_OVERFLOW_BLOCK, false }, false, affinity_mask) && ok;
+    ok = stalled_consumer("drop oldest at 256", { 256, GD_OVERFLOW_DROP_OLDEST, false }, false, affinity_mask) && ok;
+    ok = stalled_consumer("drop newest at 256", { 256, GD_OVERFLOW_DROP_NEWEST, false }, false, affinity_mask) && ok;
+    ok = stalled_consumer("coalesce per die, block", { 1024, GD_OVERFLOW_BLOCK, true }, true, affinity_mask) && ok;
+
+    return ok ? 0 : 1;
+}
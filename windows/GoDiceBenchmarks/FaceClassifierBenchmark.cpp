@@ -0,0 +1,94 @@
+// FaceClassifierBenchmark.cpp
+//
+// Measures vectors/second for each face classifier kernel on noisy stable
+// vectors, and checks that the SIMD kernels agree with the scalar one.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../GoDiceDll/FaceClassifier.h"
+
+using godice::faces::Isa;
+
+static constexpr uint32_t k_batch_size = 64;     // roughly one table of dice per frame
+static constexpr int k_iterations = 200000;
+
+static auto isa_name(Isa isa) -> const char*
+{
+    switch (isa)
+    {
+    case Isa::Avx2:
+        return "avx2";
+    case Isa::Sse:
+        return "sse";
+    default:
+        return "scalar";
+    }
+}
+
+static auto noisy_vectors(uint32_t die_type, size_t count) -> std::vector<GDVector>
+{
+    const auto& table = *godice::faces::table_for(die_type);
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<uint32_t> pick(0, table.count - 1);
+    std::normal_distribution<float> noise(0.0f, 6.0f);
+
+    std::vector<GDVector> vectors(count);
+    for (auto& v : vectors)
+    {
+        const uint32_t f = pick(rng);
+        v.x = static_cast<int8_t>(table.x[f] * 64 + noise(rng));
+        v.y = static_cast<int8_t>(table.y[f] * 64 + noise(rng));
+        v.z = static_cast<int8_t>(table.z[f] * 64 + noise(rng));
+    }
+    return vectors;
+}
+
+int main()
+{
+    std::vector<Isa> isas = { Isa::Scalar };
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    isas.push_back(Isa::Sse);
+    if (godice::faces::best_isa() == Isa::Avx2)
+    {
+        isas.push_back(Isa::Avx2);
+    }
+#endif
+
+    int mismatches = 0;
+    for (uint32_t die_type : { GD_DIE_D6, GD_DIE_D20 })
+    {
+        const auto& table = *godice::faces::table_for(die_type);
+        const auto vectors = noisy_vectors(die_type, k_batch_size);
+
+        std::vector<uint8_t> reference(k_batch_size);
+        godice::faces::classify_batch(table, vectors.data(), k_batch_size, reference.data(), Isa::Scalar);
+
+        for (Isa isa : isas)
+        {
+            std::vector<uint8_t> faces(k_batch_size);
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < k_iterations; i++)
+            {
+                godice::faces::classify_batch(table, vectors.data(), k_batch_size, faces.data(), isa);
+            }
+            const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (faces != reference)
+            {
+                mismatches++;
+            }
+
+            std::printf("d%-2u %-7s %14.0f vectors/s\n", table.count, isa_name(isa),
+                        static_cast<double>(k_batch_size) * k_iterations / elapsed);
+        }
+    }
+
+    if (mismatches > 0)
+    {
+        std::printf("%d kernel(s) disagreed with the scalar classifier\n", mismatches);
+    }
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,187 @@
+// LogBenchmark.cpp
+//
+// Measures what a log call costs the thread that makes it: filtered out at runtime,
+// enabled with a fast logger, and enabled with a logger as slow as a console write,
+// next to formatting on the calling thread the way logging used to. The message is
+// the per-write debug line the WinRT transport logs for every godice_send.
+//
+// Unpaced runs log far faster than any logger keeps up with, so most of those
+// messages are dropped; the paced run logs at a busy table's write rate and should
+// lose none.
+//
+// Warnings are never dropped, so one run mixes a failed write into every hundred
+// and checks each one arrives.
+//
+// Every message that reaches the logger is checked for arrival in order and for
+// correct formatting, and together with the reported drops they must account for
+// every call; the process exits non-zero otherwise.
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "../GoDiceDll/Log.h"
+
+static constexpr int k_calls = 200000;
+static constexpr int k_paced_calls = 20000;
+static const std::string k_die_name = "GoDice_E1_K_v04";
+
+static std::atomic<uint64_t> g_messages = 0;
+static std::atomic<uint64_t> g_dropped = 0;
+static std::atomic<uint64_t> g_warnings = 0;
+static std::atomic<uint64_t> g_errors = 0;
+static std::atomic<int> g_logger_delay_us = 0;
+static int64_t g_last_sequence = -1;
+
+static constexpr int k_warning_interval = 100;
+
+static void spin_for(std::chrono::nanoseconds duration)
+{
+    const auto until = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < until)
+    {
+    }
+}
+
+static void check_line(const char* line)
+{
+    uint64_t dropped = 0;
+    if (std::sscanf(line, "[log] %" SCNu64 " messages dropped", &dropped) == 1)
+    {
+        g_dropped.fetch_add(dropped, std::memory_order_relaxed);
+        return;
+    }
+
+    int64_t sequence = 0;
+    char name[32] = {};
+    if (std::sscanf(line, "[%31[^]]] Write %" SCNd64 " failed", name, &sequence) == 2)
+    {
+        if (k_die_name != name || sequence % k_warning_interval != 0)
+        {
+            g_errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        g_warnings.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (std::sscanf(line, "[%31[^]]] Attempting to write %" SCNd64 " bytes", name, &sequence) != 2 ||
+        k_die_name != name || sequence <= g_last_sequence)
+    {
+        g_errors.fetch_add(1, std::memory_order_relaxed);
+    }
+    g_last_sequence = sequence;
+    g_messages.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void logger(const char* line)
+{
+    check_line(line);
+    if (const int delay = g_logger_delay_us.load(std::memory_order_relaxed))
+    {
+        spin_for(std::chrono::microseconds(delay));
+    }
+}
+
+// How the transport used to log: format on the calling thread, then call the logger there
+static void format_on_caller(int64_t sequence)
+{
+    char line[128];
+    std::snprintf(line, sizeof(line), "[%s] Attempting to write %" PRId64 " bytes\n", k_die_name.c_str(), sequence);
+    logger(line);
+}
+
+template <typename F>
+static auto ns_per_call(F&& call, int calls = k_calls) -> double
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; i++)
+    {
+        call(i);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / calls;
+}
+
+static auto run_async(const char* label, int delay_us, std::chrono::nanoseconds interval = {}, bool warnings = false) -> bool
+{
+    g_logger_delay_us = delay_us;
+    godice::flush_log();
+    g_last_sequence = -1;
+    const uint64_t messages = g_messages.load();
+    const uint64_t dropped = g_dropped.load();
+    const uint64_t warned = g_warnings.load();
+
+    const bool paced = interval != std::chrono::nanoseconds{};
+    const int calls = paced ? k_paced_calls : k_calls;
+    const double ns = ns_per_call([interval, warnings](int i)
+    {
+        if (warnings && i % k_warning_interval == 0)
+        {
+            godice::log_tagged<godice::LogLevel::Warning>(k_die_name, "Write {} failed\n", i);
+        }
+        else
+        {
+            godice::log_tagged<godice::LogLevel::Debug>(k_die_name, "Attempting to write {} bytes\n", i);
+        }
+        spin_for(interval);
+    }, calls);
+    const int warning_calls = warnings ? (calls + k_warning_interval - 1) / k_warning_interval : 0;
+    godice::flush_log();
+
+    // A drop report can trail the last message by a moment
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (g_messages.load() - messages + g_dropped.load() - dropped + g_warnings.load() - warned < static_cast<uint64_t>(calls) &&
+           std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::yield();
+    }
+
+    const uint64_t delivered = g_messages.load() - messages;
+    const uint64_t lost = g_dropped.load() - dropped;
+    const uint64_t warnings_delivered = g_warnings.load() - warned;
+    if (paced)
+    {
+        std::printf("%-28s %19s %" PRIu64 " delivered, %" PRIu64 " dropped\n", label, "", delivered, lost);
+    }
+    else
+    {
+        std::printf("%-28s %8.1f ns/call, %" PRIu64 " delivered, %" PRIu64 " dropped", label, ns, delivered, lost);
+        if (warnings)
+        {
+            std::printf(", %" PRIu64 " of %d warnings", warnings_delivered, warning_calls);
+        }
+        std::printf("\n");
+    }
+    return delivered + lost + warnings_delivered == static_cast<uint64_t>(calls) &&
+           warnings_delivered == static_cast<uint64_t>(warning_calls) && (!paced || lost == 0);
+}
+
+int main()
+{
+    godice::set_logger(logger);
+
+    godice::set_log_level(GD_LOG_INFO);
+    const double filtered = ns_per_call([](int i)
+    {
+        godice::log_tagged<godice::LogLevel::Debug>(k_die_name, "Attempting to write {} bytes\n", i);
+    });
+    std::printf("%-28s %8.1f ns/call\n", "filtered out", filtered);
+
+    godice::set_log_level(GD_LOG_DEBUG);
+    g_last_sequence = -1;
+    const double sync = ns_per_call(format_on_caller);
+    std::printf("%-28s %8.1f ns/call\n", "formatted on caller", sync);
+
+    bool ok = run_async("async, fast logger", 0);
+    ok = run_async("async, 20us logger", 20) && ok;
+    ok = run_async("async, 20us logger, warnings", 20, {}, true) && ok;
+    ok = run_async("async, 20us logger, paced", 20, std::chrono::microseconds(50)) && ok;
+
+    godice::set_logger(nullptr);
+    std::printf("format errors:               %" PRIu64 "\n", g_errors.load());
+    return ok && g_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,339 @@
+// PollBenchmark.cpp
+//
+// Compares the two ways a game can take dice events on its main thread. With
+// callbacks, the framework hops each packet onto its callback thread and the host
+// hops it again into a locked list that the main thread swaps out once per frame,
+// which is what a Unity script has to do. With godice_poll_events, the main thread
+// drains the framework's queue straight into an array once per frame. A host with its
+// own event loop instead sleeps on godice_get_wait_handle and drains when it fires.
+//
+// A synthetic transport streams packets from a producer thread while the "main
+// thread" runs 1 ms frames, or wakes on the handle. Reports throughput, CPU per
+// packet and the number of frames or wakeups. Every packet must arrive once and in order, or the process exits non-zero.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <poll.h>
+#include <sys/resource.h>
+#endif
+
+#include "../GoDiceDll/GoDiceDll.h"
+#include "../GoDiceDll/Transport.h"
+
+using std::chrono::steady_clock;
+
+static constexpr int k_dice = 20;
+static constexpr int k_packets = 200000;
+static constexpr uint32_t k_poll_capacity = 4096;
+// Stays below k_poll_capacity, so a full queue never drops anything
+static constexpr uint64_t k_max_in_flight = 2048;
+static constexpr auto k_frame = std::chrono::milliseconds(1);
+// Sent in a burst every millisecond, so CPU time goes on delivery rather than on a producer spinning
+static constexpr int k_packets_per_burst = 250;
+static constexpr uint64_t k_first_address = 0xB011E0000000ull;
+
+static auto process_cpu_seconds() -> double
+{
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    const auto ticks = [](const FILETIME& t) { return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime; };
+    return (ticks(kernel) + ticks(user)) * 100e-9;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+// Advertises every die when discovery starts and completes every operation at once
+class SyntheticTransport final : public Transport
+{
+private:
+    TransportListener* listener_ = nullptr;
+
+public:
+    void set_listener(TransportListener* listener) override { listener_ = listener; }
+
+    void start_discovery() override
+    {
+        for (int i = 0; i < k_dice; i++)
+        {
+            listener_->on_advertisement(k_first_address + i, "GoDice_POLL_K_v04", -50);
+        }
+    }
+
+    void stop_discovery() override { listener_->on_discovery_stopped(); }
+
+    void connect(uint64_t, TransportCompletion completion) override { completion(true); }
+    void subscribe(uint64_t, TransportCompletion completion) override { completion(true); }
+    void write(uint64_t, const uint8_t*, uint32_t, WriteMode, TransportCompletion completion) override { completion(true); }
+    void disconnect(uint64_t, TransportCompletion completion) override { completion(true); }
+    void reset() override {}
+
+    // 'S' stable message; the vector bytes carry the die's own 24-bit sequence number
+    void notify(int die, uint32_t sequence)
+    {
+        const uint8_t packet[] = {
+            'S',
+            static_cast<uint8_t>(sequence),
+            static_cast<uint8_t>(sequence >> 8),
+            static_cast<uint8_t>(sequence >> 16),
+        };
+        listener_->on_notification(k_first_address + die, packet, sizeof(packet));
+    }
+};
+
+// What the main thread keeps per die
+struct DieState
+{
+    uint32_t next_sequence = 0;
+};
+
+static std::atomic<uint64_t> g_processed = 0;
+static std::atomic<uint64_t> g_errors = 0;
+static std::atomic<int> g_connected = 0;
+static std::atomic<bool> g_stopped = false;
+static DieState g_dice[k_dice];
+
+// Main thread only
+static void process(uint64_t address, const uint8_t* data, uint32_t size)
+{
+    const uint64_t die = address - k_first_address;
+    if (die >= k_dice || size != 4)
+    {
+        g_errors++;
+        return;
+    }
+
+    const uint32_t sequence = data[1] | (data[2] << 8) | (data[3] << 16);
+    if (sequence != g_dice[die].next_sequence)
+    {
+        g_errors++;
+    }
+    g_dice[die].next_sequence = sequence + 1;
+    g_processed.fetch_add(1, std::memory_order_release);
+}
+
+// The hop a callback-driven host needs to get packets onto its main thread
+struct HostQueue
+{
+    struct Packet
+    {
+        uint64_t address;
+        uint8_t data[4];
+    };
+
+    std::mutex mutex;
+    std::vector<Packet> pending;
+};
+
+static HostQueue g_host_queue;
+
+static void device_found(const char* identifier, const char*) { godice_connect(identifier); }
+static void device_connected(const char*) { g_connected++; }
+static void listener_stopped() { g_stopped = true; }
+
+static void data_received(const char* identifier, uint32_t data_size, uint8_t* data)
+{
+    HostQueue::Packet packet{ std::strtoull(identifier, nullptr, 10), {} };
+    std::memcpy(packet.data, data, std::min<uint32_t>(data_size, sizeof(packet.data)));
+    std::lock_guard lk(g_host_queue.mutex);
+    g_host_queue.pending.push_back(packet);
+}
+
+static void run_frame_callbacks(std::vector<HostQueue::Packet>& frame)
+{
+    frame.clear();
+    {
+        std::lock_guard lk(g_host_queue.mutex);
+        frame.swap(g_host_queue.pending);
+    }
+    for (const auto& packet : frame)
+    {
+        process(packet.address, packet.data, sizeof(packet.data));
+    }
+}
+
+static void run_frame_polling(std::vector<GDPollEvent>& frame)
+{
+    uint32_t count;
+    while ((count = godice_poll_events(frame.data(), static_cast<uint32_t>(frame.size()))) > 0)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const GDPollEvent& event = frame[i];
+            if (event.type == GD_POLL_DATA)
+            {
+                process(event.device, event.data, event.data_size);
+            }
+            else if (event.type == GD_POLL_DEVICE_FOUND)
+            {
+                godice_connect(std::to_string(event.device).c_str());
+            }
+            else if (event.type == GD_POLL_CONNECTED)
+            {
+                g_connected++;
+            }
+            else if (event.type == GD_POLL_LISTENER_STOPPED)
+            {
+                g_stopped = true;
+            }
+        }
+    }
+}
+
+enum class Mode
+{
+    Callbacks,
+    Polling,
+    WaitHandle,
+};
+
+// Sleeps until there are events to poll, or at most one frame
+static void wait_for_events(intptr_t handle)
+{
+#if defined(_WIN32)
+    WaitForSingleObject(reinterpret_cast<HANDLE>(handle), 1);
+#else
+    pollfd fd{ static_cast<int>(handle), POLLIN, 0 };
+    poll(&fd, 1, 1);
+#endif
+}
+
+static auto run(Mode mode) -> bool
+{
+    const bool polling = mode != Mode::Callbacks;
+    const char* label = mode == Mode::Callbacks ? "callbacks" : mode == Mode::Polling ? "polling" : "wait handle";
+    for (auto& die : g_dice)
+    {
+        die = DieState{};
+    }
+    g_processed = 0;
+    g_connected = 0;
+    g_stopped = false;
+
+    godice_enable_polling(polling ? k_poll_capacity : 0);
+    godice_set_callbacks(device_found, data_received, device_connected, nullptr, nullptr, listener_stopped);
+
+    auto owned = std::make_unique<SyntheticTransport>();
+    SyntheticTransport& transport = *owned;
+    install_transport(std::move(owned));
+
+    std::atomic<bool> producing = true;
+    std::vector<HostQueue::Packet> callback_frame;
+    std::vector<GDPollEvent> poll_frame(256);
+    const intptr_t handle = godice_get_wait_handle();
+    if (mode == Mode::WaitHandle && handle == -1)
+    {
+        std::printf("no wait handle\n");
+        return false;
+    }
+
+    const auto frame = [&]
+    {
+        if (mode == Mode::WaitHandle)
+        {
+            wait_for_events(handle);
+            run_frame_polling(poll_frame);
+        }
+        else if (polling)
+        {
+            run_frame_polling(poll_frame);
+        }
+        else
+        {
+            run_frame_callbacks(callback_frame);
+        }
+    };
+
+    godice_start_listening();
+    while (g_connected.load() < k_dice)
+    {
+        frame();
+        std::this_thread::sleep_for(k_frame);
+    }
+
+    const double cpu_before = process_cpu_seconds();
+    const auto start = steady_clock::now();
+    std::thread producer([&]
+    {
+        uint32_t sequences[k_dice] = {};
+        auto next_burst = steady_clock::now();
+        for (int i = 0; i < k_packets; i++)
+        {
+            if (i % k_packets_per_burst == 0)
+            {
+                next_burst += std::chrono::milliseconds(1);
+                std::this_thread::sleep_until(next_burst);
+            }
+            while (i - g_processed.load(std::memory_order_acquire) >= k_max_in_flight)
+            {
+                std::this_thread::yield();
+            }
+            const int die = i % k_dice;
+            transport.notify(die, sequences[die]++);
+        }
+        producing = false;
+    });
+
+    uint64_t frames = 0;
+    while (producing || g_processed.load() < k_packets)
+    {
+        const auto next_frame = steady_clock::now() + k_frame;
+        frame();
+        frames++;
+        if (mode != Mode::WaitHandle)
+        {
+            std::this_thread::sleep_until(next_frame);
+        }
+    }
+    producer.join();
+
+    const double elapsed = std::chrono::duration<double>(steady_clock::now() - start).count();
+    const double cpu = process_cpu_seconds() - cpu_before;
+
+    GDStats stats;
+    godice_get_stats(&stats);
+    std::printf("%-11s %10.0f packets/s, %7.0f cpu ns/packet, %6llu frames, %llu dropped\n",
+                label, k_packets / elapsed, cpu * 1e9 / k_packets,
+                static_cast<unsigned long long>(frames), static_cast<unsigned long long>(stats.poll_events_dropped));
+
+    godice_stop_listening();
+    while (!g_stopped)
+    {
+        frame();
+        if (mode != Mode::WaitHandle)
+        {
+            std::this_thread::sleep_for(k_frame);
+        }
+    }
+    return g_processed.load() == k_packets && stats.poll_events_dropped == 0;
+}
+
+int main()
+{
+    bool ok = true;
+    for (int i = 0; i < 2; i++)
+    {
+        ok = run(Mode::Callbacks) && ok;
+        ok = run(Mode::Polling) && ok;
+        ok = run(Mode::WaitHandle) && ok;
+    }
+
+    std::printf("ordering errors: %llu\n", static_cast<unsigned long long>(g_errors.load()));
+    return ok && g_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,205 @@
+// ReplayBenchmark.cpp
+//
+// Records a busy table of simulated dice with traffic capture, then plays the
+// capture back through godice_use_replay_transport: at the captured pace, ten
+// times faster, and as fast as the framework will take it. Each replay reports
+// its wall time and how many data callbacks per second reached the client, and
+// a hash of every (identifier, packet) in delivery order, which must be the
+// same for every speed.
+//
+// Then floods a replayed die with godice_send from the host. The replay transport
+// completes writes inline, on the Bluetooth strand, so each completion queues more
+// Bluetooth work from inside the strand while the host keeps it full. The flood must
+// drain within k_flood_timeout, or the process exits non-zero.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+#include "../GoDiceDll/GoDiceDll.h"
+
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+static constexpr uint32_t k_dice = 60;
+static constexpr float k_rolls_per_second = 2.0f;
+static constexpr milliseconds k_capture_time(4000);
+static constexpr float k_speeds[] = { 1.0f, 10.0f, 0.0f };
+static constexpr uint32_t k_fast_repeats = 100;
+static constexpr uint32_t k_flood_sends = 200000;
+static constexpr std::chrono::seconds k_flood_timeout(60);
+
+static std::atomic<uint64_t> g_packets = 0;
+static std::atomic<bool> g_stopped = false;
+// The first die to connect, as its identifier; set once
+static std::atomic<bool> g_has_connected = false;
+static char g_connected[32];
+// Only touched by the callback thread, which runs callbacks one at a time
+static uint64_t g_hash = 0;
+
+static void mix(const void* data, size_t size)
+{
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        g_hash = (g_hash ^ bytes[i]) * 0x100000001B3ull;
+    }
+}
+
+static void device_found(const char* identifier, const char*) { godice_connect(identifier); }
+
+static void data_received(const char* identifier, uint32_t size, uint8_t* data)
+{
+    mix(identifier, std::strlen(identifier));
+    mix(data, size);
+    g_packets.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void device_connected(const char* identifier)
+{
+    if (g_has_connected.load(std::memory_order_acquire)) return;
+
+    std::snprintf(g_connected, sizeof(g_connected), "%s", identifier);
+    g_has_connected.store(true, std::memory_order_release);
+}
+
+static void listener_stopped() { g_stopped = true; }
+
+static void wait_until_stopped()
+{
+    while (!g_stopped)
+    {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    g_stopped = false;
+}
+
+static void record(const std::string& path)
+{
+    GDSimulationConfig config{};
+    config.dice_count = k_dice;
+    config.rolls_per_second = k_rolls_per_second;
+    config.advertisements_per_second = 4.0f;
+    config.jitter_us = 2000;
+    config.connect_latency_ms = 50;
+    config.seed = 7;
+    godice_use_simulated_transport(&config);
+
+    GDCaptureConfig capture{};
+    capture.max_files = 1;
+    godice_start_capture(path.c_str(), &capture);
+
+    godice_start_listening();
+    std::this_thread::sleep_for(k_capture_time);
+    godice_stop_listening();
+    wait_until_stopped();
+    godice_stop_capture();
+
+    std::printf("captured %u dice rolling %.0f times a second for %.1f s\n", k_dice, static_cast<double>(k_rolls_per_second),
+                std::chrono::duration<double>(k_capture_time).count());
+}
+
+static void replay(const std::string& path, float speed, uint32_t repeats)
+{
+    GDReplayConfig config{};
+    config.speed = speed;
+    config.repeat_count = repeats;
+    if (!godice_use_replay_transport(path.c_str(), &config))
+    {
+        std::printf("could not open %s\n", path.c_str());
+        return;
+    }
+
+    g_packets = 0;
+    g_hash = 0xCBF29CE484222325ull;
+    const auto start = steady_clock::now();
+    godice_start_listening();
+    wait_until_stopped();
+    const double seconds = std::chrono::duration<double>(steady_clock::now() - start).count();
+
+    char label[32];
+    std::snprintf(label, sizeof(label), speed > 0.0f ? "%.0fx" : "unpaced", static_cast<double>(speed));
+    std::printf("%-8s x%-3u %8.3f s  %9llu packets  %11.0f packets/s  hash %016llx\n", label, repeats, seconds,
+                static_cast<unsigned long long>(g_packets.load()), static_cast<double>(g_packets.load()) / seconds,
+                static_cast<unsigned long long>(g_hash));
+}
+
+static auto bluetooth_depth() -> uint64_t
+{
+    GDStats stats;
+    godice_get_stats(&stats);
+    return stats.bluetooth_queue.depth;
+}
+
+static auto flood(const std::string& path) -> bool
+{
+    GDReplayConfig config{};
+    config.speed = 0.0f;
+    config.repeat_count = k_fast_repeats;
+    if (!godice_use_replay_transport(path.c_str(), &config))
+    {
+        std::printf("could not open %s\n", path.c_str());
+        return false;
+    }
+
+    g_has_connected = false;
+    godice_start_listening();
+    while (!g_has_connected.load(std::memory_order_acquire))
+    {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+
+    std::atomic<bool> sent = false;
+    const auto start = steady_clock::now();
+    std::thread host([&sent]
+    {
+        uint8_t command = 0;
+        for (uint32_t i = 0; i < k_flood_sends; i++)
+        {
+            command = static_cast<uint8_t>(i);
+            godice_send(g_connected, sizeof(command), &command);
+        }
+        sent = true;
+    });
+
+    while (!sent.load() || bluetooth_depth() > 0)
+    {
+        if (steady_clock::now() - start > k_flood_timeout)
+        {
+            // The stuck threads cannot be joined, so leave without tearing anything down
+            std::printf("flood    stalled with %llu Bluetooth tasks queued\n", static_cast<unsigned long long>(bluetooth_depth()));
+            std::fflush(stdout);
+            std::_Exit(1);
+        }
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    host.join();
+    const double seconds = std::chrono::duration<double>(steady_clock::now() - start).count();
+    std::printf("flood    %u sends from the host drained in %.3f s, %.0f sends/s\n", k_flood_sends, seconds, k_flood_sends / seconds);
+
+    wait_until_stopped();
+    return true;
+}
+
+int main()
+{
+    godice_set_callbacks(device_found, data_received, device_connected, nullptr, nullptr, listener_stopped);
+
+    const std::string path = (std::filesystem::temp_directory_path() / "godice_replay.capture").string();
+    record(path);
+
+    for (const float speed : k_speeds)
+    {
+        replay(path, speed, 1);
+    }
+    replay(path, 0.0f, k_fast_repeats);
+    const bool ok = flood(path);
+
+    std::filesystem::remove(path);
+    return ok ? 0 : 1;
+}
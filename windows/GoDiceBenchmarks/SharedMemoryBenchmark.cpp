@@ -0,0 +1,301 @@
+// SharedMemoryBenchmark.cpp
+//
+// Runs a daemon that owns 20 synthetic dice and publishes them with
+// godice_start_publishing, and fans them out to 1, 2, 4 and 8 reader processes that
+// each take them through godice_use_shared_transport and godice_poll_events. The
+// benchmark launches copies of itself as the readers.
+//
+// Reports the daemon's CPU per packet, which grows with the number of readers only by
+// the wake-ups of those that are asleep, and the busiest reader's. Every reader must
+// receive every packet once and in order, with nothing lost from the shared ring or
+// dropped from its own poll queue, or the process exits non-zero.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#define popen _popen
+#define pclose _pclose
+#else
+#include <poll.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include "../GoDiceDll/GoDiceDll.h"
+#include "../GoDiceDll/SharedRing.h"
+#include "../GoDiceDll/Transport.h"
+
+using std::chrono::steady_clock;
+
+static constexpr int k_dice = 20;
+static constexpr int k_packets = 200000;
+static constexpr int k_packets_per_burst = 250;
+// A quarter of a second of packets, so readers sharing a few cores with the daemon are not lapped
+static constexpr uint32_t k_ring_capacity = 1 << 16;
+static constexpr uint64_t k_first_address = 0xB011E0000000ull;
+static constexpr auto k_reader_timeout = std::chrono::seconds(10);
+
+static auto process_cpu_seconds() -> double
+{
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    const auto ticks = [](const FILETIME& t) { return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime; };
+    return (ticks(kernel) + ticks(user)) * 100e-9;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+static auto process_id() -> unsigned long
+{
+#if defined(_WIN32)
+    return GetCurrentProcessId();
+#else
+    return static_cast<unsigned long>(getpid());
+#endif
+}
+
+// Sleeps until there are events to poll, or at most `timeout_ms`
+static void wait_for_events(intptr_t handle, int timeout_ms)
+{
+#if defined(_WIN32)
+    WaitForSingleObject(reinterpret_cast<HANDLE>(handle), timeout_ms);
+#else
+    pollfd fd{ static_cast<int>(handle), POLLIN, 0 };
+    poll(&fd, 1, timeout_ms);
+#endif
+}
+
+// Advertises every die when discovery starts and completes every operation at once
+class SyntheticTransport final : public Transport
+{
+private:
+    TransportListener* listener_ = nullptr;
+
+public:
+    void set_listener(TransportListener* listener) override { listener_ = listener; }
+
+    void start_discovery() override
+    {
+        for (int i = 0; i < k_dice; i++)
+        {
+            listener_->on_advertisement(k_first_address + i, "GoDice_SHM_K_v04", -50);
+        }
+    }
+
+    void stop_discovery() override { listener_->on_discovery_stopped(); }
+
+    void connect(uint64_t, TransportCompletion completion) override { completion(true); }
+    void subscribe(uint64_t, TransportCompletion completion) override { completion(true); }
+    void write(uint64_t, const uint8_t*, uint32_t, WriteMode, TransportCompletion completion) override { completion(true); }
+    void disconnect(uint64_t, TransportCompletion completion) override { completion(true); }
+    void reset() override {}
+
+    // 'S' stable message; the vector bytes carry the die's own 24-bit sequence number
+    void notify(int die, uint32_t sequence)
+    {
+        const uint8_t packet[] = {
+            'S',
+            static_cast<uint8_t>(sequence),
+            static_cast<uint8_t>(sequence >> 8),
+            static_cast<uint8_t>(sequence >> 16),
+        };
+        listener_->on_notification(k_first_address + die, packet, sizeof(packet));
+    }
+};
+
+// Prints "ready" once it holds every die, then "<received> <lost> <dropped> <errors> <cpu ns/packet>"
+static auto run_reader(const char* name) -> int
+{
+    if (!godice_use_shared_transport(name))
+    {
+        std::printf("failed\n");
+        return 1;
+    }
+    // As deep as the shared ring, so a reader descheduled for as long as the ring holds
+    // loses nothing from its poll queue either
+    godice_enable_polling(k_ring_capacity);
+    const intptr_t handle = godice_get_wait_handle();
+    godice_start_listening();
+
+    uint32_t next_sequence[k_dice] = {};
+    uint64_t received = 0;
+    uint64_t errors = 0;
+    int connected = 0;
+    double cpu_before = 0;
+    std::vector<GDPollEvent> events(256);
+    auto last_progress = steady_clock::now();
+
+    while (received < k_packets && steady_clock::now() - last_progress < k_reader_timeout)
+    {
+        wait_for_events(handle, 100);
+        uint32_t count;
+        while ((count = godice_poll_events(events.data(), static_cast<uint32_t>(events.size()))) > 0)
+        {
+            last_progress = steady_clock::now();
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const GDPollEvent& event = events[i];
+                if (event.type == GD_POLL_DEVICE_FOUND)
+                {
+                    godice_connect(std::to_string(event.device).c_str());
+                }
+                else if (event.type == GD_POLL_CONNECTED && ++connected == k_dice)
+                {
+                    cpu_before = process_cpu_seconds();
+                    std::printf("ready\n");
+                    std::fflush(stdout);
+                }
+                else if (event.type == GD_POLL_DATA)
+                {
+                    const uint64_t die = event.device - k_first_address;
+                    const uint32_t sequence = event.data[1] | (event.data[2] << 8) | (event.data[3] << 16);
+                    if (die >= k_dice)
+                    {
+                        errors++;
+                        continue;
+                    }
+                    if (sequence != next_sequence[die])
+                    {
+                        errors++;
+                    }
+                    next_sequence[die] = sequence + 1;
+                    received++;
+                }
+            }
+        }
+    }
+
+    GDStats stats;
+    godice_get_stats(&stats);
+    const double cpu = process_cpu_seconds() - cpu_before;
+    std::printf("%" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64 " %.0f\n", received, stats.shared_lost, stats.poll_events_dropped, errors,
+                cpu * 1e9 / k_packets);
+    return 0;
+}
+
+static std::atomic<int> g_connected = 0;
+
+static void device_found(const char* identifier, const char*) { godice_connect(identifier); }
+static void device_connected(const char*) { g_connected++; }
+
+static auto run(const std::string& self, const std::string& name, SyntheticTransport& transport, int readers) -> bool
+{
+    std::vector<FILE*> pipes;
+    for (int i = 0; i < readers; i++)
+    {
+        const std::string command = "\"" + self + "\" --reader " + name;
+        FILE* pipe = popen(command.c_str(), "r");
+        if (pipe == nullptr)
+        {
+            std::printf("could not start a reader\n");
+            return false;
+        }
+        pipes.push_back(pipe);
+    }
+
+    char line[128];
+    for (FILE* pipe : pipes)
+    {
+        if (std::fgets(line, sizeof(line), pipe) == nullptr || std::strcmp(line, "ready\n") != 0)
+        {
+            std::printf("a reader did not attach\n");
+            return false;
+        }
+    }
+
+    const double cpu_before = process_cpu_seconds();
+    const auto start = steady_clock::now();
+    uint32_t sequences[k_dice] = {};
+    auto next_burst = steady_clock::now();
+    for (int i = 0; i < k_packets; i++)
+    {
+        if (i % k_packets_per_burst == 0)
+        {
+            next_burst += std::chrono::milliseconds(1);
+            std::this_thread::sleep_until(next_burst);
+        }
+        const int die = i % k_dice;
+        transport.notify(die, sequences[die]++);
+    }
+    const double elapsed = std::chrono::duration<double>(steady_clock::now() - start).count();
+    const double cpu = process_cpu_seconds() - cpu_before;
+
+    bool ok = true;
+    double reader_cpu = 0;
+    uint64_t fewest = k_packets;
+    uint64_t lost = 0;
+    uint64_t dropped = 0;
+    uint64_t errors = 0;
+    for (FILE* pipe : pipes)
+    {
+        uint64_t received = 0, reader_lost = 0, reader_dropped = 0, reader_errors = 0;
+        double ns = 0;
+        if (std::fgets(line, sizeof(line), pipe) == nullptr ||
+            std::sscanf(line, "%" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64 " %lf", &received, &reader_lost, &reader_dropped, &reader_errors, &ns) != 5)
+        {
+            ok = false;
+        }
+        pclose(pipe);
+        fewest = std::min(fewest, received);
+        lost += reader_lost;
+        dropped += reader_dropped;
+        errors += reader_errors;
+        reader_cpu = std::max(reader_cpu, ns);
+    }
+
+    std::printf("%d readers %10.0f packets/s, daemon %5.0f cpu ns/packet, readers up to %5.0f, fewest received %6" PRIu64
+                ", %" PRIu64 " lost, %" PRIu64 " dropped, %" PRIu64 " out of order\n",
+                readers, k_packets / elapsed, cpu * 1e9 / k_packets, reader_cpu, fewest, lost, dropped, errors);
+    return ok && fewest == k_packets && lost == 0 && dropped == 0 && errors == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc == 3 && std::strcmp(argv[1], "--reader") == 0)
+    {
+        return run_reader(argv[2]);
+    }
+
+    const std::string name = "benchmark-" + std::to_string(process_id());
+    if (!godice_start_publishing(name.c_str(), k_ring_capacity))
+    {
+        std::printf("could not publish\n");
+        return 1;
+    }
+
+    auto owned = std::make_unique<SyntheticTransport>();
+    SyntheticTransport& transport = *owned;
+    install_transport(std::move(owned));
+    godice_set_callbacks(device_found, nullptr, device_connected, nullptr, nullptr, nullptr);
+    godice_start_listening();
+    while (g_connected.load() < k_dice)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    bool ok = true;
+    for (const int readers : { 1, 2, 4, 8 })
+    {
+        ok = run(argv[0], name, transport, readers) && ok;
+    }
+
+    godice_stop_publishing();
+    std::error_code ec;
+    std::filesystem::remove(godice::shared::path_for(name), ec);
+    return ok ? 0 : 1;
+}
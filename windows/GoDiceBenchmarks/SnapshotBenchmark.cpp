@@ -0,0 +1,163 @@
+// SnapshotBenchmark.cpp
+//
+// Streams stable packets from 128 synthetic dice as fast as the framework takes them,
+// while a "render thread" calls godice_snapshot for every die, first once per 1 ms
+// frame and then back to back. Reports what a snapshot costs and how many packets per
+// second the transport thread gets through, against a run with no reader at all.
+//
+// Every packet carries the same value in all three vector components, so a snapshot
+// that mixed two packets of one die shows up as a vector with unequal components. Any
+// such torn copy, or a die missing from a snapshot, makes the process exit non-zero.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../GoDiceDll/GoDiceDll.h"
+#include "../GoDiceDll/Transport.h"
+
+using std::chrono::steady_clock;
+
+static constexpr int k_dice = 128;
+static constexpr auto k_run = std::chrono::seconds(2);
+static constexpr auto k_frame = std::chrono::milliseconds(1);
+static constexpr uint64_t k_first_address = 0xB011E0000000ull;
+
+// Advertises every die when discovery starts and completes every operation at once
+class SyntheticTransport final : public Transport
+{
+private:
+    TransportListener* listener_ = nullptr;
+
+public:
+    void set_listener(TransportListener* listener) override { listener_ = listener; }
+
+    void start_discovery() override
+    {
+        for (int i = 0; i < k_dice; i++)
+        {
+            listener_->on_advertisement(k_first_address + i, "GoDice_SNAP_K_v04", -50);
+        }
+    }
+
+    void stop_discovery() override { listener_->on_discovery_stopped(); }
+
+    void connect(uint64_t, TransportCompletion completion) override { completion(true); }
+    void subscribe(uint64_t, TransportCompletion completion) override { completion(true); }
+    void write(uint64_t, const uint8_t*, uint32_t, WriteMode, TransportCompletion completion) override { completion(true); }
+    void disconnect(uint64_t, TransportCompletion completion) override { completion(true); }
+    void reset() override {}
+
+    void notify(int die, int8_t value)
+    {
+        const uint8_t packet[] = { 'S', static_cast<uint8_t>(value), static_cast<uint8_t>(value), static_cast<uint8_t>(value) };
+        listener_->on_notification(k_first_address + die, packet, sizeof(packet));
+    }
+};
+
+static std::atomic<int> g_connected = 0;
+
+static void device_found(const char* identifier, const char*) { godice_connect(identifier); }
+static void device_connected(const char*) { g_connected++; }
+
+enum class Reader
+{
+    None,
+    Frames,
+    BackToBack,
+};
+
+static auto run(const char* label, SyntheticTransport& transport, Reader reader) -> bool
+{
+    std::atomic<bool> running = true;
+    std::vector<uint64_t> samples;
+    uint64_t torn = 0;
+    uint64_t missing = 0;
+
+    std::thread render([&]
+    {
+        std::vector<GDDeviceState> states(GD_MAX_DEVICES);
+        auto next_frame = steady_clock::now();
+        while (reader != Reader::None && running.load(std::memory_order_relaxed))
+        {
+            if (reader == Reader::Frames)
+            {
+                next_frame += k_frame;
+                std::this_thread::sleep_until(next_frame);
+            }
+
+            const auto started = steady_clock::now();
+            const uint32_t count = godice_snapshot(states.data(), static_cast<uint32_t>(states.size()));
+            samples.push_back(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(steady_clock::now() - started).count()));
+
+            if (count != k_dice) missing++;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const GDVector& v = states[i].vector;
+                if (v.x != v.y || v.y != v.z) torn++;
+            }
+        }
+    });
+
+    const auto started = steady_clock::now();
+    uint64_t packets = 0;
+    while (steady_clock::now() - started < k_run)
+    {
+        for (int die = 0; die < k_dice; die++)
+        {
+            transport.notify(die, static_cast<int8_t>(packets % 128));
+            packets++;
+        }
+    }
+    const double elapsed = std::chrono::duration<double>(steady_clock::now() - started).count();
+    running = false;
+    render.join();
+
+    if (samples.empty())
+    {
+        std::printf("%-14s %9.0f packets/s\n", label, packets / elapsed);
+        return true;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) { return samples[static_cast<size_t>(p * (samples.size() - 1))] / 1000.0; };
+    std::printf("%-14s %9.0f packets/s, %8zu snapshots of %d dice  p50=%6.1fus  p99=%6.1fus  max=%7.1fus, %llu torn, %llu short\n",
+                label, packets / elapsed, samples.size(), k_dice, percentile(0.50), percentile(0.99), percentile(1.0),
+                static_cast<unsigned long long>(torn), static_cast<unsigned long long>(missing));
+    return torn == 0 && missing == 0;
+}
+
+int main()
+{
+    auto owned = std::make_unique<SyntheticTransport>();
+    SyntheticTransport& transport = *owned;
+    install_transport(std::move(owned));
+    godice_set_callbacks(device_found, nullptr, device_connected, nullptr, nullptr, nullptr);
+    godice_start_listening();
+    while (g_connected.load() < k_dice)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    bool ok = true;
+    ok = run("no reader", transport, Reader::None) && ok;
+    ok = run("1ms frames", transport, Reader::Frames) && ok;
+    ok = run("back to back", transport, Reader::BackToBack) && ok;
+
+    std::vector<GDDeviceState> states(GD_MAX_DEVICES);
+    const uint32_t count = godice_snapshot(states.data(), static_cast<uint32_t>(states.size()));
+    const bool connected = std::all_of(states.begin(), states.begin() + count, [](const GDDeviceState& state)
+    {
+        return state.connection == GD_CONNECTION_CONNECTED && state.roll == GD_EVENT_STABLE;
+    });
+    if (count != k_dice || !connected)
+    {
+        std::printf("snapshot does not show every die connected and at rest\n");
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
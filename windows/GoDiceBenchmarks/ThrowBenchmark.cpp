@@ -0,0 +1,346 @@
+// ThrowBenchmark.cpp
+//
+// Throws 100 synthetic dice, split into tables of 10, all at once, again and again.
+// Measures how long after the last die of a table comes to rest the host has the whole
+// table's result, two ways: the host tracking every die's events itself, the way a
+// game has to without groups, and a single godice_set_group throw callback per table.
+// Reports the latency percentiles and the callbacks the host took per throw.
+//
+// Then throws one table with a die that never settles, and checks that the throw is
+// reported with that die missing once the settle timeout runs out. Every face must
+// match the vector its die was given, or the process exits non-zero.
+//
+// With --parallel, callbacks for different dice run at once, so the host tracking run
+// is skipped. Each throw must then come after the event callbacks of all its dice's
+// packets, which run on other threads, or the process exits non-zero.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../GoDiceDll/GoDiceDll.h"
+#include "../GoDiceDll/Transport.h"
+
+using std::chrono::steady_clock;
+
+static constexpr int k_tables = 10;
+static constexpr int k_dice_per_table = 10;
+static constexpr int k_dice = k_tables * k_dice_per_table;
+static constexpr int k_rounds = 2000;
+static constexpr uint32_t k_settle_timeout_ms = 50;
+static constexpr uint64_t k_first_address = 0xB011E0000000ull;
+// Resting vectors for faces 1 to 6 of a D6
+static constexpr GDVector k_faces[] = {
+    { -64, 0, 0 },
+    { 0, 0, 64 },
+    { 0, 64, 0 },
+    { 0, -64, 0 },
+    { 0, 0, -64 },
+    { 64, 0, 0 },
+};
+
+// Advertises every die when discovery starts and completes every operation at once
+class SyntheticTransport final : public Transport
+{
+private:
+    TransportListener* listener_ = nullptr;
+
+public:
+    void set_listener(TransportListener* listener) override { listener_ = listener; }
+
+    void start_discovery() override
+    {
+        for (int i = 0; i < k_dice; i++)
+        {
+            listener_->on_advertisement(k_first_address + i, "GoDice_THROW_K_v04", -50);
+        }
+    }
+
+    void stop_discovery() override { listener_->on_discovery_stopped(); }
+
+    void connect(uint64_t, TransportCompletion completion) override { completion(true); }
+    void subscribe(uint64_t, TransportCompletion completion) override { completion(true); }
+    void write(uint64_t, const uint8_t*, uint32_t, WriteMode, TransportCompletion completion) override { completion(true); }
+    void disconnect(uint64_t, TransportCompletion completion) override { completion(true); }
+    void reset() override {}
+
+    void roll(int die)
+    {
+        const uint8_t packet[] = { 'R' };
+        listener_->on_notification(k_first_address + die, packet, sizeof(packet));
+    }
+
+    void settle(int die, GDVector vector)
+    {
+        const uint8_t packet[] = {
+            'S',
+            static_cast<uint8_t>(vector.x),
+            static_cast<uint8_t>(vector.y),
+            static_cast<uint8_t>(vector.z),
+        };
+        listener_->on_notification(k_first_address + die, packet, sizeof(packet));
+    }
+};
+
+static std::atomic<int> g_connected = 0;
+static std::atomic<int> g_tables_done = 0;
+static std::atomic<uint64_t> g_callbacks = 0;
+static std::atomic<uint64_t> g_errors = 0;
+// When each table's last die was sent to rest, and the face each die was given
+static std::atomic<int64_t> g_last_settled[k_tables];
+static uint8_t g_expected[k_dice];
+
+static std::mutex g_latencies_mutex;
+static std::vector<uint64_t> g_latencies;
+
+// Under --parallel: how many times each die's resting event has been delivered, which
+// a throw callback expects to be one per round
+static bool g_check_order = false;
+static std::atomic<int> g_round = 0;
+static std::atomic<int> g_rests_seen[k_dice];
+static std::atomic<uint64_t> g_early_throws = 0;
+
+// Callbacks are swapped on the framework's Bluetooth queue; give it time to get there
+static void wait_for_callbacks()
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+}
+
+static void device_found(const char* identifier, const char*) { godice_connect(identifier); }
+static void device_connected(const char*) { g_connected++; }
+
+static void table_done(int table)
+{
+    const int64_t now = steady_clock::now().time_since_epoch().count();
+    {
+        std::scoped_lock lk(g_latencies_mutex);
+        g_latencies.push_back(static_cast<uint64_t>(now - g_last_settled[table].load()));
+    }
+    g_tables_done++;
+}
+
+// What the host keeps per table when it tracks throws itself. Callbacks run one at a time.
+struct HostTable
+{
+    bool settled[k_dice_per_table] = {};
+    uint8_t face[k_dice_per_table] = {};
+    int settled_count = 0;
+    bool throwing = false;
+};
+static HostTable g_host_tables[k_tables];
+
+static void host_event(const char* identifier, const GDEvent* event)
+{
+    g_callbacks++;
+    const int die = static_cast<int>(godice_device_handle(identifier) - k_first_address);
+    HostTable& table = g_host_tables[die / k_dice_per_table];
+    const int index = die % k_dice_per_table;
+
+    if (event->type == GD_EVENT_ROLL_STARTED)
+    {
+        if (!table.throwing)
+        {
+            table = HostTable{};
+            table.throwing = true;
+        }
+        if (table.settled[index])
+        {
+            table.settled[index] = false;
+            table.settled_count--;
+        }
+        return;
+    }
+    if (!table.throwing) return;
+
+    if (!table.settled[index])
+    {
+        table.settled[index] = true;
+        table.settled_count++;
+    }
+    table.face[index] = godice_classify_face(GD_DIE_D6, GDVector{ event->x, event->y, event->z });
+    if (table.settled_count < k_dice_per_table) return;
+
+    table.throwing = false;
+    for (int i = 0; i < k_dice_per_table; i++)
+    {
+        if (table.face[i] != g_expected[die - index + i]) g_errors++;
+    }
+    table_done(die / k_dice_per_table);
+}
+
+static void count_rest(const char* identifier, const GDEvent* event)
+{
+    if (event->type == GD_EVENT_ROLL_STARTED) return;
+
+    g_rests_seen[godice_device_handle(identifier) - k_first_address]++;
+}
+
+static void on_throw(void*, uint32_t group, uint32_t count, const GDDieResult* results)
+{
+    g_callbacks++;
+    if (count != k_dice_per_table) g_errors++;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint64_t die = results[i].device - k_first_address;
+        if (results[i].face != g_expected[die]) g_errors++;
+        if (g_check_order && g_rests_seen[die].load() != g_round.load() + 1) g_early_throws++;
+    }
+    table_done(static_cast<int>(group));
+}
+
+// Every table throws at once: all dice start rolling, then come to rest in a random order
+static void run(const char* label, SyntheticTransport& transport)
+{
+    std::mt19937 rng(7);
+    std::vector<int> order(k_dice);
+    for (int i = 0; i < k_dice; i++) order[i] = i;
+
+    g_latencies.clear();
+    g_callbacks = 0;
+    for (int round = 0; round < k_rounds; round++)
+    {
+        g_tables_done = 0;
+        g_round = round;
+        std::shuffle(order.begin(), order.end(), rng);
+        for (const int die : order)
+        {
+            transport.roll(die);
+        }
+
+        int remaining[k_tables];
+        std::fill(std::begin(remaining), std::end(remaining), k_dice_per_table);
+        std::shuffle(order.begin(), order.end(), rng);
+        for (const int die : order)
+        {
+            const auto face = static_cast<uint8_t>(rng() % 6);
+            g_expected[die] = face + 1;
+            const int table = die / k_dice_per_table;
+            if (--remaining[table] == 0)
+            {
+                g_last_settled[table] = steady_clock::now().time_since_epoch().count();
+            }
+            transport.settle(die, k_faces[face]);
+        }
+
+        while (g_tables_done.load() < k_tables)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    std::sort(g_latencies.begin(), g_latencies.end());
+    auto percentile = [](double p) { return g_latencies[static_cast<size_t>(p * (g_latencies.size() - 1))] / 1000.0; };
+    std::printf("%-16s last die to result  p50=%7.1fus  p99=%7.1fus  max=%8.1fus  %5.1f callbacks per throw\n",
+                label, percentile(0.50), percentile(0.99), percentile(1.0), double(g_callbacks.load()) / (k_rounds * k_tables));
+}
+
+static std::atomic<bool> g_timed_out = false;
+
+static void on_timed_out_throw(void*, uint32_t, uint32_t count, const GDDieResult* results)
+{
+    uint32_t unsettled = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (results[i].event.type == GD_EVENT_UNKNOWN && results[i].face == 0) unsettled++;
+    }
+    if (unsettled != 1) g_errors++;
+    g_timed_out = true;
+}
+
+// The last die of table 0 never comes to rest
+static void run_timeout(SyntheticTransport& transport)
+{
+    godice_set_throw_callback(on_timed_out_throw, nullptr);
+    std::vector<GDDeviceHandle> handles;
+    for (int die = 0; die < k_dice_per_table; die++)
+    {
+        handles.push_back(k_first_address + die);
+    }
+    const GDGroupConfig config{ k_settle_timeout_ms };
+    godice_set_group(0, handles.data(), k_dice_per_table, &config);
+    wait_for_callbacks();
+
+    const auto started = steady_clock::now();
+    for (int die = 0; die < k_dice_per_table; die++)
+    {
+        transport.roll(die);
+    }
+    for (int die = 0; die < k_dice_per_table - 1; die++)
+    {
+        transport.settle(die, k_faces[0]);
+    }
+    while (!g_timed_out.load())
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    const double waited = std::chrono::duration<double, std::milli>(steady_clock::now() - started).count();
+
+    GDStats stats;
+    godice_get_stats(&stats);
+    std::printf("settle timeout   %ums, reported after %.1fms; %llu throws completed, %llu timed out\n",
+                k_settle_timeout_ms, waited, static_cast<unsigned long long>(stats.throws_completed),
+                static_cast<unsigned long long>(stats.throws_timed_out));
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc == 2 && std::strcmp(argv[1], "--parallel") == 0)
+    {
+        GDExecutorConfig config{};
+        config.parallel_callbacks = true;
+        godice_configure_executor(&config);
+        g_check_order = true;
+    }
+
+    auto owned = std::make_unique<SyntheticTransport>();
+    SyntheticTransport& transport = *owned;
+    install_transport(std::move(owned));
+    godice_set_callbacks(device_found, nullptr, device_connected, nullptr, nullptr, nullptr);
+    godice_start_listening();
+    while (g_connected.load() < k_dice)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    if (!g_check_order)
+    {
+        godice_set_event_callback(host_event);
+        wait_for_callbacks();
+        run("host tracking", transport);
+    }
+
+    godice_set_event_callback(g_check_order ? count_rest : nullptr);
+    godice_set_throw_callback(on_throw, nullptr);
+    for (int table = 0; table < k_tables; table++)
+    {
+        std::vector<GDDeviceHandle> handles;
+        for (int i = 0; i < k_dice_per_table; i++)
+        {
+            handles.push_back(k_first_address + table * k_dice_per_table + i);
+        }
+        godice_set_group(table, handles.data(), k_dice_per_table, nullptr);
+    }
+    wait_for_callbacks();
+    run("throw callback", transport);
+
+    run_timeout(transport);
+
+    if (g_check_order)
+    {
+        std::printf("%llu results reported before their die's event callback\n", static_cast<unsigned long long>(g_early_throws.load()));
+    }
+    if (g_errors.load() != 0 || g_early_throws.load() != 0)
+    {
+        std::printf("%llu wrong results\n", static_cast<unsigned long long>(g_errors.load()));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+// WorkQueueBenchmark.cpp
+//
+// Compares the Locked and LockFree WorkQueue backends: enqueue throughput with
+// several producer threads, and wake latency for a runner that has gone idle.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "../GoDiceDll/WorkQueue.h"
+
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+
+static constexpr int k_items_per_producer = 200000;
+static constexpr int k_latency_samples = 2000;
+
+static auto backend_name(WorkQueueBackend backend) -> const char*
+{
+    return backend == WorkQueueBackend::LockFree ? "lock-free" : "locked";
+}
+
+static void throughput(WorkQueueBackend backend, int producers)
+{
+    std::atomic<int64_t> executed = 0;
+    const int64_t total = static_cast<int64_t>(producers) * k_items_per_producer;
+
+    steady_clock::time_point start;
+    {
+        WorkQueue queue("Benchmark", backend);
+        std::vector<std::thread> threads;
+
+        start = steady_clock::now();
+        for (int p = 0; p < producers; p++)
+        {
+            threads.emplace_back([&queue, &executed]
+            {
+                for (int i = 0; i < k_items_per_producer; i++)
+                {
+                    queue.enqueue([&executed] { executed.fetch_add(1, std::memory_order_relaxed); });
+                }
+            });
+        }
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+        while (executed.load(std::memory_order_relaxed) < total)
+        {
+            std::this_thread::yield();
+        }
+    }
+    const auto elapsed = std::chrono::duration<double>(steady_clock::now() - start).count();
+
+    std::printf("%-10s producers=%-2d  %10.0f items/s\n", backend_name(backend), producers, total / elapsed);
+}
+
+static void wake_latency(WorkQueueBackend backend)
+{
+    std::vector<int64_t> samples(k_latency_samples);
+    std::atomic<int> done = 0;
+
+    {
+        WorkQueue queue("Benchmark", backend);
+
+        for (int i = 0; i < k_latency_samples; i++)
+        {
+            // Long enough for the lock-free runner to finish spinning and park
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+
+            const auto enqueued = steady_clock::now();
+            queue.enqueue([&samples, &done, enqueued, i]
+            {
+                samples[i] = std::chrono::duration_cast<nanoseconds>(steady_clock::now() - enqueued).count();
+                done.fetch_add(1, std::memory_order_release);
+            });
+        }
+        while (done.load(std::memory_order_acquire) < k_latency_samples)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) { return samples[static_cast<size_t>(p * (samples.size() - 1))] / 1000.0; };
+
+    std::printf("%-10s wake latency  p50=%8.2fus  p99=%8.2fus  max=%8.2fus\n",
+                backend_name(backend), percentile(0.50), percentile(0.99), percentile(1.0));
+}
+
+int main()
+{
+    const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("hardware threads: %u\n\n", hw);
+
+    for (auto backend : {WorkQueueBackend::Locked, WorkQueueBackend::LockFree})
+    {
+        for (int producers : {1, 2, 4, 8})
+        {
+            throughput(backend, producers);
+        }
+    }
+    std::printf("\n");
+
+    for (auto backend : {WorkQueueBackend::Locked, WorkQueueBackend::LockFree})
+    {
+        wake_latency(backend);
+    }
+
+    return 0;
+}
@@ -0,0 +1,379 @@
+// WriteBenchmark.cpp
+//
+// Measures how far LED feedback lags behind the game on a busy table. Every die
+// is sent a new LED state at k_update_hz through godice_send, faster than the
+// link can carry them. The fake transport models one connection event every
+// k_connection_interval per die: a write with response takes two events, and up
+// to k_packets_per_event writes without response share one. Lag is the time
+// from godice_send until the die applies that state.
+//
+// Each write mode runs twice: with real LED commands, which the write pipeline
+// coalesces, and with the same bytes under an opcode it does not know, which
+// it queues one by one.
+//
+// The broadcast runs flash a larger table once per frame, either with one
+// godice_send per die or with a single godice_send_many, and also report how
+// long the framework takes to hand every write to the transport ("dispatch")
+// and, for godice_send_many, until its batched callback reports all dice.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../GoDiceDll/DeviceIdentifier.h"
+#include "../GoDiceDll/GoDiceDll.h"
+#include "../GoDiceDll/GoDiceProtocol.h"
+#include "../GoDiceDll/Transport.h"
+#include "../GoDiceDll/WritePipeline.h"
+
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+static constexpr int k_dice = 20;
+static constexpr int k_update_hz = 120;
+static constexpr int k_updates = 240;
+static constexpr int k_broadcast_dice = 50;
+static constexpr int k_frame_hz = 60;
+static constexpr int k_broadcasts = 120;
+static constexpr int k_max_dice = std::max(k_dice, k_broadcast_dice);
+static constexpr milliseconds k_connection_interval(15);
+static constexpr int k_packets_per_event = 4;
+static constexpr uint8_t k_opaque_command = 0x42;
+static constexpr uint64_t k_first_address = 0xD17E00000000ull;
+
+static steady_clock::time_point g_sent[k_max_dice][std::max(k_updates, k_broadcasts)];
+
+class LinkTransport final : public Transport
+{
+private:
+    struct Pending
+    {
+        uint16_t sequence;
+        WriteMode mode;
+        int events_left;
+        TransportCompletion completion;
+    };
+
+    const int dice_;
+    TransportListener* listener_ = nullptr;
+    std::mutex mutex_;
+    std::vector<std::deque<Pending>> links_;
+    std::vector<double> lags_ms_;
+    std::vector<double> dispatch_ms_;
+    std::vector<int> applied_;
+    std::vector<int> last_applied_;
+    std::atomic<bool> running_ = true;
+    std::thread ticker_;
+
+    void tick()
+    {
+        std::vector<std::pair<int, Pending>> done;
+        const auto now = steady_clock::now();
+        {
+            std::scoped_lock lk(mutex_);
+            for (int die = 0; die < dice_; die++)
+            {
+                auto& link = links_[die];
+                int packets = 0;
+                while (!link.empty() && packets < k_packets_per_event)
+                {
+                    Pending& front = link.front();
+                    if (front.mode == WriteMode::WithResponse)
+                    {
+                        // The request and its response each take an event, and nothing else goes meanwhile
+                        if (packets > 0 || --front.events_left > 0) break;
+                    }
+                    packets++;
+                    done.emplace_back(die, std::move(front));
+                    link.pop_front();
+                }
+            }
+
+            for (const auto& [die, pending] : done)
+            {
+                lags_ms_.push_back(std::chrono::duration<double, std::milli>(now - g_sent[die][pending.sequence]).count());
+                applied_[die]++;
+                last_applied_[die] = pending.sequence;
+            }
+        }
+
+        for (auto& [die, pending] : done)
+        {
+            pending.completion(true);
+        }
+    }
+
+public:
+    explicit LinkTransport(int dice) : dice_(dice), links_(dice), applied_(dice), last_applied_(dice, -1)
+    {
+        ticker_ = std::thread([this]
+        {
+            auto next = steady_clock::now();
+            while (running_)
+            {
+                next += k_connection_interval;
+                std::this_thread::sleep_until(next);
+                tick();
+            }
+        });
+    }
+
+    ~LinkTransport() override
+    {
+        running_ = false;
+        ticker_.join();
+    }
+
+    void set_listener(TransportListener* listener) override { listener_ = listener; }
+
+    void start_discovery() override
+    {
+        for (int i = 0; i < dice_; i++)
+        {
+            listener_->on_advertisement(k_first_address + i, "GoDice_LINK_K_v04", -50);
+        }
+    }
+
+    void stop_discovery() override { listener_->on_discovery_stopped(); }
+    void connect(uint64_t, TransportCompletion completion) override { completion(true); }
+    void subscribe(uint64_t, TransportCompletion completion) override { completion(true); }
+
+    void write(uint64_t address, const uint8_t* data, uint32_t, WriteMode mode, TransportCompletion completion) override
+    {
+        const auto now = steady_clock::now();
+        const auto die = static_cast<int>(address - k_first_address);
+        const auto sequence = static_cast<uint16_t>(data[1] << 8 | data[2]);
+        std::scoped_lock lk(mutex_);
+        dispatch_ms_.push_back(std::chrono::duration<double, std::milli>(now - g_sent[die][sequence]).count());
+        links_[die].push_back(Pending{ sequence, mode, 2, std::move(completion) });
+    }
+
+    void disconnect(uint64_t, TransportCompletion completion) override { completion(true); }
+    void reset() override {}
+
+    // Waits until every die has applied `last_sequence`, then returns the lag of every applied state
+    auto drain(int last_sequence) -> std::vector<double>
+    {
+        for (;;)
+        {
+            {
+                std::scoped_lock lk(mutex_);
+                if (std::all_of(last_applied_.begin(), last_applied_.end(), [last_sequence](int last) { return last == last_sequence; }))
+                {
+                    return lags_ms_;
+                }
+            }
+            std::this_thread::sleep_for(k_connection_interval * 4);
+        }
+    }
+
+    auto applied() -> int
+    {
+        std::scoped_lock lk(mutex_);
+        int total = 0;
+        for (const int count : applied_)
+        {
+            total += count;
+        }
+        return total;
+    }
+
+    auto dispatch_lags() -> std::vector<double>
+    {
+        std::scoped_lock lk(mutex_);
+        return dispatch_ms_;
+    }
+};
+
+static std::mutex g_found_mutex;
+static std::vector<std::string> g_found;
+static std::atomic<bool> g_stopped = false;
+
+static void device_found(const char* identifier, const char*)
+{
+    std::scoped_lock lk(g_found_mutex);
+    if (std::find(g_found.begin(), g_found.end(), identifier) == g_found.end())
+    {
+        g_found.emplace_back(identifier);
+    }
+}
+
+static void listener_stopped() { g_stopped = true; }
+
+static auto percentile(std::vector<double>& values, double p) -> double
+{
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(p * static_cast<double>(values.size())))];
+}
+
+static auto open_table(int dice, GDWriteMode mode, uint32_t max_in_flight) -> LinkTransport*
+{
+    {
+        std::scoped_lock lk(g_found_mutex);
+        g_found.clear();
+    }
+
+    auto owned = std::make_unique<LinkTransport>(dice);
+    LinkTransport* link = owned.get();
+    install_transport(std::move(owned));
+    godice_set_write_mode(mode, max_in_flight);
+    godice_start_listening();
+
+    for (size_t found = 0; found < static_cast<size_t>(dice);)
+    {
+        std::this_thread::yield();
+        std::scoped_lock lk(g_found_mutex);
+        found = g_found.size();
+    }
+    return link;
+}
+
+static void close_table()
+{
+    g_stopped = false;
+    godice_stop_listening();
+    while (!g_stopped)
+    {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+}
+
+// Pulse command: sequence number in the count and timing bytes, then a colour
+static auto pulse(uint8_t opcode, int sequence) -> std::vector<uint8_t>
+{
+    return { opcode, static_cast<uint8_t>(sequence >> 8), static_cast<uint8_t>(sequence), 0xFF, 0, 0, 0xFF, 1, 0 };
+}
+
+static void run(const char* label, GDWriteMode mode, uint32_t max_in_flight, uint8_t opcode)
+{
+    LinkTransport* link = open_table(k_dice, mode, max_in_flight);
+
+    std::vector<std::string> identifiers;
+    for (int die = 0; die < k_dice; die++)
+    {
+        identifiers.push_back(godice::identifier_string(k_first_address + die));
+    }
+
+    auto next = steady_clock::now();
+    for (int update = 0; update < k_updates; update++)
+    {
+        for (int die = 0; die < k_dice; die++)
+        {
+            std::vector<uint8_t> message = pulse(opcode, update);
+            g_sent[die][update] = steady_clock::now();
+            godice_send(identifiers[die].c_str(), static_cast<uint32_t>(message.size()), message.data());
+        }
+        next += std::chrono::microseconds(1000000 / k_update_hz);
+        std::this_thread::sleep_until(next);
+    }
+
+    std::vector<double> lags = link->drain(k_updates - 1);
+    const int applied = link->applied();
+    std::printf("%-28s applied %5d/%d  lag p50 %7.1f ms  p99 %7.1f ms  max %7.1f ms\n", label, applied, k_dice * k_updates,
+                percentile(lags, 0.5), percentile(lags, 0.99), percentile(lags, 1.0));
+
+    close_table();
+}
+
+static std::mutex g_batch_mutex;
+static std::vector<double> g_batch_ms;
+static std::atomic<int> g_batch_delivered = 0;
+
+static void batch_done(void* context, uint32_t count, const GDDeviceHandle*, const bool* delivered)
+{
+    const auto now = steady_clock::now();
+    const auto sequence = reinterpret_cast<uintptr_t>(context);
+    g_batch_delivered += static_cast<int>(std::count(delivered, delivered + count, true));
+
+    std::scoped_lock lk(g_batch_mutex);
+    g_batch_ms.push_back(std::chrono::duration<double, std::milli>(now - g_sent[0][sequence]).count());
+}
+
+static void run_broadcast(const char* label, bool batched)
+{
+    LinkTransport* link = open_table(k_broadcast_dice, GD_WRITE_WITHOUT_RESPONSE, WritePipeline::k_default_max_in_flight);
+    {
+        std::scoped_lock lk(g_batch_mutex);
+        g_batch_ms.clear();
+    }
+    g_batch_delivered = 0;
+
+    std::vector<std::string> identifiers;
+    std::vector<GDDeviceHandle> handles;
+    for (int die = 0; die < k_broadcast_dice; die++)
+    {
+        identifiers.push_back(godice::identifier_string(k_first_address + die));
+        handles.push_back(godice_device_handle(identifiers.back().c_str()));
+    }
+
+    auto next = steady_clock::now();
+    for (int broadcast = 0; broadcast < k_broadcasts; broadcast++)
+    {
+        std::vector<uint8_t> message = pulse(godice::protocol::k_set_led_toggle, broadcast);
+        const auto now = steady_clock::now();
+        for (int die = 0; die < k_broadcast_dice; die++)
+        {
+            g_sent[die][broadcast] = now;
+        }
+
+        if (batched)
+        {
+            godice_send_many_handles(handles.data(), k_broadcast_dice, static_cast<uint32_t>(message.size()), message.data(), batch_done,
+                                     reinterpret_cast<void*>(static_cast<uintptr_t>(broadcast)));
+        }
+        else
+        {
+            for (const auto& identifier : identifiers)
+            {
+                godice_send(identifier.c_str(), static_cast<uint32_t>(message.size()), message.data());
+            }
+        }
+        next += std::chrono::microseconds(1000000 / k_frame_hz);
+        std::this_thread::sleep_until(next);
+    }
+
+    std::vector<double> lags = link->drain(k_broadcasts - 1);
+    std::vector<double> dispatch = link->dispatch_lags();
+    std::printf("%-28s dispatch p99 %6.3f ms  applied p99 %5.1f ms", label, percentile(dispatch, 0.99), percentile(lags, 0.99));
+    if (batched)
+    {
+        while (g_batch_delivered.load() < k_broadcast_dice * k_broadcasts)
+        {
+            std::this_thread::sleep_for(milliseconds(1));
+        }
+        std::scoped_lock lk(g_batch_mutex);
+        std::printf("  all acknowledged p50 %5.1f ms  p99 %5.1f ms", percentile(g_batch_ms, 0.5), percentile(g_batch_ms, 0.99));
+    }
+    std::printf("\n");
+
+    close_table();
+}
+
+int main()
+{
+    godice_set_callbacks(device_found, nullptr, nullptr, nullptr, nullptr, listener_stopped);
+
+    std::printf("%d dice, %d LED updates per second for %.1f s, %lld ms connection interval\n", k_dice, k_update_hz,
+                static_cast<double>(k_updates) / k_update_hz, static_cast<long long>(k_connection_interval.count()));
+
+    run("with response, opaque", GD_WRITE_WITH_RESPONSE, 1, k_opaque_command);
+    run("with response, LED", GD_WRITE_WITH_RESPONSE, 1, godice::protocol::k_set_led_toggle);
+    run("without response x1, opaque", GD_WRITE_WITHOUT_RESPONSE, 1, k_opaque_command);
+    run("without response x1, LED", GD_WRITE_WITHOUT_RESPONSE, 1, godice::protocol::k_set_led_toggle);
+    run("without response x4, opaque", GD_WRITE_WITHOUT_RESPONSE, 4, k_opaque_command);
+    run("without response x4, LED", GD_WRITE_WITHOUT_RESPONSE, 4, godice::protocol::k_set_led_toggle);
+
+    std::printf("\n%d dice, flashed once per %.1f ms frame\n", k_broadcast_dice, 1000.0 / k_frame_hz);
+    run_broadcast("godice_send per die", false);
+    run_broadcast("godice_send_many", true);
+
+    return 0;
+}
@@ -1,11 +1,17 @@
 
+#include <algorithm>
 #include <future>
 #include <iostream>
+#include <mutex>
 #include <ostream>
 #include <semaphore>
+#include <unordered_map>
 #include <unordered_set>
 #include <string>
 
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
 #include "../GoDiceDll/GoDiceDll.h"
 
 using std::cerr;
@@ -14,10 +20,12 @@ using std::string;
 
 void DeviceFoundCallback(const char* identifier, const char* name);
 void DataCallback(const char* identifier, uint32_t data_size, uint8_t* data);
+void EventCallback(const char* identifier, const GDEvent* event);
 void DeviceConnectedCallback(const char* identifier);
 void DeviceConnectionFailedCallback(const char* identifier);
 void DeviceDisconnectedCallback(const char* identifier);
 void ListenerStoppedCallback(void);
+void DispatchEvent(const GDPollEvent& event);
 
 void log(const char* str);
 
@@ -34,19 +42,62 @@ int main(int argc, char* argv[])
     cerr << "Starting!" << endl;
 
     godice_set_logger(log);
-    godice_set_callbacks(
-        DeviceFoundCallback,
-        DataCallback,
-        DeviceConnectedCallback,
-        DeviceConnectionFailedCallback,
-        DeviceDisconnectedCallback,
-        ListenerStoppedCallback);
+    godice_set_log_level(GD_LOG_DEBUG);
+
+    // Rather than taking callbacks on the framework's threads, sleep on the wait handle
+    // and run the same handlers here whenever events are queued
+    godice_enable_polling(1024);
+    const auto wait_handle = reinterpret_cast<HANDLE>(godice_get_wait_handle());
     godice_start_listening();
 
-    while(1);
+    GDPollEvent events[64];
+    while (WaitForSingleObject(wait_handle, INFINITE) == WAIT_OBJECT_0)
+    {
+        const uint32_t count = godice_poll_events(events, 64);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            DispatchEvent(events[i]);
+        }
+    }
     return 0;
 }
 
+void DispatchEvent(const GDPollEvent& event)
+{
+    const string identifier = std::to_string(event.device);
+    switch (event.type)
+    {
+    case GD_POLL_DEVICE_FOUND:
+        DeviceFoundCallback(identifier.c_str(), event.name);
+        break;
+    case GD_POLL_CONNECTED:
+        DeviceConnectedCallback(identifier.c_str());
+        break;
+    case GD_POLL_CONNECTION_FAILED:
+        DeviceConnectionFailedCallback(identifier.c_str());
+        break;
+    case GD_POLL_DISCONNECTED:
+        DeviceDisconnectedCallback(identifier.c_str());
+        break;
+    case GD_POLL_DATA:
+    {
+        uint8_t data[GD_POLL_DATA_SIZE];
+        std::copy(event.data, event.data + event.data_size, data);
+        DataCallback(identifier.c_str(), event.data_size, data);
+        if (event.event.type != GD_EVENT_UNKNOWN)
+        {
+            EventCallback(identifier.c_str(), &event.event);
+        }
+        break;
+    }
+    case GD_POLL_LISTENER_STOPPED:
+        ListenerStoppedCallback();
+        break;
+    default:
+        break;
+    }
+}
+
 void DeviceFoundCallback(const char* ident_, const char* name)
 {
     const string identifier(ident_);
@@ -76,10 +127,31 @@ void DataCallback(const char* identifier, uint32_t data_size, uint8_t* data)
         cerr << std::hex << (int)data[i];
     }
     cerr << std::dec << endl;
-    
-    if (data_size > 3 && data[0] == 'C' && data[1] == 'o' && data[2] == 'l')
+}
+
+void EventCallback(const char* identifier, const GDEvent* event)
+{
+    string& name = deviceNames[identifier];
+    switch (event->type)
     {
-        cerr <<  "  " << name <<  " Received color " << static_cast<int>(data[3]) << endl;;
+    case GD_EVENT_ROLL_STARTED:
+        cerr << "  " << name << " Roll started" << endl;
+        break;
+    case GD_EVENT_STABLE:
+    case GD_EVENT_FAKE_STABLE:
+    case GD_EVENT_TILT_STABLE:
+    case GD_EVENT_MOVE_STABLE:
+        cerr << "  " << name << " Stable (" << static_cast<int>(event->x) << ", " << static_cast<int>(event->y)
+             << ", " << static_cast<int>(event->z) << ")" << endl;
+        break;
+    case GD_EVENT_BATTERY_LEVEL:
+        cerr << "  " << name << " Received battery level " << static_cast<int>(event->value) << endl;
+        break;
+    case GD_EVENT_COLOR:
+        cerr << "  " << name << " Received color " << static_cast<int>(event->value) << endl;
+        break;
+    default:
+        break;
     }
 }
 
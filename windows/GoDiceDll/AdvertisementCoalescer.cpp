@@ -0,0 +1,67 @@
+#include "AdvertisementCoalescer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+auto AdvertisementCoalescer::default_config() -> GDCoalescingConfig
+{
+    GDCoalescingConfig config{};
+    config.suppression_window_ms = 1000;
+    config.rssi_smoothing = 0.25f;
+    config.rssi_change_db = 6;
+    return config;
+}
+
+AdvertisementCoalescer::AdvertisementCoalescer(const GDCoalescingConfig& config) : config_(config)
+{
+}
+
+void AdvertisementCoalescer::configure(const GDCoalescingConfig& config)
+{
+    std::scoped_lock lk(mutex_);
+    config_ = config;
+}
+
+auto AdvertisementCoalescer::admit(uint64_t address, std::string_view name, int16_t rssi, Clock::time_point now) -> bool
+{
+    // Scan responses often arrive without a name; don't treat that as a rename
+    const size_t name_hash = name.empty() ? 0 : std::hash<std::string_view>()(name);
+
+    std::scoped_lock lk(mutex_);
+
+    auto [entry, inserted] = entries_.try_emplace(address, Entry{ now, name_hash, float(rssi), float(rssi) });
+    if (inserted || config_.suppression_window_ms == 0)
+    {
+        forwarded_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    const float alpha = std::clamp(config_.rssi_smoothing, 0.0f, 1.0f);
+    entry->smoothed_rssi += alpha * (float(rssi) - entry->smoothed_rssi);
+
+    const bool renamed = name_hash != 0 && name_hash != entry->name_hash;
+    const bool moved = std::fabs(entry->smoothed_rssi - entry->forwarded_rssi) >= float(config_.rssi_change_db);
+    const bool stale = now - entry->last_forwarded >= std::chrono::milliseconds(config_.suppression_window_ms);
+
+    if (!renamed && !moved && !stale)
+    {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (name_hash != 0)
+    {
+        entry->name_hash = name_hash;
+    }
+    entry->last_forwarded = now;
+    entry->forwarded_rssi = entry->smoothed_rssi;
+    forwarded_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void AdvertisementCoalescer::clear()
+{
+    std::scoped_lock lk(mutex_);
+    entries_.clear();
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+
+#include "FlatAddressMap.h"
+#include "GoDiceDll.h"
+
+// Sits between the transport and the device registry. In active scan mode every die
+// sends a steady stream of advertisements and scan responses; this keeps a last-seen
+// entry per address and lets through only the ones that tell the client something:
+// a new die, a new name, a real change in signal strength, or a periodic refresh.
+class AdvertisementCoalescer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static auto default_config() -> GDCoalescingConfig;
+
+    explicit AdvertisementCoalescer(const GDCoalescingConfig& config = default_config());
+
+    void configure(const GDCoalescingConfig& config);
+
+    // True if the advertisement should be forwarded. Safe to call from any thread.
+    auto admit(uint64_t address, std::string_view name, int16_t rssi, Clock::time_point now = Clock::now()) -> bool;
+
+    // Forgets every address, so the next advertisement from each is forwarded
+    void clear();
+
+    [[nodiscard]] auto forwarded() const -> uint64_t { return forwarded_.load(std::memory_order_relaxed); }
+    [[nodiscard]] auto suppressed() const -> uint64_t { return suppressed_.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry
+    {
+        Clock::time_point last_forwarded;
+        size_t name_hash = 0;
+        float smoothed_rssi = 0;
+        // smoothed value at the time of the last forward
+        float forwarded_rssi = 0;
+    };
+
+    std::mutex mutex_;
+    GDCoalescingConfig config_;
+    FlatAddressMap<Entry> entries_;
+
+    std::atomic<uint64_t> forwarded_ = 0;
+    std::atomic<uint64_t> suppressed_ = 0;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <coroutine>
+#include <deque>
+#include <mutex>
+
+// Mutual exclusion for coroutines. Waiting for the lock suspends the coroutine
+// instead of blocking its thread, and unlock() hands the lock straight to the
+// oldest waiter and resumes it on the unlocking thread.
+class AsyncMutex
+{
+private:
+    std::mutex mutex_;
+    bool locked_ = false;
+    std::deque<std::coroutine_handle<>> waiters_;
+
+public:
+    class LockAwaiter
+    {
+    private:
+        AsyncMutex& owner_;
+
+    public:
+        explicit LockAwaiter(AsyncMutex& owner) : owner_(owner) {}
+
+        auto await_ready() -> bool { return owner_.try_lock(); }
+
+        auto await_suspend(std::coroutine_handle<> waiter) -> bool
+        {
+            std::scoped_lock lk(owner_.mutex_);
+            if (!owner_.locked_)
+            {
+                owner_.locked_ = true;
+                return false;
+            }
+            owner_.waiters_.push_back(waiter);
+            return true;
+        }
+
+        void await_resume() {}
+    };
+
+    AsyncMutex() = default;
+    AsyncMutex(const AsyncMutex&) = delete;
+    AsyncMutex& operator=(const AsyncMutex&) = delete;
+
+    // co_await mutex.lock();
+    [[nodiscard]] auto lock() -> LockAwaiter { return LockAwaiter(*this); }
+
+    auto try_lock() -> bool
+    {
+        std::scoped_lock lk(mutex_);
+        if (locked_) return false;
+
+        locked_ = true;
+        return true;
+    }
+
+    void unlock()
+    {
+        std::coroutine_handle<> next;
+        {
+            std::scoped_lock lk(mutex_);
+            if (waiters_.empty())
+            {
+                locked_ = false;
+                return;
+            }
+            next = waiters_.front();
+            waiters_.pop_front();
+        }
+        // Still locked; ownership passes to the resumed coroutine
+        next.resume();
+    }
+};
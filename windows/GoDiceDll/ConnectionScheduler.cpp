@@ -0,0 +1,53 @@
+#include "ConnectionScheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+ConnectionScheduler::ConnectionScheduler(uint32_t max_concurrent) : max_concurrent_(std::max(max_concurrent, 1u))
+{
+}
+
+void ConnectionScheduler::set_max_concurrent(uint32_t max_concurrent)
+{
+    max_concurrent_ = std::max(max_concurrent, 1u);
+    start_waiting();
+}
+
+void ConnectionScheduler::submit(Task task)
+{
+    waiting_.push_back(std::move(task));
+    start_waiting();
+}
+
+void ConnectionScheduler::finished(uint32_t generation)
+{
+    if (generation != generation_ || active_ == 0) return;
+
+    active_--;
+    start_waiting();
+}
+
+void ConnectionScheduler::clear()
+{
+    std::deque<Task> dropped;
+    dropped.swap(waiting_);
+    active_ = 0;
+    generation_++;
+
+    for (auto& task : dropped)
+    {
+        task(false);
+    }
+}
+
+void ConnectionScheduler::start_waiting()
+{
+    while (active_ < max_concurrent_ && !waiting_.empty())
+    {
+        Task task = std::move(waiting_.front());
+        waiting_.pop_front();
+        active_++;
+        // May call finished() re-entrantly if the attempt fails immediately
+        task(true);
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+// Limits how many connection attempts run at once. Dice connect in parallel up to
+// the limit; further requests wait in arrival order. Not synchronised: the core
+// only uses it from the bluetooth queue.
+class ConnectionScheduler
+{
+public:
+    static constexpr uint32_t k_default_max_concurrent = 4;
+
+    // Called with true when the attempt may start, or with false if clear() dropped it
+    using Task = std::function<void(bool start)>;
+
+    explicit ConnectionScheduler(uint32_t max_concurrent = k_default_max_concurrent);
+
+    // 0 is treated as 1
+    void set_max_concurrent(uint32_t max_concurrent);
+
+    void submit(Task task);
+
+    // A started task calls this exactly once when its attempt is over, passing the
+    // generation() it saw when it started. Calls from before a clear() are ignored.
+    void finished(uint32_t generation);
+
+    [[nodiscard]] auto generation() const -> uint32_t { return generation_; }
+
+    // Drops every waiting task and forgets running ones, e.g. when the transport is replaced
+    void clear();
+
+    [[nodiscard]] auto active() const -> uint32_t { return active_; }
+    [[nodiscard]] auto waiting() const -> size_t { return waiting_.size(); }
+
+private:
+    void start_waiting();
+
+    uint32_t max_concurrent_;
+    uint32_t active_ = 0;
+    uint32_t generation_ = 0;
+    std::deque<Task> waiting_;
+};
@@ -0,0 +1,169 @@
+#include "DeviceCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+auto DeviceCache::default_path() -> std::string
+{
+#if defined(_WIN32)
+    char* local_app_data = nullptr;
+    size_t length = 0;
+    if (_dupenv_s(&local_app_data, &length, "LOCALAPPDATA") != 0 || local_app_data == nullptr)
+    {
+        return {};
+    }
+    std::string path = std::string(local_app_data) + "\\GoDice\\devices.cache";
+    std::free(local_app_data);
+    return path;
+#else
+    return {};
+#endif
+}
+
+DeviceCache::~DeviceCache()
+{
+    close();
+}
+
+auto DeviceCache::open(const std::string& path) -> bool
+{
+    std::scoped_lock lk(mutex_);
+
+    file_.close();
+    records_ = nullptr;
+    index_.clear();
+
+    if (path.empty() || !file_.open(path, sizeof(Header) + k_capacity * sizeof(CachedDevice)))
+    {
+        return false;
+    }
+
+    auto* header = reinterpret_cast<Header*>(file_.data());
+    records_ = reinterpret_cast<CachedDevice*>(file_.data() + sizeof(Header));
+
+    const bool compatible = std::memcmp(header->magic, k_magic, sizeof(k_magic)) == 0 && header->version == k_version &&
+                            header->record_size == sizeof(CachedDevice) && header->capacity == k_capacity;
+    if (!compatible)
+    {
+        std::memset(file_.data(), 0, file_.size());
+        std::memcpy(header->magic, k_magic, sizeof(k_magic));
+        header->version = k_version;
+        header->record_size = sizeof(CachedDevice);
+        header->capacity = k_capacity;
+        return true;
+    }
+
+    for (uint32_t i = 0; i < k_capacity; i++)
+    {
+        if (records_[i].address != 0)
+        {
+            index_.try_emplace(records_[i].address, i);
+        }
+    }
+    return true;
+}
+
+void DeviceCache::close()
+{
+    std::scoped_lock lk(mutex_);
+    file_.close();
+    records_ = nullptr;
+    index_.clear();
+}
+
+auto DeviceCache::is_open() const -> bool
+{
+    std::scoped_lock lk(mutex_);
+    return records_ != nullptr;
+}
+
+auto DeviceCache::find(uint64_t address, CachedDevice& device) const -> bool
+{
+    std::scoped_lock lk(mutex_);
+    const uint32_t* index = index_.find(address);
+    if (index == nullptr) return false;
+
+    device = records_[*index];
+    return true;
+}
+
+void DeviceCache::update(uint64_t address, const std::function<void(CachedDevice&)>& update)
+{
+    std::scoped_lock lk(mutex_);
+    if (CachedDevice* device = slot_for_locked(address))
+    {
+        update(*device);
+        device->address = address;
+        device->last_seen_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+}
+
+void DeviceCache::for_each(const std::function<void(const CachedDevice&)>& visit) const
+{
+    std::scoped_lock lk(mutex_);
+    index_.for_each([this, &visit](uint64_t, uint32_t index)
+    {
+        visit(records_[index]);
+    });
+}
+
+void DeviceCache::flush()
+{
+    std::scoped_lock lk(mutex_);
+    file_.flush();
+}
+
+auto DeviceCache::slot_for_locked(uint64_t address) -> CachedDevice*
+{
+    if (records_ == nullptr || address == 0) return nullptr;
+
+    if (const uint32_t* index = index_.find(address))
+    {
+        return &records_[*index];
+    }
+
+    uint32_t slot = 0;
+    for (uint32_t i = 0; i < k_capacity; i++)
+    {
+        if (records_[i].address == 0)
+        {
+            slot = i;
+            break;
+        }
+        if (records_[i].last_seen_ms < records_[slot].last_seen_ms)
+        {
+            slot = i;
+        }
+    }
+
+    if (records_[slot].address != 0)
+    {
+        index_.erase(records_[slot].address);
+    }
+    records_[slot] = CachedDevice{};
+    index_.try_emplace(address, slot);
+    return &records_[slot];
+}
+
+void DeviceCache::copy_string(char* destination, size_t capacity, std::string_view source)
+{
+    const size_t length = std::min(source.size(), capacity - 1);
+    std::memcpy(destination, source.data(), length);
+    std::memset(destination + length, 0, capacity - length);
+}
+
+auto DeviceCache::to_info(const CachedDevice& device) -> GDDeviceInfo
+{
+    GDDeviceInfo info{};
+    std::memcpy(info.name, device.name, sizeof(info.name));
+    info.name[sizeof(info.name) - 1] = '\0';
+    info.last_seen_ms = device.last_seen_ms;
+    info.die_type = device.die_type;
+    info.color = device.color;
+    info.battery = device.battery;
+    info.flags = device.flags;
+    return info;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "FlatAddressMap.h"
+#include "GoDiceDll.h"
+#include "MappedFile.h"
+
+// One die as stored on disk. The layout is the file format: fields are native-endian
+// and fixed-size, and a free slot has address 0.
+struct CachedDevice
+{
+    uint64_t address;
+    uint64_t last_seen_ms;
+    char name[32];
+    // Transport-specific handle to the GoDice GATT service (a WinRT service device id),
+    // so a reconnect can open it directly instead of rediscovering it
+    char service_id[208];
+    uint8_t die_type;
+    uint8_t color;
+    uint8_t battery;
+    uint8_t flags;
+    uint8_t reserved[4];
+};
+
+static_assert(sizeof(CachedDevice) == 264);
+
+// Memory-mapped table of every die the framework has seen, keyed by Bluetooth address.
+// Writes land in the mapping directly, so there is no save step; when the table is full
+// the least recently seen die is replaced. Safe to use from any thread.
+class DeviceCache
+{
+public:
+    static constexpr uint32_t k_capacity = 512;
+
+    // Empty on platforms where the cache is off unless a path is given
+    static auto default_path() -> std::string;
+
+    ~DeviceCache();
+
+    // A missing, truncated or incompatible file is (re)initialised empty
+    auto open(const std::string& path) -> bool;
+    void close();
+
+    [[nodiscard]] auto is_open() const -> bool;
+
+    auto find(uint64_t address, CachedDevice& device) const -> bool;
+
+    // Creates the entry if needed, lets `update` modify it in place and marks it seen
+    // now. Does nothing if the cache is closed.
+    void update(uint64_t address, const std::function<void(CachedDevice&)>& update);
+
+    void for_each(const std::function<void(const CachedDevice&)>& visit) const;
+
+    void flush();
+
+    static void copy_string(char* destination, size_t capacity, std::string_view source);
+
+    template <size_t N>
+    static void copy_string(char (&destination)[N], std::string_view source)
+    {
+        copy_string(destination, N, source);
+    }
+
+    static auto to_info(const CachedDevice& device) -> GDDeviceInfo;
+
+private:
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint32_t capacity;
+        uint32_t reserved[3];
+    };
+
+    static constexpr char k_magic[8] = { 'G', 'D', 'C', 'A', 'C', 'H', 'E', '\0' };
+    static constexpr uint32_t k_version = 1;
+
+    auto slot_for_locked(uint64_t address) -> CachedDevice*;
+
+    mutable std::mutex mutex_;
+    MappedFile file_;
+    CachedDevice* records_ = nullptr;
+    // address -> index into records_
+    FlatAddressMap<uint32_t> index_;
+};
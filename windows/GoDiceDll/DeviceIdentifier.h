@@ -0,0 +1,35 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Dice are identified to hosts by the decimal form of their 48-bit Bluetooth address.
+namespace godice
+{
+    constexpr size_t k_identifier_buffer_size = 24;
+
+    // Writes a NUL-terminated identifier into `buffer` without allocating
+    inline auto format_identifier(uint64_t address, char (&buffer)[k_identifier_buffer_size]) -> const char*
+    {
+        const auto result = std::to_chars(buffer, buffer + k_identifier_buffer_size - 1, address);
+        *result.ptr = '\0';
+        return buffer;
+    }
+
+    inline auto identifier_string(uint64_t address) -> std::string
+    {
+        char buffer[k_identifier_buffer_size];
+        return format_identifier(address, buffer);
+    }
+
+    inline auto parse_identifier(const char* identifier, uint64_t& address) -> bool
+    {
+        if (identifier == nullptr) return false;
+
+        const char* end = identifier + std::strlen(identifier);
+        const auto result = std::from_chars(identifier, end, address);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+}
@@ -0,0 +1,312 @@
+#include "DeviceStateTable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+
+#include "GoDiceProtocol.h"
+
+static constexpr auto is_stable(uint8_t roll) -> bool
+{
+    return roll >= GD_EVENT_STABLE && roll <= GD_EVENT_MOVE_STABLE;
+}
+
+// Read on every packet, and only has to tell a live die from a silent one, so a coarse
+// clock will do; a precise one can cost more than the rest of the update
+auto DeviceStateTable::now_ms() -> uint64_t
+{
+#if defined(_WIN32)
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    // 100ns ticks since 1601
+    return ((static_cast<uint64_t>(now.dwHighDateTime) << 32) | now.dwLowDateTime) / 10000 - 11644473600000ull;
+#elif defined(CLOCK_REALTIME_COARSE)
+    timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000 + static_cast<uint64_t>(now.tv_nsec) / 1000000;
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+#endif
+}
+
+auto DeviceStateTable::bucket(uint64_t address) -> uint32_t
+{
+    // Fibonacci hashing, as in FlatAddressMap
+    return static_cast<uint32_t>((address * 0x9E3779B97F4A7C15ull) >> 32) & (k_buckets - 1);
+}
+
+auto DeviceStateTable::find(uint64_t address) const -> uint32_t
+{
+    uint32_t b = bucket(address);
+    for (uint32_t probes = 0; probes < k_buckets; probes++, b = (b + 1) & (k_buckets - 1))
+    {
+        const uint64_t key = keys_[b].load(std::memory_order_acquire);
+        if (key == address) return indices_[b].load(std::memory_order_relaxed);
+        if (key == 0) return k_none;
+    }
+    return k_none;
+}
+
+void DeviceStateTable::lock_writer(uint32_t index)
+{
+    while (writing_[index].test_and_set(std::memory_order_acquire))
+    {
+        std::this_thread::yield();
+    }
+}
+
+void DeviceStateTable::unlock_writer(uint32_t index)
+{
+    writing_[index].clear(std::memory_order_release);
+}
+
+template <typename F>
+void DeviceStateTable::write_both(uint32_t index, F&& write)
+{
+    for (Copy& copy : copies_)
+    {
+        const uint32_t sequence = copy.sequence[index].load(std::memory_order_relaxed);
+        copy.sequence[index].store(sequence + 1, std::memory_order_relaxed);
+        // Keeps the stores below from becoming visible before the counter is odd
+        std::atomic_thread_fence(std::memory_order_release);
+        write(copy, index);
+        copy.sequence[index].store(sequence + 2, std::memory_order_release);
+    }
+}
+
+template <typename F>
+auto DeviceStateTable::update(uint64_t address, F&& write) -> bool
+{
+    const uint32_t index = find(address);
+    if (index == k_none) return false;
+
+    lock_writer(index);
+    // The slot may have been cleared and given to another die since it was found
+    const bool current = copies_[0].address[index].load(std::memory_order_relaxed) == address;
+    if (current)
+    {
+        write_both(index, write);
+    }
+    unlock_writer(index);
+    return current;
+}
+
+auto DeviceStateTable::classify(const Copy& copy, uint32_t index) -> uint8_t
+{
+    if (!is_stable(copy.roll[index].load(std::memory_order_relaxed))) return 0;
+
+    const GDVector vector{ copy.x[index].load(std::memory_order_relaxed), copy.y[index].load(std::memory_order_relaxed), copy.z[index].load(std::memory_order_relaxed) };
+    return godice_classify_face(copy.die_type[index].load(std::memory_order_relaxed), vector);
+}
+
+auto DeviceStateTable::add(uint64_t address) -> bool
+{
+    if (address == 0) return false;
+    if (find(address) != k_none) return true;
+
+    std::scoped_lock lk(mutex_);
+    if (find(address) != k_none) return true;
+
+    const uint32_t index = count_.load(std::memory_order_relaxed);
+    if (index == k_capacity) return false;
+
+    const uint64_t now = now_ms();
+    lock_writer(index);
+    write_both(index, [address, now](Copy& copy, uint32_t i)
+    {
+        copy.address[i].store(address, std::memory_order_relaxed);
+        copy.last_seen_ms[i].store(now, std::memory_order_relaxed);
+        copy.connection[i].store(GD_CONNECTION_NONE, std::memory_order_relaxed);
+        copy.roll[i].store(GD_EVENT_UNKNOWN, std::memory_order_relaxed);
+        copy.x[i].store(0, std::memory_order_relaxed);
+        copy.y[i].store(0, std::memory_order_relaxed);
+        copy.z[i].store(0, std::memory_order_relaxed);
+        copy.face[i].store(0, std::memory_order_relaxed);
+        copy.die_type[i].store(GD_DIE_D6, std::memory_order_relaxed);
+        copy.color[i].store(0, std::memory_order_relaxed);
+        copy.battery[i].store(0, std::memory_order_relaxed);
+        copy.flags[i].store(0, std::memory_order_relaxed);
+        copy.rssi[i].store(0, std::memory_order_relaxed);
+    });
+    unlock_writer(index);
+
+    uint32_t b = bucket(address);
+    while (keys_[b].load(std::memory_order_relaxed) != 0)
+    {
+        b = (b + 1) & (k_buckets - 1);
+    }
+    indices_[b].store(index, std::memory_order_relaxed);
+    keys_[b].store(address, std::memory_order_release);
+    count_.store(index + 1, std::memory_order_release);
+    return true;
+}
+
+void DeviceStateTable::restore(uint64_t address, const GDDeviceInfo& info)
+{
+    if (!add(address)) return;
+
+    update(address, [&info](Copy& copy, uint32_t index)
+    {
+        copy.last_seen_ms[index].store(info.last_seen_ms, std::memory_order_relaxed);
+        if ((info.flags & GD_DEVICE_HAS_DIE_TYPE) != 0)
+        {
+            copy.die_type[index].store(info.die_type, std::memory_order_relaxed);
+        }
+        copy.color[index].store(info.color, std::memory_order_relaxed);
+        copy.battery[index].store(info.battery, std::memory_order_relaxed);
+        copy.flags[index].store(info.flags, std::memory_order_relaxed);
+    });
+}
+
+void DeviceStateTable::clear()
+{
+    std::scoped_lock lk(mutex_);
+    const uint32_t count = count_.load(std::memory_order_relaxed);
+    count_.store(0, std::memory_order_release);
+    for (auto& key : keys_)
+    {
+        key.store(0, std::memory_order_relaxed);
+    }
+    for (uint32_t index = 0; index < count; index++)
+    {
+        lock_writer(index);
+        write_both(index, [](Copy& copy, uint32_t i)
+        {
+            copy.address[i].store(0, std::memory_order_relaxed);
+        });
+        unlock_writer(index);
+    }
+}
+
+void DeviceStateTable::advertised(uint64_t address, int16_t rssi)
+{
+    const uint64_t now = now_ms();
+    update(address, [rssi, now](Copy& copy, uint32_t index)
+    {
+        copy.last_seen_ms[index].store(now, std::memory_order_relaxed);
+        copy.rssi[index].store(rssi, std::memory_order_relaxed);
+    });
+}
+
+void DeviceStateTable::notified(uint64_t address, const uint8_t* data, uint32_t size)
+{
+    GDEvent event;
+    godice::protocol::decode(data, size, event);
+    const uint64_t now = now_ms();
+
+    // The copies hold the same die type, so the first one's face does for both
+    uint8_t face = k_unclassified;
+    update(address, [&event, now, &face](Copy& copy, uint32_t index)
+    {
+        copy.last_seen_ms[index].store(now, std::memory_order_relaxed);
+        switch (event.type)
+        {
+        case GD_EVENT_ROLL_STARTED:
+            copy.roll[index].store(GD_EVENT_ROLL_STARTED, std::memory_order_relaxed);
+            copy.face[index].store(0, std::memory_order_relaxed);
+            break;
+        case GD_EVENT_STABLE:
+        case GD_EVENT_FAKE_STABLE:
+        case GD_EVENT_TILT_STABLE:
+        case GD_EVENT_MOVE_STABLE:
+            copy.roll[index].store(static_cast<uint8_t>(event.type), std::memory_order_relaxed);
+            copy.x[index].store(event.x, std::memory_order_relaxed);
+            copy.y[index].store(event.y, std::memory_order_relaxed);
+            copy.z[index].store(event.z, std::memory_order_relaxed);
+            if (face == k_unclassified)
+            {
+                face = classify(copy, index);
+            }
+            copy.face[index].store(face, std::memory_order_relaxed);
+            break;
+        case GD_EVENT_BATTERY_LEVEL:
+            copy.battery[index].store(event.value, std::memory_order_relaxed);
+            copy.flags[index].fetch_or(GD_DEVICE_HAS_BATTERY, std::memory_order_relaxed);
+            break;
+        case GD_EVENT_COLOR:
+            copy.color[index].store(event.value, std::memory_order_relaxed);
+            copy.flags[index].fetch_or(GD_DEVICE_HAS_COLOR, std::memory_order_relaxed);
+            break;
+        default:
+            break;
+        }
+    });
+}
+
+void DeviceStateTable::set_connection(uint64_t address, GDConnectionState connection)
+{
+    update(address, [connection](Copy& copy, uint32_t index)
+    {
+        copy.connection[index].store(static_cast<uint8_t>(connection), std::memory_order_relaxed);
+        if (connection == GD_CONNECTION_CONNECTED)
+        {
+            copy.flags[index].fetch_or(GD_DEVICE_CONNECTED_BEFORE, std::memory_order_relaxed);
+        }
+    });
+}
+
+void DeviceStateTable::set_die_type(uint64_t address, uint8_t die_type)
+{
+    update(address, [die_type](Copy& copy, uint32_t index)
+    {
+        copy.die_type[index].store(die_type, std::memory_order_relaxed);
+        copy.flags[index].fetch_or(GD_DEVICE_HAS_DIE_TYPE, std::memory_order_relaxed);
+        copy.face[index].store(classify(copy, index), std::memory_order_relaxed);
+    });
+}
+
+auto DeviceStateTable::die_type(uint64_t address) const -> uint8_t
+{
+    const uint32_t index = find(address);
+    return index != k_none ? copies_[0].die_type[index].load(std::memory_order_relaxed) : static_cast<uint8_t>(GD_DIE_D6);
+}
+
+auto DeviceStateTable::snapshot(GDDeviceState* states, uint32_t max_states) const -> uint32_t
+{
+    if (states == nullptr) return 0;
+
+    const uint32_t count = std::min(count_.load(std::memory_order_acquire), max_states);
+    uint32_t copied = 0;
+    for (uint32_t index = 0; index < count; index++)
+    {
+        GDDeviceState& state = states[copied];
+        // A writer holds at most one copy odd at a time, so one of the two is always readable
+        for (uint32_t attempt = 0;; attempt++)
+        {
+            const Copy& copy = copies_[attempt & 1];
+            const uint32_t before = copy.sequence[index].load(std::memory_order_acquire);
+            if ((before & 1) != 0) continue;
+
+            state.device = copy.address[index].load(std::memory_order_relaxed);
+            state.last_seen_ms = copy.last_seen_ms[index].load(std::memory_order_relaxed);
+            state.connection = copy.connection[index].load(std::memory_order_relaxed);
+            state.roll = copy.roll[index].load(std::memory_order_relaxed);
+            state.vector = GDVector{ copy.x[index].load(std::memory_order_relaxed), copy.y[index].load(std::memory_order_relaxed), copy.z[index].load(std::memory_order_relaxed) };
+            state.face = copy.face[index].load(std::memory_order_relaxed);
+            state.die_type = copy.die_type[index].load(std::memory_order_relaxed);
+            state.color = copy.color[index].load(std::memory_order_relaxed);
+            state.battery = copy.battery[index].load(std::memory_order_relaxed);
+            state.flags = copy.flags[index].load(std::memory_order_relaxed);
+            state.rssi = copy.rssi[index].load(std::memory_order_relaxed);
+
+            // Keeps the loads above from moving past the second read of the counter
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (copy.sequence[index].load(std::memory_order_relaxed) == before) break;
+        }
+
+        // Cleared while we were copying
+        if (state.device != 0)
+        {
+            copied++;
+        }
+    }
+    return copied;
+}
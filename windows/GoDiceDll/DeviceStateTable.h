@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "GoDiceDll.h"
+
+// The latest known state of every die, for godice_snapshot. Each field is an array of
+// its own, indexed by the order dice were first seen. Every die is kept twice, each
+// copy guarded by a sequence counter that a writer makes odd while it stores; a
+// writer updates one copy and then the other. A reader copies whichever is even and
+// starts again if its counter moved, so even a writer preempted halfway leaves a
+// whole copy to read. Readers take no lock and write nothing, so a render thread
+// polling every frame never waits for the transport, or holds it up.
+//
+// Addresses find their index through an insert-only hash of atomics, so updates are
+// lock free too; only adding a die and clearing the table take the mutex.
+class DeviceStateTable
+{
+public:
+    static constexpr uint32_t k_capacity = GD_MAX_DEVICES;
+
+    DeviceStateTable() = default;
+
+    DeviceStateTable(const DeviceStateTable&) = delete;
+    DeviceStateTable& operator=(const DeviceStateTable&) = delete;
+
+    // Returns false if the table is full. Adding a die twice changes nothing.
+    auto add(uint64_t address) -> bool;
+    // Dice from the device cache, before they are seen in this run
+    void restore(uint64_t address, const GDDeviceInfo& info);
+    // Forgets every die
+    void clear();
+
+    // Updates for dice that were never added are dropped. Safe to call from any thread.
+    void advertised(uint64_t address, int16_t rssi);
+    void notified(uint64_t address, const uint8_t* data, uint32_t size);
+    void set_connection(uint64_t address, GDConnectionState connection);
+    void set_die_type(uint64_t address, uint8_t die_type);
+
+    // GD_DIE_D6 unless the die has one of its own
+    [[nodiscard]] auto die_type(uint64_t address) const -> uint8_t;
+
+    auto snapshot(GDDeviceState* states, uint32_t max_states) const -> uint32_t;
+
+private:
+    static constexpr uint32_t k_buckets = k_capacity * 2;
+    static constexpr uint32_t k_none = ~0u;
+    static constexpr uint8_t k_unclassified = 0xFF;
+
+    static auto now_ms() -> uint64_t;
+    static auto bucket(uint64_t address) -> uint32_t;
+
+    template <typename T>
+    using Column = std::array<std::atomic<T>, k_capacity>;
+
+    struct Copy
+    {
+        Column<uint32_t> sequence;
+        // 0 for a slot that was cleared
+        Column<uint64_t> address;
+        Column<uint64_t> last_seen_ms;
+        Column<uint8_t> connection;
+        Column<uint8_t> roll;
+        Column<int8_t> x;
+        Column<int8_t> y;
+        Column<int8_t> z;
+        Column<uint8_t> face;
+        Column<uint8_t> die_type;
+        Column<uint8_t> color;
+        Column<uint8_t> battery;
+        Column<uint8_t> flags;
+        Column<int16_t> rssi;
+    };
+
+    [[nodiscard]] auto find(uint64_t address) const -> uint32_t;
+    // Runs write(copy, index) on both copies of the die; returns false if it is unknown
+    template <typename F>
+    auto update(uint64_t address, F&& write) -> bool;
+    // Only call with the die's writer lock held
+    template <typename F>
+    void write_both(uint32_t index, F&& write);
+    void lock_writer(uint32_t index);
+    void unlock_writer(uint32_t index);
+    // 0 unless the die is at rest
+    static auto classify(const Copy& copy, uint32_t index) -> uint8_t;
+
+    std::mutex mutex_;
+    std::atomic<uint32_t> count_ = 0;
+    std::array<std::atomic<uint64_t>, k_buckets> keys_;
+    std::array<std::atomic<uint32_t>, k_buckets> indices_;
+
+    // Held by whoever is writing a die, so two writers do not interleave their copies
+    std::array<std::atomic_flag, k_capacity> writing_;
+    std::array<Copy, 2> copies_;
+};
@@ -0,0 +1,653 @@
+#include "Executor.h"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "Trace.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define EXECUTOR_CPU_RELAX() _mm_pause()
+#elif defined(__x86_64__) || defined(__i386__)
+#define EXECUTOR_CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define EXECUTOR_CPU_RELAX() asm volatile("yield")
+#else
+#define EXECUTOR_CPU_RELAX() ((void)0)
+#endif
+
+namespace
+{
+    constexpr uint32_t k_min_default_threads = 2;
+    constexpr uint32_t k_max_default_threads = 8;
+
+    // Which executor, if any, the current thread works for
+    struct CurrentWorker
+    {
+        const void* executor = nullptr;
+        uint32_t index = 0;
+    };
+    thread_local CurrentWorker t_current;
+    // The strand whose tasks the current thread is running, if any
+    thread_local const Strand* t_draining = nullptr;
+
+    struct SharedSettings
+    {
+        std::mutex mutex;
+        GDExecutorConfig config = Executor::default_config();
+        bool started = false;
+    };
+
+    // Queues are globals that may post during static initialization
+    auto shared_settings() -> SharedSettings&
+    {
+        static SharedSettings settings;
+        return settings;
+    }
+
+    // The cpu for worker `index`: the index-th bit set in the mask, wrapping around
+    auto cpu_for(uint64_t mask, uint32_t index) -> int
+    {
+        const int cpus = std::popcount(mask);
+        int skip = static_cast<int>(index % static_cast<uint32_t>(cpus));
+        for (int cpu = 0; cpu < 64; cpu++)
+        {
+            if ((mask >> cpu & 1) != 0 && skip-- == 0) return cpu;
+        }
+        return -1;
+    }
+}
+
+auto Executor::default_config() -> GDExecutorConfig
+{
+    GDExecutorConfig config{};
+    config.threads = std::clamp(std::thread::hardware_concurrency(), k_min_default_threads, k_max_default_threads);
+    return config;
+}
+
+auto Executor::configure(const GDExecutorConfig& config) -> bool
+{
+    SharedSettings& settings = shared_settings();
+    std::scoped_lock lk(settings.mutex);
+    if (settings.started) return false;
+
+    settings.config = config;
+    return true;
+}
+
+auto Executor::shared() -> Executor&
+{
+    // First used once the strands that post to it are constructed, so it is destroyed,
+    // and its workers joined, before them
+    static Executor executor([]
+    {
+        SharedSettings& settings = shared_settings();
+        std::scoped_lock lk(settings.mutex);
+        settings.started = true;
+        return settings.config;
+    }());
+    return executor;
+}
+
+Executor::Executor(const GDExecutorConfig& config, std::string name)
+    : config_(config),
+      name_(std::move(name)),
+      spin_iterations_(std::thread::hardware_concurrency() > 1 ? k_spin_iterations : 0)
+{
+    const uint32_t threads = config.threads != 0 ? config.threads : default_config().threads;
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    // Only once every worker exists, since each may steal from any other
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        workers_[i]->thread = std::thread(&Executor::run_worker, this, i);
+    }
+}
+
+Executor::~Executor()
+{
+    stop();
+}
+
+void Executor::stop()
+{
+    if (!keep_running_.exchange(false)) return;
+
+    wake_sequence_.fetch_add(1, std::memory_order_release);
+    wake_sequence_.notify_all();
+    for (const auto& worker : workers_)
+    {
+        worker->thread.join();
+    }
+}
+
+void Executor::post(WorkItem&& item)
+{
+    if (t_current.executor == this)
+    {
+        push(*workers_[t_current.index], std::move(item));
+        return;
+    }
+    const uint32_t index = next_worker_.fetch_add(1, std::memory_order_relaxed) % thread_count();
+    push(*workers_[index], std::move(item));
+}
+
+void Executor::push(Worker& worker, WorkItem&& item)
+{
+    {
+        std::scoped_lock lk(worker.mutex);
+        worker.tasks.push_back(std::move(item));
+        worker.size.store(worker.tasks.size(), std::memory_order_relaxed);
+    }
+    wake_one();
+}
+
+void Executor::wake_one()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // Only posts that find a worker asleep pay for the notify
+    if (sleepers_.load(std::memory_order_relaxed) > 0)
+    {
+        wake_sequence_.fetch_add(1, std::memory_order_release);
+        wake_sequence_.notify_one();
+    }
+}
+
+auto Executor::take(uint32_t index, WorkItem& item) -> bool
+{
+    // Our own tasks in the order they were posted, then the newest of someone else's
+    const uint32_t count = thread_count();
+    for (uint32_t offset = 0; offset < count; offset++)
+    {
+        Worker& worker = *workers_[(index + offset) % count];
+        if (worker.size.load(std::memory_order_relaxed) == 0) continue;
+
+        std::scoped_lock lk(worker.mutex);
+        if (worker.tasks.empty()) continue;
+
+        if (offset == 0)
+        {
+            item = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        }
+        else
+        {
+            item = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+            steals_.add();
+        }
+        worker.size.store(worker.tasks.size(), std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+auto Executor::has_work() const -> bool
+{
+    return std::any_of(workers_.begin(), workers_.end(), [](const auto& worker)
+    {
+        return worker->size.load(std::memory_order_relaxed) > 0;
+    });
+}
+
+// Best effort: a pool that could not be pinned or reprioritised still runs
+void Executor::apply_thread_settings(uint32_t index) const
+{
+#if defined(_WIN32)
+    if (config_.affinity_mask != 0)
+    {
+        SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu_for(config_.affinity_mask, index));
+    }
+    // THREAD_PRIORITY_LOWEST is -2 and THREAD_PRIORITY_HIGHEST is 2
+    if (config_.priority != 0)
+    {
+        SetThreadPriority(GetCurrentThread(), std::clamp(config_.priority, -2, 2));
+    }
+#elif defined(__linux__)
+    if (config_.affinity_mask != 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu_for(config_.affinity_mask, index), &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    // A nice value for this thread alone; raising priority needs CAP_SYS_NICE
+    if (config_.priority != 0)
+    {
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), -5 * std::clamp(config_.priority, -2, 2));
+    }
+#else
+    (void)index;
+#endif
+}
+
+void Executor::run_worker(uint32_t index)
+{
+    t_current = { this, index };
+    godice::trace::name_thread(name_ + " " + std::to_string(index));
+    apply_thread_settings(index);
+
+    WorkItem item;
+    int idle_spins = 0;
+    while (keep_running_.load(std::memory_order_relaxed))
+    {
+        if (take(index, item))
+        {
+            item();
+            item = nullptr;
+            idle_spins = 0;
+            continue;
+        }
+
+        if (idle_spins < spin_iterations_)
+        {
+            idle_spins++;
+            EXECUTOR_CPU_RELAX();
+            continue;
+        }
+
+        // Park. Counting ourselves asleep and then re-checking (with a full fence on both
+        // sides) guarantees a poster either sees a sleeper or we see its task.
+        const uint32_t key = wake_sequence_.load(std::memory_order_acquire);
+        sleepers_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (!has_work() && keep_running_.load(std::memory_order_relaxed))
+        {
+            wake_sequence_.wait(key, std::memory_order_acquire);
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        idle_spins = 0;
+    }
+}
+
+void StrandStats::snapshot(GDQueueStats& stats) const
+{
+    // Finished tasks first, so while they are moving the depth errs high rather than below zero
+    stats.executed = executed.load();
+    stats.dropped = dropped.load();
+    stats.coalesced = coalesced.load();
+    stats.enqueued = enqueued.load();
+    const uint64_t finished = stats.executed + stats.dropped + stats.coalesced;
+    stats.depth = stats.enqueued > finished ? stats.enqueued - finished : 0;
+    stats.promoted = promoted.load();
+    wait.snapshot(stats.wait);
+    run.snapshot(stats.run);
+    for (size_t i = 0; i < priority_wait.size(); i++)
+    {
+        priority_wait[i].snapshot(stats.priority_wait[i]);
+    }
+}
+
+Strand::Strand(std::string name, StrandStats& stats, size_t capacity, Executor* executor)
+    : name_(std::move(name)), stats_(stats), executor_(executor)
+{
+    for (auto& lane : lanes_)
+    {
+        lane = std::make_unique<Lane>(capacity);
+    }
+}
+
+void Strand::configure(WorkPriority priority, const GDQueueConfig& config)
+{
+    Lane& lane = *lanes_[static_cast<size_t>(priority)];
+    lane.capacity = std::clamp<uint32_t>(config.capacity, 1, lane.ring_capacity);
+    lane.overflow = config.overflow <= GD_OVERFLOW_DROP_NEWEST ? config.overflow : static_cast<uint32_t>(GD_OVERFLOW_BLOCK);
+    lane.coalesce = config.coalesce;
+
+    // Producers parked on the old capacity or policy look again
+    std::scoped_lock lk(lane.room_mutex);
+    lane.room.notify_all();
+}
+
+void Strand::enqueue(const WorkItem& item, WorkPriority priority)
+{
+    enqueue(WorkItem(item), priority);
+}
+
+void Strand::enqueue(WorkItem&& item, WorkPriority priority, Clock::time_point deadline)
+{
+    const auto index = static_cast<size_t>(priority);
+    push(index, make_task(index, std::move(item), deadline), Push::Bounded);
+}
+
+void Strand::enqueue_latest(uint64_t key, WorkItem&& item, WorkPriority priority)
+{
+    const auto index = static_cast<size_t>(priority);
+    Lane& lane = *lanes_[index];
+    if (!lane.coalesce.load(std::memory_order_relaxed))
+    {
+        enqueue(std::move(item), priority);
+        return;
+    }
+
+    Task placeholder = make_task(index, nullptr, {});
+    placeholder.key = key;
+    {
+        std::scoped_lock lk(lane.latest_mutex);
+        if (WorkItem* queued = lane.latest.find(key))
+        {
+            *queued = std::move(item);
+            stats_.coalesced.add();
+            return;
+        }
+        lane.latest.try_emplace(key, std::move(item));
+    }
+    push(index, std::move(placeholder), Push::Bounded);
+}
+
+void Strand::enqueue_unbounded(WorkItem&& item, WorkPriority priority)
+{
+    const auto index = static_cast<size_t>(priority);
+    push(index, make_task(index, std::move(item), {}), Push::Unbounded);
+}
+
+auto Strand::make_task(size_t index, WorkItem&& item, Clock::time_point deadline) -> Task
+{
+    // Reading the clock twice for every item would cost as much as the strand itself; tracing times them all.
+    // A lane with a deadline reads it anyway.
+    thread_local uint32_t untimed = 0;
+    const bool timed = ++untimed % k_timing_interval == 0 || godice::trace::enabled() ||
+                       deadline != Clock::time_point{} || k_max_wait[index] != Clock::duration::zero();
+    const auto now = timed ? Clock::now() : Clock::time_point{};
+    if (deadline == Clock::time_point{} && k_max_wait[index] != Clock::duration::zero())
+    {
+        deadline = now + k_max_wait[index];
+    }
+    stats_.enqueued.add();
+    return Task{ std::move(item), now, deadline };
+}
+
+auto Strand::push(size_t index, Task&& task, Push mode) -> bool
+{
+    Lane& lane = *lanes_[index];
+    if (mode == Push::Unbounded)
+    {
+        lane.slots.fetch_add(1);
+    }
+    while (mode == Push::Bounded && !reserve(lane))
+    {
+        const uint32_t overflow = lane.overflow.load(std::memory_order_relaxed);
+        if (overflow == GD_OVERFLOW_DROP_NEWEST)
+        {
+            discard(lane, task);
+            return false;
+        }
+        // This task takes the oldest's slot, and the strand is already scheduled for it
+        if (overflow == GD_OVERFLOW_DROP_OLDEST && replace_oldest(lane, task)) return true;
+        if (!may_wait())
+        {
+            lane.slots.fetch_add(1);
+            break;
+        }
+        // Blocking, or the lane's only tasks are at the head or running
+        wait_for_room(lane);
+    }
+
+    if (append(lane, std::move(task)))
+    {
+        lane.available.fetch_add(1, std::memory_order_release);
+    }
+    if (pending_.fetch_add(1, std::memory_order_acq_rel) == 0)
+    {
+        schedule();
+    }
+    return true;
+}
+
+auto Strand::reserve(Lane& lane) -> bool
+{
+    uint32_t slots = lane.slots.load();
+    while (slots < lane.capacity.load(std::memory_order_relaxed))
+    {
+        if (lane.slots.compare_exchange_weak(slots, slots + 1)) return true;
+    }
+    return false;
+}
+
+void Strand::wait_for_room(Lane& lane) const
+{
+    std::unique_lock lk(lane.room_mutex);
+    // Counted before looking at the slots, and release() frees a slot before looking at
+    // the waiters (both sequentially consistent), so one of the two sees the other
+    lane.waiters.fetch_add(1);
+    lane.room.wait_for(lk, k_room_recheck, [&]
+    {
+        return lane.slots.load() < lane.capacity.load(std::memory_order_relaxed) || !may_wait();
+    });
+    lane.waiters.fetch_sub(1);
+}
+
+void Strand::release(Lane& lane)
+{
+    const uint32_t slots = lane.slots.fetch_sub(1) - 1;
+    if (lane.waiters.load() == 0) return;
+
+    // Parked producers are woken together once a quarter of the lane is free, rather
+    // than one wake per task
+    const uint32_t capacity = lane.capacity.load(std::memory_order_relaxed);
+    if (slots < capacity && capacity - slots >= std::max(capacity / 4, 1u))
+    {
+        std::scoped_lock lk(lane.room_mutex);
+        lane.room.notify_all();
+    }
+}
+
+auto Strand::append(Lane& lane, Task&& task) -> bool
+{
+    if (lane.spilled.load(std::memory_order_acquire) > 0 && spill(lane, task, true)) return false;
+    if (lane.ring.try_push(std::move(task))) return true;
+
+    spill(lane, task, false);
+    return false;
+}
+
+auto Strand::spill(Lane& lane, Task& task, bool behind) -> bool
+{
+    std::scoped_lock lk(lane.spill_mutex);
+    if (behind && lane.spill.empty()) return false;
+
+    lane.spill.push_back(std::move(task));
+    lane.spilled.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+auto Strand::replace_oldest(Lane& lane, Task& task) -> bool
+{
+    Task oldest;
+    bool from_ring = false;
+    {
+        std::scoped_lock lk(lane.take_mutex);
+        while (!from_ring && lane.available.load(std::memory_order_acquire) > 0)
+        {
+            from_ring = lane.ring.try_pop(oldest);
+            if (!from_ring)
+            {
+                std::this_thread::yield();
+            }
+        }
+        if (!from_ring)
+        {
+            // Only spilled tasks are left, so this one goes to the back of the spill
+            std::scoped_lock spill_lk(lane.spill_mutex);
+            if (lane.spill.empty()) return false;
+
+            oldest = std::move(lane.spill.front());
+            lane.spill.pop_front();
+            lane.spill.push_back(std::move(task));
+        }
+    }
+    discard(lane, oldest);
+
+    // The oldest's place in available is this task's, unless it has to spill
+    if (from_ring && !append(lane, std::move(task)))
+    {
+        lane.available.fetch_sub(1, std::memory_order_release);
+    }
+    return true;
+}
+
+// The ring before the spill, since anything spilled was queued after it
+auto Strand::take(Lane& lane, Task& task) -> bool
+{
+    std::scoped_lock lk(lane.take_mutex);
+    // Counted only after its push finished, but an earlier push may still be completing.
+    // A count held for a task that is spilling instead goes away once it has.
+    while (lane.available.load(std::memory_order_acquire) > 0)
+    {
+        if (lane.ring.try_pop(task))
+        {
+            lane.available.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        std::this_thread::yield();
+    }
+
+    std::scoped_lock spill_lk(lane.spill_mutex);
+    if (lane.spill.empty()) return false;
+
+    task = std::move(lane.spill.front());
+    lane.spill.pop_front();
+    lane.spilled.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+void Strand::discard(Lane& lane, Task& task)
+{
+    if (task.key != 0)
+    {
+        std::scoped_lock lk(lane.latest_mutex);
+        lane.latest.erase(task.key);
+    }
+    task.work = nullptr;
+    stats_.dropped.add();
+}
+
+auto Strand::may_wait() const -> bool
+{
+    // A strand task that waited for room could wait forever: on its own strand, or on
+    // one whose tasks are themselves waiting for room on this one. Once the executor has
+    // stopped, nothing makes room at all.
+    return t_draining == nullptr && executor().running();
+}
+
+auto Strand::executor() const -> Executor&
+{
+    return executor_ != nullptr ? *executor_ : Executor::shared();
+}
+
+void Strand::schedule()
+{
+    executor().post([this] { drain(); });
+}
+
+void Strand::drain()
+{
+    t_draining = this;
+    const uint32_t batch = std::min(pending_.load(std::memory_order_acquire), k_batch);
+    for (uint32_t i = 0; i < batch; i++)
+    {
+        const size_t index = next_lane();
+        Lane& lane = *lanes_[index];
+        lane.has_head = false;
+        run(index, lane.head);
+        lane.head.work = nullptr;
+        release(lane);
+    }
+    t_draining = nullptr;
+
+    // Whatever arrived while we ran was not scheduled by its producer, so go round again
+    if (pending_.fetch_sub(batch, std::memory_order_acq_rel) > batch)
+    {
+        schedule();
+    }
+}
+
+// Only call while draining, with a task pending
+auto Strand::next_lane() -> size_t
+{
+    size_t first = k_lanes;
+    size_t due = k_lanes;
+    Clock::time_point now{};
+    for (size_t i = 0; i < k_lanes; i++)
+    {
+        Lane& lane = *lanes_[i];
+        if (!lane.has_head && lane.queued() > 0)
+        {
+            lane.has_head = take(lane, lane.head);
+        }
+        if (!lane.has_head) continue;
+
+        if (first == k_lanes)
+        {
+            first = i;
+            continue;
+        }
+        // A lower lane only needs the clock if its head has a deadline
+        if (lane.head.deadline == Clock::time_point{}) continue;
+        if (now == Clock::time_point{})
+        {
+            now = Clock::now();
+        }
+        if (lane.head.deadline <= now && (due == k_lanes || lane.head.deadline < lanes_[due]->head.deadline))
+        {
+            due = i;
+        }
+    }
+
+    // The first lane's own deadline is only worth beating if another one came sooner
+    if (due != k_lanes && !(lanes_[first]->head.deadline != Clock::time_point{} && lanes_[first]->head.deadline <= lanes_[due]->head.deadline))
+    {
+        stats_.promoted.add();
+        return due;
+    }
+    return first;
+}
+
+void Strand::run(size_t lane, Task& task)
+{
+    if (task.key != 0)
+    {
+        Lane& owner = *lanes_[lane];
+        std::scoped_lock lk(owner.latest_mutex);
+        if (WorkItem* latest = owner.latest.find(task.key))
+        {
+            task.work = std::move(*latest);
+            owner.latest.erase(task.key);
+        }
+    }
+
+    if (task.enqueued == Clock::time_point{})
+    {
+        task.work();
+    }
+    else
+    {
+        const auto started = Clock::now();
+        stats_.wait.record(started - task.enqueued);
+        stats_.priority_wait[lane].record(started - task.enqueued);
+        task.work();
+        const auto finished = Clock::now();
+        stats_.run.record(finished - started);
+
+        if (godice::trace::enabled())
+        {
+            godice::trace::complete(name_.c_str(), godice::trace::k_thread_track, started, finished, "wait_ns",
+                                    std::chrono::duration_cast<std::chrono::nanoseconds>(started - task.enqueued).count());
+        }
+    }
+    stats_.executed.add();
+}
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FlatAddressMap.h"
+#include "GoDiceDll.h"
+#include "MpscRing.h"
+#include "Stats.h"
+
+using WorkItem = std::function<void()>;
+
+// A pool of threads that each run their own deque of tasks and steal from the others
+// when theirs runs dry. Posting from a worker keeps the task on that worker; posting
+// from anywhere else spreads tasks round robin. Idle workers spin briefly, then park
+// with the same handshake as WorkQueue, so a post only pays for a wake when someone
+// is asleep.
+class Executor
+{
+public:
+    static auto default_config() -> GDExecutorConfig;
+
+    // Settings for shared(); returns false once it has started
+    static auto configure(const GDExecutorConfig& config) -> bool;
+    // Started on first use
+    static auto shared() -> Executor&;
+
+    explicit Executor(const GDExecutorConfig& config, std::string name = "Executor");
+    // Stops the workers; tasks still queued are dropped
+    ~Executor();
+
+    // Waits for the running tasks, then stops the workers. Later posts are accepted
+    // but never run, so threads that outlive the workers can still post safely.
+    void stop();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    void post(WorkItem&& item);
+
+    [[nodiscard]] auto thread_count() const -> uint32_t { return static_cast<uint32_t>(workers_.size()); }
+    [[nodiscard]] auto running() const -> bool { return keep_running_.load(std::memory_order_relaxed); }
+    [[nodiscard]] auto steals() const -> uint64_t { return steals_.load(); }
+
+private:
+    static constexpr int k_spin_iterations = 2000;
+
+    struct alignas(64) Worker
+    {
+        std::mutex mutex;
+        std::deque<WorkItem> tasks;
+        // Read without the lock to decide whether there is anything to steal
+        std::atomic<size_t> size = 0;
+        std::thread thread;
+    };
+
+    void run_worker(uint32_t index);
+    void apply_thread_settings(uint32_t index) const;
+    auto take(uint32_t index, WorkItem& item) -> bool;
+    [[nodiscard]] auto has_work() const -> bool;
+    void push(Worker& worker, WorkItem&& item);
+    void wake_one();
+
+    const GDExecutorConfig config_;
+    const std::string name_;
+    const int spin_iterations_;
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<uint32_t> next_worker_ = 0;
+
+    std::atomic<uint32_t> sleepers_ = 0;
+    std::atomic<uint32_t> wake_sequence_ = 0;
+    std::atomic<bool> keep_running_ = true;
+
+    StatCounter steals_;
+};
+
+enum class WorkPriority : uint32_t
+{
+    Data = GD_PRIORITY_DATA,
+    Control = GD_PRIORITY_CONTROL,
+    Discovery = GD_PRIORITY_DISCOVERY,
+};
+
+// What a group of strands reports as one GDQueueStats
+struct StrandStats
+{
+    StatCounter enqueued;
+    StatCounter executed;
+    StatCounter promoted;
+    StatCounter dropped;
+    StatCounter coalesced;
+    LatencyHistogram wait;
+    LatencyHistogram run;
+    std::array<LatencyHistogram, GD_PRIORITY_COUNT> priority_wait;
+
+    void snapshot(GDQueueStats& stats) const;
+};
+
+// Runs its tasks one at a time, on whichever executor thread is free. Strands with work
+// are scheduled on the executor, so tasks on different strands run in parallel. A
+// strand runs a bounded batch before giving its thread up, so a busy strand cannot
+// starve the others. Destroy a strand only after its executor.
+//
+// Each priority is a lane of its own, run in order. The highest lane with work goes
+// first, unless a task elsewhere has reached its deadline: those go first, earliest
+// deadline first. Lanes below Data give every task a deadline of its own, k_max_wait
+// after it was queued, so a steady stream of data cannot starve them.
+//
+// Each lane holds up to its configured capacity of tasks queued or running, and a
+// GDOverflowPolicy says what happens beyond that. Dropping the oldest takes it straight
+// out of the ring, so it works even while the strand is stuck in a task. Blocking parks
+// the producer until a task finishes. A task running on any strand never waits for
+// room: it queues past capacity into the lane's spill, an unbounded list behind the
+// ring, since the strand it waits on may be its own or may be waiting on it. A lane
+// that coalesces keeps keyed tasks in a table and queues a placeholder for each key; a
+// newer task with the same key replaces the one in the table until the placeholder runs.
+class Strand
+{
+public:
+    static constexpr size_t k_default_capacity = 4096;
+
+    using Clock = std::chrono::steady_clock;
+
+    // Capacity is per lane, and the most configure() can allow. A null executor means
+    // Executor::shared().
+    Strand(std::string name, StrandStats& stats, size_t capacity = k_default_capacity, Executor* executor = nullptr);
+
+    Strand(const Strand&) = delete;
+    Strand& operator=(const Strand&) = delete;
+
+    // Lanes start blocking at their full capacity, without coalescing. Safe from any
+    // thread; tasks already queued stay.
+    void configure(WorkPriority priority, const GDQueueConfig& config);
+
+    void enqueue(const WorkItem& item, WorkPriority priority = WorkPriority::Data);
+    // A deadline replaces the lane's own
+    void enqueue(WorkItem&& item, WorkPriority priority = WorkPriority::Data, Clock::time_point deadline = {});
+    // Replaces a task queued with the same key (never 0) if the lane coalesces
+    void enqueue_latest(uint64_t key, WorkItem&& item, WorkPriority priority);
+    // Never held back or dropped as the newest, for tasks that others queued before them
+    // depend on. Like any other task it may be dropped as the oldest.
+    void enqueue_unbounded(WorkItem&& item, WorkPriority priority);
+
+    [[nodiscard]] auto name() const -> const std::string& { return name_; }
+
+private:
+    static constexpr uint32_t k_batch = 64;
+    // Each producer thread times one item in this many, unless tracing is on or it has a deadline
+    static constexpr uint32_t k_timing_interval = 16;
+    static constexpr size_t k_lanes = GD_PRIORITY_COUNT;
+    // How often a parked producer looks again without being woken, which only matters
+    // once the executor has stopped
+    static constexpr auto k_room_recheck = std::chrono::milliseconds(50);
+    // How long each lane may be held up by the ones above it; zero for never
+    static constexpr std::array<Clock::duration, k_lanes> k_max_wait = {
+        Clock::duration::zero(),
+        std::chrono::milliseconds(20),
+        std::chrono::milliseconds(100),
+    };
+
+    struct Task
+    {
+        WorkItem work;
+        // Zero unless the item is timed
+        Clock::time_point enqueued;
+        // Zero for none
+        Clock::time_point deadline;
+        // Non-zero for a placeholder, whose work is in the lane's latest table
+        uint64_t key = 0;
+    };
+
+    struct alignas(64) Lane
+    {
+        explicit Lane(size_t capacity) : ring(capacity), ring_capacity(static_cast<uint32_t>(capacity)), capacity(ring_capacity) {}
+
+        MpscRing<Task> ring;
+        const uint32_t ring_capacity;
+        std::atomic<uint32_t> capacity;
+        std::atomic<uint32_t> overflow = GD_OVERFLOW_BLOCK;
+        std::atomic<bool> coalesce = false;
+        // Places held by tasks queued, at the head or running. A bounded push reserves one
+        // before it appends, so producers racing for the last place cannot overshoot.
+        std::atomic<uint32_t> slots = 0;
+        // Blocked producers park here until a drain frees a slot
+        std::mutex room_mutex;
+        std::condition_variable room;
+        std::atomic<uint32_t> waiters = 0;
+        // Pushed and not yet taken into head
+        std::atomic<uint32_t> available = 0;
+        // Held to take from the ring, by the strand and by producers dropping the oldest
+        std::mutex take_mutex;
+
+        std::mutex latest_mutex;
+        FlatAddressMap<WorkItem> latest;
+
+        // Tasks queued past a full ring, which only fills once pushes that may not wait have
+        // gone past capacity. Once anything is here, every push lands behind it, so each
+        // producer's tasks stay in order.
+        std::mutex spill_mutex;
+        std::deque<Task> spill;
+        std::atomic<uint32_t> spilled = 0;
+
+        // The next task, taken out of the ring so its deadline can be seen; only touched while draining
+        Task head;
+        bool has_head = false;
+
+        [[nodiscard]] auto queued() const -> uint32_t
+        {
+            return available.load(std::memory_order_acquire) + spilled.load(std::memory_order_acquire);
+        }
+    };
+
+    enum class Push
+    {
+        Bounded,
+        Unbounded,
+    };
+
+    // Returns false if the task was dropped
+    auto push(size_t index, Task&& task, Push mode) -> bool;
+    static auto reserve(Lane& lane) -> bool;
+    void wait_for_room(Lane& lane) const;
+    static void release(Lane& lane);
+    // Queues at the tail of the lane, in the ring or else the spill. Returns true if the
+    // task went into the ring, which the caller counts; a spilled task is counted here.
+    static auto append(Lane& lane, Task&& task) -> bool;
+    // With `behind`, only if something is spilled already
+    static auto spill(Lane& lane, Task& task, bool behind) -> bool;
+    // Drops the lane's oldest task for this one, which keeps the counts; false if the lane is empty
+    auto replace_oldest(Lane& lane, Task& task) -> bool;
+    static auto take(Lane& lane, Task& task) -> bool;
+    void discard(Lane& lane, Task& task);
+    // Only threads outside the strands wait for room, and only while the executor runs
+    [[nodiscard]] auto may_wait() const -> bool;
+    [[nodiscard]] auto executor() const -> Executor&;
+    void schedule();
+    void drain();
+    auto next_lane() -> size_t;
+    void run(size_t lane, Task& task);
+    auto make_task(size_t index, WorkItem&& item, Clock::time_point deadline) -> Task;
+
+    const std::string name_;
+    StrandStats& stats_;
+    Executor* const executor_;
+
+    std::array<std::unique_ptr<Lane>, k_lanes> lanes_;
+    // Tasks pushed and not yet run; the push that raises it from zero schedules the strand
+    std::atomic<uint32_t> pending_ = 0;
+};
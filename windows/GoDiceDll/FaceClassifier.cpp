@@ -0,0 +1,260 @@
+#include "FaceClassifier.h"
+
+#include <array>
+#include <cmath>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#define FACE_CLASSIFIER_X86 1
+#define FACE_CLASSIFIER_AVX2_TARGET
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FACE_CLASSIFIER_X86 1
+#define FACE_CLASSIFIER_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace godice::faces
+{
+    namespace
+    {
+        struct RawFace
+        {
+            int8_t x;
+            int8_t y;
+            int8_t z;
+            uint8_t value;
+        };
+
+        // Vectors reported by the die resting on each face, as published in the GoDice SDK
+        constexpr RawFace k_d6[] = {
+            { -64, 0, 0, 1 }, { 0, 0, 64, 2 }, { 0, 64, 0, 3 },
+            { 0, -64, 0, 4 }, { 0, 0, -64, 5 }, { 64, 0, 0, 6 },
+        };
+
+        constexpr RawFace k_d20[] = {
+            { -64, 0, -22, 1 }, { 42, -42, 40, 2 }, { 0, 22, -64, 3 }, { 0, 22, 64, 4 },
+            { -42, -42, 42, 5 }, { 22, 64, 0, 6 }, { -42, -42, -42, 7 }, { 64, 0, -22, 8 },
+            { -22, 64, 0, 9 }, { 42, -42, -42, 10 }, { -42, 42, 42, 11 }, { 22, -64, 0, 12 },
+            { -64, 0, 22, 13 }, { 42, 42, 42, 14 }, { -22, -64, 0, 15 }, { 42, 42, -42, 16 },
+            { 0, -22, -64, 17 }, { 0, -22, 64, 18 }, { -42, 42, -42, 19 }, { 64, 0, 22, 20 },
+        };
+
+        template <size_t N>
+        auto make_table(const RawFace (&faces)[N]) -> FaceTable
+        {
+            static_assert(N <= k_max_faces);
+
+            FaceTable table{};
+            table.count = N;
+            for (size_t i = 0; i < N; i++)
+            {
+                const float fx = faces[i].x, fy = faces[i].y, fz = faces[i].z;
+                const float length = std::sqrt(fx * fx + fy * fy + fz * fz);
+                table.x[i] = fx / length;
+                table.y[i] = fy / length;
+                table.z[i] = fz / length;
+                table.value[i] = faces[i].value;
+            }
+            return table;
+        }
+
+        // Indexed by GDDieType. The other shells get a table once their vectors are taken
+        // from the GoDice SDK's transforms; until then they classify as 0, not as a guess.
+        const std::array<FaceTable, 2> k_tables = {
+            make_table(k_d6),
+            make_table(k_d20),
+        };
+
+        inline auto score(const FaceTable& table, uint32_t face, float x, float y, float z) -> float
+        {
+            return (table.x[face] * x + table.y[face] * y) + table.z[face] * z;
+        }
+
+        void classify_scalar(const FaceTable& table, const GDVector* vectors, uint32_t count, uint8_t* faces)
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                faces[i] = classify(table, vectors[i]);
+            }
+        }
+
+#if defined(FACE_CLASSIFIER_X86)
+        void classify_sse(const FaceTable& table, const GDVector* vectors, uint32_t count, uint8_t* faces)
+        {
+            constexpr uint32_t k_lanes = 4;
+            alignas(16) float xs[k_lanes], ys[k_lanes], zs[k_lanes];
+            alignas(16) int32_t best[k_lanes];
+
+            uint32_t i = 0;
+            for (; i + k_lanes <= count; i += k_lanes)
+            {
+                for (uint32_t lane = 0; lane < k_lanes; lane++)
+                {
+                    xs[lane] = vectors[i + lane].x;
+                    ys[lane] = vectors[i + lane].y;
+                    zs[lane] = vectors[i + lane].z;
+                }
+                const __m128 x = _mm_load_ps(xs);
+                const __m128 y = _mm_load_ps(ys);
+                const __m128 z = _mm_load_ps(zs);
+
+                __m128 best_score = _mm_set1_ps(-INFINITY);
+                __m128i best_face = _mm_setzero_si128();
+                for (uint32_t f = 0; f < table.count; f++)
+                {
+                    const __m128 s = _mm_add_ps(
+                        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(table.x[f]), x), _mm_mul_ps(_mm_set1_ps(table.y[f]), y)),
+                        _mm_mul_ps(_mm_set1_ps(table.z[f]), z));
+                    const __m128 better = _mm_cmpgt_ps(s, best_score);
+                    best_score = _mm_max_ps(s, best_score);
+                    // SSE2 has no integer blend; select with and/andnot
+                    const __m128i mask = _mm_castps_si128(better);
+                    best_face = _mm_or_si128(_mm_and_si128(mask, _mm_set1_epi32(static_cast<int>(f))),
+                                             _mm_andnot_si128(mask, best_face));
+                }
+
+                _mm_store_si128(reinterpret_cast<__m128i*>(best), best_face);
+                for (uint32_t lane = 0; lane < k_lanes; lane++)
+                {
+                    faces[i + lane] = table.value[best[lane]];
+                }
+            }
+            classify_scalar(table, vectors + i, count - i, faces + i);
+        }
+
+        FACE_CLASSIFIER_AVX2_TARGET
+        void classify_avx2(const FaceTable& table, const GDVector* vectors, uint32_t count, uint8_t* faces)
+        {
+            constexpr uint32_t k_lanes = 8;
+            alignas(32) float xs[k_lanes], ys[k_lanes], zs[k_lanes];
+            alignas(32) int32_t best[k_lanes];
+
+            uint32_t i = 0;
+            for (; i + k_lanes <= count; i += k_lanes)
+            {
+                for (uint32_t lane = 0; lane < k_lanes; lane++)
+                {
+                    xs[lane] = vectors[i + lane].x;
+                    ys[lane] = vectors[i + lane].y;
+                    zs[lane] = vectors[i + lane].z;
+                }
+                const __m256 x = _mm256_load_ps(xs);
+                const __m256 y = _mm256_load_ps(ys);
+                const __m256 z = _mm256_load_ps(zs);
+
+                __m256 best_score = _mm256_set1_ps(-INFINITY);
+                __m256i best_face = _mm256_setzero_si256();
+                for (uint32_t f = 0; f < table.count; f++)
+                {
+                    const __m256 s = _mm256_add_ps(
+                        _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(table.x[f]), x), _mm256_mul_ps(_mm256_set1_ps(table.y[f]), y)),
+                        _mm256_mul_ps(_mm256_set1_ps(table.z[f]), z));
+                    const __m256 better = _mm256_cmp_ps(s, best_score, _CMP_GT_OQ);
+                    best_score = _mm256_max_ps(s, best_score);
+                    best_face = _mm256_blendv_epi8(best_face, _mm256_set1_epi32(static_cast<int>(f)), _mm256_castps_si256(better));
+                }
+
+                _mm256_store_si256(reinterpret_cast<__m256i*>(best), best_face);
+                for (uint32_t lane = 0; lane < k_lanes; lane++)
+                {
+                    faces[i + lane] = table.value[best[lane]];
+                }
+            }
+            classify_sse(table, vectors + i, count - i, faces + i);
+        }
+
+        auto cpu_has_avx2() -> bool
+        {
+#if defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) return false;
+
+            __cpuid(info, 1);
+            const bool osxsave = (info[2] & (1 << 27)) != 0;
+            const bool avx = (info[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+    }
+
+    auto table_for(uint32_t die_type) -> const FaceTable*
+    {
+        return die_type < k_tables.size() ? &k_tables[die_type] : nullptr;
+    }
+
+    auto best_isa() -> Isa
+    {
+#if defined(FACE_CLASSIFIER_X86)
+        static const Isa isa = cpu_has_avx2() ? Isa::Avx2 : Isa::Sse;
+        return isa;
+#else
+        return Isa::Scalar;
+#endif
+    }
+
+    auto classify(const FaceTable& table, GDVector vector) -> uint8_t
+    {
+        const float x = vector.x, y = vector.y, z = vector.z;
+
+        uint32_t best_face = 0;
+        float best_score = -INFINITY;
+        for (uint32_t f = 0; f < table.count; f++)
+        {
+            const float s = score(table, f, x, y, z);
+            if (s > best_score)
+            {
+                best_score = s;
+                best_face = f;
+            }
+        }
+        return table.value[best_face];
+    }
+
+    void classify_batch(const FaceTable& table, const GDVector* vectors, uint32_t count, uint8_t* faces, Isa isa)
+    {
+        switch (isa)
+        {
+#if defined(FACE_CLASSIFIER_X86)
+        case Isa::Avx2:
+            classify_avx2(table, vectors, count, faces);
+            return;
+        case Isa::Sse:
+            classify_sse(table, vectors, count, faces);
+            return;
+#endif
+        default:
+            classify_scalar(table, vectors, count, faces);
+            return;
+        }
+    }
+}
+
+uint8_t godice_classify_face(uint32_t die_type, GDVector vector)
+{
+    const auto* table = godice::faces::table_for(die_type);
+    return table != nullptr ? godice::faces::classify(*table, vector) : 0;
+}
+
+void godice_classify_faces(uint32_t die_type, uint32_t count, const GDVector* vectors, uint8_t* faces)
+{
+    if (vectors == nullptr || faces == nullptr) return;
+
+    const auto* table = godice::faces::table_for(die_type);
+    if (table == nullptr)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            faces[i] = 0;
+        }
+        return;
+    }
+    godice::faces::classify_batch(*table, vectors, count, faces, godice::faces::best_isa());
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+#include "GoDiceDll.h"
+
+// Nearest-neighbour mapping from a stable accelerometer vector to the face that is up.
+// Each die type has a table of unit face normals; the face whose normal has the
+// largest dot product with the reported vector wins, so the vector's magnitude
+// does not matter.
+namespace godice::faces
+{
+    constexpr uint32_t k_max_faces = 20;
+
+    // Structure-of-arrays so the batch kernels can broadcast one normal at a time
+    struct FaceTable
+    {
+        uint32_t count;
+        float x[k_max_faces];
+        float y[k_max_faces];
+        float z[k_max_faces];
+        uint8_t value[k_max_faces];
+    };
+
+    enum class Isa
+    {
+        Scalar,
+        Sse,
+        Avx2,
+    };
+
+    // nullptr for an unknown die type
+    auto table_for(uint32_t die_type) -> const FaceTable*;
+
+    // Best instruction set supported by this CPU and build
+    auto best_isa() -> Isa;
+
+    auto classify(const FaceTable& table, GDVector vector) -> uint8_t;
+    void classify_batch(const FaceTable& table, const GDVector* vectors, uint32_t count, uint8_t* faces, Isa isa);
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Open-addressing hash map keyed by a 48-bit Bluetooth address. Keys live in one
+// flat array with linear probing, so a lookup is a multiply and a short scan with
+// no allocation and no string handling. Two values that can never be a real
+// address mark empty and erased slots.
+//
+// Not synchronised; callers that share a map across threads guard it themselves
+// (a shared_mutex suits the read-mostly pattern of device registries).
+template <typename V>
+class FlatAddressMap
+{
+private:
+    static constexpr uint64_t k_empty = 0;
+    static constexpr uint64_t k_erased = ~0ull;
+    static constexpr size_t k_min_capacity = 64;
+
+    struct Slot
+    {
+        uint64_t key = k_empty;
+        V value{};
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_ = 0;
+    size_t size_ = 0;
+    // live entries plus erased markers; probing cost depends on both
+    size_t used_ = 0;
+
+    static auto hash(uint64_t key) -> size_t
+    {
+        // Fibonacci hashing; vendor prefixes make the high address bits nearly constant
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    static auto is_reserved(uint64_t key) -> bool { return key == k_empty || key == k_erased; }
+
+    auto find_slot(uint64_t key) const -> Slot*
+    {
+        if (slots_ == nullptr || is_reserved(key)) return nullptr;
+
+        for (size_t i = hash(key) & mask_;; i = (i + 1) & mask_)
+        {
+            Slot& slot = slots_[i];
+            if (slot.key == key) return &slot;
+            if (slot.key == k_empty) return nullptr;
+        }
+    }
+
+    void rehash(size_t capacity)
+    {
+        std::unique_ptr<Slot[]> old = std::move(slots_);
+        const size_t old_capacity = old != nullptr ? mask_ + 1 : 0;
+
+        slots_.reset(new Slot[capacity]);
+        mask_ = capacity - 1;
+        used_ = size_;
+
+        for (size_t i = 0; i < old_capacity; i++)
+        {
+            if (is_reserved(old[i].key)) continue;
+
+            size_t j = hash(old[i].key) & mask_;
+            while (slots_[j].key != k_empty)
+            {
+                j = (j + 1) & mask_;
+            }
+            slots_[j].key = old[i].key;
+            slots_[j].value = std::move(old[i].value);
+        }
+    }
+
+public:
+    FlatAddressMap() = default;
+    FlatAddressMap(const FlatAddressMap&) = delete;
+    FlatAddressMap& operator=(const FlatAddressMap&) = delete;
+
+    [[nodiscard]] auto size() const -> size_t { return size_; }
+    [[nodiscard]] auto empty() const -> bool { return size_ == 0; }
+
+    [[nodiscard]] auto find(uint64_t key) -> V*
+    {
+        Slot* slot = find_slot(key);
+        return slot != nullptr ? &slot->value : nullptr;
+    }
+
+    [[nodiscard]] auto find(uint64_t key) const -> const V*
+    {
+        const Slot* slot = find_slot(key);
+        return slot != nullptr ? &slot->value : nullptr;
+    }
+
+    [[nodiscard]] auto contains(uint64_t key) const -> bool { return find_slot(key) != nullptr; }
+
+    // Returns the stored value and whether it was inserted; an existing value is left alone
+    auto try_emplace(uint64_t key, V value) -> std::pair<V*, bool>
+    {
+        if (is_reserved(key)) return { nullptr, false };
+
+        if (Slot* existing = find_slot(key))
+        {
+            return { &existing->value, false };
+        }
+
+        // Keep at most 3/4 of the slots in use so probe sequences stay short
+        if (slots_ == nullptr || (used_ + 1) * 4 > (mask_ + 1) * 3)
+        {
+            size_t capacity = k_min_capacity;
+            while ((size_ + 1) * 2 > capacity)
+            {
+                capacity <<= 1;
+            }
+            rehash(capacity);
+        }
+
+        size_t i = hash(key) & mask_;
+        while (!is_reserved(slots_[i].key))
+        {
+            i = (i + 1) & mask_;
+        }
+
+        Slot& slot = slots_[i];
+        if (slot.key == k_empty)
+        {
+            used_++;
+        }
+        slot.key = key;
+        slot.value = std::move(value);
+        size_++;
+        return { &slot.value, true };
+    }
+
+    auto insert_or_assign(uint64_t key, V value) -> V*
+    {
+        V* stored = try_emplace(key, V{}).first;
+        if (stored != nullptr)
+        {
+            *stored = std::move(value);
+        }
+        return stored;
+    }
+
+    auto erase(uint64_t key) -> bool
+    {
+        Slot* slot = find_slot(key);
+        if (slot == nullptr) return false;
+
+        slot->key = k_erased;
+        slot->value = V{};
+        size_--;
+        return true;
+    }
+
+    void clear()
+    {
+        for (size_t i = 0; slots_ != nullptr && i <= mask_; i++)
+        {
+            slots_[i] = Slot{};
+        }
+        size_ = 0;
+        used_ = 0;
+    }
+
+    template <typename F>
+    void for_each(F&& f) const
+    {
+        for (size_t i = 0; slots_ != nullptr && i <= mask_; i++)
+        {
+            const Slot& slot = slots_[i];
+            if (!is_reserved(slot.key))
+            {
+                f(slot.key, slot.value);
+            }
+        }
+    }
+};
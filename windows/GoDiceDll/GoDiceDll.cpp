@@ -3,513 +3,643 @@
 
 #include "GoDiceDll.h"
 
-#include "stdafx.h"
-
-#include <ppltasks.h>
-#include <semaphore>
-#include <unordered_set>
-
-#include <pplawait.h>
-
-#include "WorkQueue.h"
-
-#pragma comment(lib, "windowsapp")
-
-// macro for file, see also https://stackoverflow.com/a/14421702
-#define __WFILE__ L"GoDiceDll.cpp"
-
-using namespace winrt;
-
-using namespace Windows::Devices::Bluetooth;
-using namespace Windows::Devices::Bluetooth::Advertisement;
-using namespace Windows::Devices::Bluetooth::GenericAttributeProfile;
-using namespace Windows::Devices::Enumeration;
-
-using namespace Windows::Storage::Streams;
-
-using Windows::Foundation::IAsyncOperation;
-using Windows::Foundation::IInspectable;
-
-static BluetoothLEAdvertisementWatcher g_watcher = nullptr;
-
-class DeviceSession;
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "AdvertisementCoalescer.h"
+#include "ConnectionScheduler.h"
+#include "DeviceCache.h"
+#include "DeviceIdentifier.h"
+#include "DeviceStateTable.h"
+#include "Executor.h"
+#include "FlatAddressMap.h"
+#include "GoDiceProtocol.h"
+#include "Log.h"
+#include "PacketPool.h"
+#include "PollQueue.h"
+#include "ReplayTransport.h"
+#include "RollAggregator.h"
+#include "SharedRing.h"
+#include "SharedTransport.h"
+#include "SimulatedTransport.h"
+#include "Stats.h"
+#include "Trace.h"
+#include "TrafficCapture.h"
+#include "Transport.h"
+#include "WritePipeline.h"
+
+struct Device;
 
 static GDDeviceFoundCallbackFunction g_device_found_callback = nullptr;
-static GDDataCallbackFunction g_data_received_callback = nullptr;
+// Read on the transport's threads too, like g_event_callback, to skip packets nobody is listening for
+static std::atomic<GDDataCallbackFunction> g_data_received_callback = nullptr;
 static GDDeviceConnectedCallbackFunction g_device_connected_callback = nullptr;
 static GDDeviceConnectionFailedCallbackFunction g_device_connection_failed_callback = nullptr;
 static GDDeviceDisconnectedCallbackFunction g_device_disconnected_callback = nullptr;
 static GDListenerStoppedCallbackFunction g_listener_stopped_callback = nullptr;
-static GDLogger g_logger = nullptr;
-
-using std::binary_semaphore;
-using std::exception;
-using std::function;
-using std::mutex;
+static std::atomic<GDEventCallbackFunction> g_event_callback = nullptr;
+// Only touched on the first callback strand, where throws are reported, so the pair
+// always changes together
+static GDThrowCallbackFunction g_throw_callback = nullptr;
+static void* g_throw_context = nullptr;
+
+using godice::log_info;
+using godice::log_warning;
 using std::shared_ptr;
 using std::string;
-using std::unordered_map;
-using std::unordered_set;
-
-static auto log(const char* str) -> void;
-static WorkQueue g_bluetooth_queue("BluetoothQueue");
-static WorkQueue g_callback_queue("CallbackQueue");
+using std::vector;
 
-static unordered_map<string, shared_ptr<DeviceSession>> g_devices_by_identifier;
-static unordered_set<string> g_devices_in_progress;
+// Declared before the queues so they outlive any work item still referring to them
+static PacketPool g_packet_pool(1024);
+static TrafficCapture g_capture;
+static SharedRingWriter g_publisher;
 
-static inline constexpr guid k_service_guid = guid("6e400001-b5a3-f393-e0a9-e50e24dcca9e");
-static inline constexpr guid k_write_guid = guid("6e400002-b5a3-f393-e0a9-e50e24dcca9e");
-static inline constexpr guid k_notify_guid = guid("6e400003-b5a3-f393-e0a9-e50e24dcca9e");
+// What the transport reports goes to the capture and to any processes reading from ours
+static void record_traffic(CaptureKind kind, uint64_t address, const void* payload = nullptr, uint32_t size = 0, int16_t rssi = 0)
+{
+    g_capture.record(kind, address, payload, size, rssi);
+    g_publisher.publish(kind, address, payload, size, rssi);
+}
 
-static void log(const char* str)
+// Updated from whichever thread sees the event; the queues and the write pipeline keep their own
+struct CoreStats
+{
+    StatCounter advertisements_received;
+    StatCounter advertisements_reported;
+    LatencyHistogram advertisement_handling;
+    StatCounter notifications_received;
+    StatCounter connect_attempts;
+    StatCounter connect_failures;
+    LatencyHistogram connect;
+    StatCounter link_losses;
+    LatencyHistogram write;
+};
+static CoreStats g_stats;
+// Looked up on every advertisement from the transport's thread, written only when
+// a die is first seen or renamed
+static std::shared_mutex g_devices_mutex;
+static FlatAddressMap<shared_ptr<const Device>> g_devices;
+static AdvertisementCoalescer g_advertisement_coalescer;
+static DeviceCache g_device_cache;
+// Written from whichever thread sees the change, read by godice_snapshot from any
+static DeviceStateTable g_device_states;
+static void start_write(uint64_t address, const vector<uint8_t>& payload, WriteMode mode, uint64_t id);
+
+// Only touched on the bluetooth queue
+static ConnectionScheduler g_connection_scheduler;
+static WritePipeline g_write_pipeline(start_write);
+static string g_device_cache_path = DeviceCache::default_path();
+static bool g_using_platform_transport = false;
+
+// Both run on the shared executor. Bluetooth work stays serial, since the transport and
+// the state above are only ever touched from it.
+static StrandStats g_bluetooth_stats;
+static StrandStats g_callback_stats;
+static Strand g_bluetooth_queue("BluetoothQueue", g_bluetooth_stats);
+
+// Each die's callbacks go to the same strand, so those of a priority stay in order.
+// Unless the host asks for parallel callbacks, every die shares the first one.
+static constexpr size_t k_callback_strands = 16;
+static constexpr uint32_t k_callback_capacity = 1024;
+
+// Device found coalesces per die, so discovery only drops once more dice than that are waiting
+static auto default_queue_config(WorkPriority priority) -> GDQueueConfig
 {
-    if (g_logger)
+    if (priority == WorkPriority::Discovery)
     {
-        g_logger(str);
+        return { k_callback_capacity, GD_OVERFLOW_DROP_OLDEST, true };
     }
+    return { k_callback_capacity, GD_OVERFLOW_BLOCK, false };
 }
 
-template <typename ...P>
-static void log(string &&format, P&&... args)
+static const vector<std::unique_ptr<Strand>> g_callback_strands = []
 {
-    if (g_logger)
+    vector<std::unique_ptr<Strand>> strands;
+    for (size_t i = 0; i < k_callback_strands; i++)
     {
-        auto formattedStr = std::vformat(format, std::make_format_args(args...));
-        g_logger(formattedStr.c_str());
+        auto& strand = strands.emplace_back(std::make_unique<Strand>("CallbackQueue", g_callback_stats, k_callback_capacity));
+        for (const auto priority : { WorkPriority::Data, WorkPriority::Control, WorkPriority::Discovery })
+        {
+            strand->configure(priority, default_queue_config(priority));
+        }
     }
-}
+    return strands;
+}();
+static std::atomic<bool> g_parallel_callbacks = false;
 
-static auto received_device_found_event(const BluetoothLEAdvertisementWatcher& watcher,
-                                        const BluetoothLEAdvertisementReceivedEventArgs& args) -> void;
+static PollQueue g_poll_queue;
 
-static auto on_queue_received_device_found_event(uint64_t btAddr) -> IAsyncOperation<bool>;
-static auto on_queue_internal_connect(const string& identifier) -> IAsyncOperation<bool>;
-static auto on_queue_send(const string& identifier, const IBuffer& buffer) -> IAsyncOperation<bool>;
-static auto internal_connection_changed_handler(const BluetoothLEDevice& dev, const string& identifier) -> void;
+static void report_throw(uint32_t group, vector<GDDieResult> results);
+// Fed from the transport's threads, so it must outlive them
+static RollAggregator g_roll_aggregator(report_throw);
 
-class DeviceSession : std::enable_shared_from_this<DeviceSession>
+// Immutable once published, so callbacks can hold one without further locking.
+// A rename replaces the entry.
+struct Device
 {
-private:
-    BluetoothLEDevice device_;
-    const uint64_t bluetoothAddress_;
-    const string identifier_;
-    const string name_;
-    GattDeviceService service_;
-    GattSession gatt_session_;
-    GattCharacteristic write_characteristic_;
-    GattCharacteristic notify_characteristic_;
-    event_token notify_token_;
-    event_token connection_status_changed_token_;
+    const uint64_t address;
+    const string identifier;
+    const string name;
+};
+
+class CoreTransportListener final : public TransportListener
+{
+public:
+    void on_advertisement(uint64_t address, std::string_view name, int16_t rssi) override;
+    void on_discovery_stopped() override;
+    void on_notification(uint64_t address, const uint8_t* data, uint32_t size) override;
+    void on_link_lost(uint64_t address) override;
+};
+
+static CoreTransportListener g_transport_listener;
+// Only set on the bluetooth queue, through use_transport()
+static shared_ptr<Transport> g_transport;
 
-    static inline binary_semaphore use_sema_ = binary_semaphore(1);
-    bool connected_ = false;
+static void open_device_cache();
 
-    IAsyncOperation<bool> lockedDisconnect()
+// Only call on the bluetooth queue. The shared executor starts after every global here,
+// so it is destroyed before them. The teardown below starts after it, so it runs first:
+// the workers stop, so no task touches g_transport any more, then the transport's
+// threads, while the executor and the strands they post to still exist.
+static void use_transport(shared_ptr<Transport> transport)
+{
+    struct Teardown
     {
-        NamedLog("Attempting to disconnect\n");
-        connected_ = false;
-        
-        if (notify_characteristic_ != nullptr)
-        {
-            try
-            {
-                co_await notify_characteristic_.WriteClientCharacteristicConfigurationDescriptorAsync(GattClientCharacteristicConfigurationDescriptorValue::None);
-                notify_characteristic_.ValueChanged(std::exchange(notify_token_, {}));
-            }
-            catch (winrt::hresult_error& e)
-            {
-                NamedLog("Failed to disconnect notify characteristic {}\n", e.code().value);
-            }
-            notify_characteristic_ = nullptr;
-        }
-        write_characteristic_ = nullptr;
-    
-        if (service_ != nullptr)
+        ~Teardown()
         {
-            service_.Close();
-            service_ = nullptr;
+            Executor::shared().stop();
+            g_transport.reset();
         }
-        if (device_ != nullptr)
+    };
+    static Teardown teardown;
+
+    g_transport = std::move(transport);
+    g_transport->set_listener(&g_transport_listener);
+}
+
+// Only call on the bluetooth queue
+static auto transport() -> Transport&
+{
+    if (g_transport == nullptr)
+    {
+        use_transport(make_platform_transport());
+        g_using_platform_transport = true;
+        open_device_cache();
+    }
+    return *g_transport;
+}
+
+// Transport completions arrive on transport threads; bring them back onto the bluetooth queue
+static auto on_bluetooth_queue(std::function<void(bool)> continuation) -> TransportCompletion
+{
+    return [continuation = std::move(continuation)](bool success)
+    {
+        g_bluetooth_queue.enqueue([continuation, success]
         {
-            device_.ConnectionStatusChanged(std::exchange(connection_status_changed_token_, {}));
-        }
+            continuation(success);
+        });
+    };
+}
+
+static void start_write(uint64_t address, const vector<uint8_t>& payload, WriteMode mode, uint64_t id)
+{
+    record_traffic(CaptureKind::Write, address, payload.data(), static_cast<uint32_t>(payload.size()));
+    transport().write(address, payload.data(), static_cast<uint32_t>(payload.size()), mode,
+                      on_bluetooth_queue([address, id, started = LatencyHistogram::Clock::now()](bool success)
+                      {
+                          g_stats.write.record_since(started);
+                          g_write_pipeline.completed(address, id, success);
+                      }));
+}
+
+static auto find_device(uint64_t address) -> shared_ptr<const Device>
+{
+    std::shared_lock lk(g_devices_mutex);
+    const auto* device = g_devices.find(address);
+    return device != nullptr ? *device : nullptr;
+}
 
-        co_return true;
+static auto find_device(const string& identifier) -> shared_ptr<const Device>
+{
+    uint64_t address;
+    return godice::parse_identifier(identifier.c_str(), address) ? find_device(address) : nullptr;
+}
+
+// Callbacks that are not about one die, such as listener stopped, use address 0
+static auto callback_queue(uint64_t address = 0) -> Strand&
+{
+    if (!g_parallel_callbacks.load(std::memory_order_relaxed)) return *g_callback_strands[0];
+
+    return *g_callback_strands[address % k_callback_strands];
+}
+
+static auto callback_queue(const string& identifier) -> Strand&
+{
+    uint64_t address = 0;
+    godice::parse_identifier(identifier.c_str(), address);
+    return callback_queue(address);
+}
+
+// Runs on the first callback strand. Faces are classified here, off the thread that saw
+// the last die settle.
+static void deliver_throw(uint32_t group, vector<GDDieResult>& results)
+{
+    if (g_throw_callback == nullptr) return;
+
+    for (GDDieResult& result : results)
+    {
+        if (result.event.type == GD_EVENT_UNKNOWN) continue;
+
+        result.face = godice_classify_face(g_device_states.die_type(result.device), GDVector{ result.event.x, result.event.y, result.event.z });
     }
+    TraceSpan span("throw callback");
+    g_throw_callback(g_throw_context, group, static_cast<uint32_t>(results.size()), results.data());
+}
 
-    static string GDSRErrorString(const GattDeviceServicesResult& result)
+// A throw goes behind the callbacks already queued for its dice. With parallel callbacks
+// those are on other strands too, so the throw passes through each of them first, and
+// the last to let it through hands it to the first strand.
+static void report_throw(uint32_t group, vector<GDDieResult> results)
+{
+    Strand& throw_queue = callback_queue();
+    vector<Strand*> strands;
+    for (const GDDieResult& result : results)
     {
-        switch (result.Status())
+        Strand* strand = &callback_queue(result.device);
+        if (strand != &throw_queue && std::find(strands.begin(), strands.end(), strand) == strands.end())
         {
-        case GattCommunicationStatus::Success:
-            return "success";
-        case GattCommunicationStatus::Unreachable:
-            return "unreachable";
-        case GattCommunicationStatus::ProtocolError:
-            return "protocol error: " + std::to_string(result.ProtocolError().Value());
-        case GattCommunicationStatus::AccessDenied:
-            return "access denied";
-        default:
-            return "unknown status";
+            strands.push_back(strand);
         }
     }
 
-    static string GCRErrorString(const GattCharacteristicsResult& result)
+    if (strands.empty())
     {
-        switch (result.Status())
+        throw_queue.enqueue([group, results = std::move(results)]() mutable
         {
-        case GattCommunicationStatus::Success:
-            return "success";
-        case GattCommunicationStatus::Unreachable:
-            return "unreachable";
-        case GattCommunicationStatus::ProtocolError:
-            return "protocol error: " + std::to_string(result.ProtocolError().Value());
-        case GattCommunicationStatus::AccessDenied:
-            return "access denied";
-        default:
-            return "unknown status";
-        }
+            deliver_throw(group, results);
+        }, WorkPriority::Data);
+        return;
     }
 
-    void NamedLog(const char* str)
+    struct PendingThrow
     {
-        log(("[" + name_ + "] " + str).c_str());
+        std::atomic<size_t> strands_left;
+        uint32_t group;
+        vector<GDDieResult> results;
+    };
+    const auto pending = std::make_shared<PendingThrow>(strands.size(), group, std::move(results));
+    for (Strand* strand : strands)
+    {
+        strand->enqueue([pending, &throw_queue]
+        {
+            if (pending->strands_left.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+            throw_queue.enqueue([pending]
+            {
+                deliver_throw(pending->group, pending->results);
+            }, WorkPriority::Data);
+        }, WorkPriority::Data);
     }
-    
-    template <typename ...P>
-    void NamedLog(string &&format, P&&... args)
+}
+
+// Callbacks queued for a device refer to it by raw pointer, so nothing is allocated
+// per advertisement. They are queued while holding g_devices_mutex; a device that is
+// replaced or forgotten is released from its callback strand after them, at the same
+// priority, and never dropped ahead of them.
+static void retire_devices(vector<shared_ptr<const Device>> retired)
+{
+    for (auto& device : retired)
     {
-        auto prefixed = "[" + name_ + "] " + format;
-        auto formattedStr = std::vformat(prefixed, std::make_format_args(args...));
-        log(formattedStr.c_str());
+        const uint64_t address = device->address;
+        callback_queue(address).enqueue_unbounded([device = std::move(device)] {}, WorkPriority::Discovery);
     }
+}
 
-    IAsyncOperation<bool> lockedConnect()
+static void clear_devices()
+{
+    vector<shared_ptr<const Device>> retired;
     {
-        try
+        std::unique_lock lk(g_devices_mutex);
+        g_devices.for_each([&retired](uint64_t, const shared_ptr<const Device>& device)
         {
-            connected_ = false;
+            retired.push_back(device);
+        });
+        g_devices.clear();
+        g_advertisement_coalescer.clear();
+        g_device_states.clear();
+    }
+    retire_devices(std::move(retired));
+}
 
-            NamedLog("Getting session");
-            gatt_session_ = co_await GattSession::FromDeviceIdAsync(device_.BluetoothDeviceId());
-            if (gatt_session_ == nullptr)
-            {
-                NamedLog("Failed to get session\n");
-                
-                co_return false;
-            }
-            else
-            {
-                gatt_session_.SessionStatusChanged([this](const GattSession& session, const GattSessionStatusChangedEventArgs& args)
-                {
-                    NamedLog("Session status changed to {}, error was {}\n", int(args.Status()), int(args.Error()));
-                });
-                gatt_session_.MaintainConnection(true);
-            }
-            
-            NamedLog("Getting services\n");
-            const auto servicesResult = co_await device_.GetGattServicesForUuidAsync(k_service_guid, BluetoothCacheMode::Cached);
-            if (servicesResult.Status() != GattCommunicationStatus::Success)
-            {
-                auto errString = GDSRErrorString(servicesResult);
-                NamedLog("Failed to get services, error `{}`\n", errString);
-                
-                co_return false;
-            }
-            const auto services = servicesResult.Services();
-            if (services.Size() < 1)
-            {
-                NamedLog("Failed to get services\n");
-                
-                co_return false;
-            }
-            service_ = services.GetAt(0);
+// Makes dice from earlier runs known without waiting for them to advertise
+static void seed_devices_from_cache()
+{
+    std::unique_lock lk(g_devices_mutex);
+    g_device_cache.for_each([](const CachedDevice& cached)
+    {
+        if (g_devices.contains(cached.address)) return;
 
-            NamedLog("Requesting access\n");
-            const auto accessStatus = co_await service_.RequestAccessAsync();
-            if (accessStatus != DeviceAccessStatus::Allowed)
-            {
-                NamedLog("Failed to get access to service for {}\n", name_);
-                
-                co_return false;
-            }
-            
-            NamedLog("Setting status changed handler\n");
-            connection_status_changed_token_ = device_.ConnectionStatusChanged([this](auto&& dev, auto&& args)
-            {
-                internal_connection_changed_handler(dev, identifier_);
-            });
+        g_device_states.restore(cached.address, DeviceCache::to_info(cached));
+        const string name(cached.name, strnlen(cached.name, sizeof(cached.name)));
+        g_devices.try_emplace(cached.address, std::make_shared<const Device>(Device{ cached.address, godice::identifier_string(cached.address), name }));
+    });
+}
 
-            NamedLog("Getting notify characteristic\n");
-            const auto notifChsResponse = co_await service_.GetCharacteristicsForUuidAsync(k_notify_guid, BluetoothCacheMode::Cached);
-            if (notifChsResponse.Status() != GattCommunicationStatus::Success)
-            {
-                auto errString = GCRErrorString(notifChsResponse);
-                NamedLog("Got a failure response from GetCharacteristicsForUuidAsync for notify characteristic with err `{}`\n", errString);
-                
-                co_return false;
-            }
-            auto notifChs = notifChsResponse.Characteristics();
-            if (notifChs.Size() < 1)
-            {
-                NamedLog("Did not find any notification characteristics\n");
-                
-                co_return false;
-            }
-            notify_characteristic_ = notifChs.GetAt(0);
+// Only call on the bluetooth queue, with the platform transport in use
+static void open_device_cache()
+{
+    if (!g_device_cache_path.empty() && g_device_cache.open(g_device_cache_path))
+    {
+        log_info("Using device cache {}\n", g_device_cache_path);
+    }
+    else
+    {
+        g_device_cache.close();
+    }
 
-            if ((notify_characteristic_.CharacteristicProperties() & GattCharacteristicProperties::Notify) != GattCharacteristicProperties::Notify)
-            {
-                NamedLog("Did not find characteristic with expected Notify property\n");
-                
-                co_return false;
-            }
-            
-            NamedLog("Setting value changed handler\n");
-            notify_token_ = notify_characteristic_.ValueChanged([this](auto&& ch, auto&& args)
-            {
-                notify_characteristic_value_changed(args);
-            });
-            
-            NamedLog("Writing configuration\n");
-            auto configResult = co_await notify_characteristic_
-                                .WriteClientCharacteristicConfigurationDescriptorAsync(
-                                    GattClientCharacteristicConfigurationDescriptorValue::Notify);
-            if (configResult != GattCommunicationStatus::Success)
-            {
-                NamedLog("Failed to get set notification config with result {}\n", int(configResult));
-    
-                co_return false;
-            }
+    g_transport->set_device_cache(g_device_cache.is_open() ? &g_device_cache : nullptr);
+    seed_devices_from_cache();
+}
 
-            NamedLog("Getting write characteristic\n");
-            const auto wrChsResult = co_await service_.GetCharacteristicsForUuidAsync(k_write_guid, BluetoothCacheMode::Cached);
-            if (wrChsResult.Status() != GattCommunicationStatus::Success)
-            {
-                auto errString = GCRErrorString(wrChsResult);
-                NamedLog("Got a failure response from GetCharacteristicsForUuidAsync for write characteristic with err `{}`\n", errString);
+// Color and battery reports are rare; remember the latest of each
+static void remember_status(uint64_t address, const uint8_t* data, uint32_t size)
+{
+    GDEvent event;
+    if (!godice::protocol::decode(data, size, event)) return;
 
-                co_return false;
-            }
-            const auto wrChs = wrChsResult.Characteristics();
-            if (wrChs.Size() < 1)
-            {
-                NamedLog("Did not find any write characteristics\n");
+    if (event.type == GD_EVENT_COLOR)
+    {
+        g_device_cache.update(address, [&event](CachedDevice& device)
+        {
+            device.color = event.value;
+            device.flags |= GD_DEVICE_HAS_COLOR;
+        });
+    }
+    else if (event.type == GD_EVENT_BATTERY_LEVEL)
+    {
+        g_device_cache.update(address, [&event](CachedDevice& device)
+        {
+            device.battery = event.value;
+            device.flags |= GD_DEVICE_HAS_BATTERY;
+        });
+    }
+}
 
-                co_return false;
-            }
-            write_characteristic_ = wrChs.GetAt(0);
+// Returns false if the host takes callbacks instead
+static auto post_event(GDPollEventType type, uint64_t address) -> bool
+{
+    if (!g_poll_queue.enabled()) return false;
 
-            if ((write_characteristic_.CharacteristicProperties() & GattCharacteristicProperties::Write) != GattCharacteristicProperties::Write)
-            {
-                NamedLog("Did not find characteristic with expected Write property\n");
+    GDPollEvent event{};
+    event.device = address;
+    event.type = type;
+    return g_poll_queue.post(event);
+}
 
-                co_return false;
-            }
+static auto post_event(GDPollEventType type, const string& identifier) -> bool
+{
+    uint64_t address = 0;
+    return g_poll_queue.enabled() && godice::parse_identifier(identifier.c_str(), address) && post_event(type, address);
+}
 
-            connected_ = device_.ConnectionStatus() == BluetoothConnectionStatus::Connected;
+static auto post_device_found(const Device& device) -> bool
+{
+    if (!g_poll_queue.enabled()) return false;
 
-            NamedLog("Connection status is {}\n", connected_);
-            co_return connected_;
-        }
-        catch (std::exception& e)
-        {
-            NamedLog("Caught exception while connecting {}\n", e.what());
-                
-            co_return false;
-        }
-        catch (winrt::hresult_error& e)
+    GDPollEvent event{};
+    event.device = device.address;
+    event.type = GD_POLL_DEVICE_FOUND;
+    DeviceCache::copy_string(event.name, device.name);
+    return g_poll_queue.post(event);
+}
+
+// Only call with g_devices_mutex held
+static void enqueue_device_found(const Device* device)
+{
+    g_stats.advertisements_reported.add();
+    if (post_device_found(*device)) return;
+
+    callback_queue(device->address).enqueue_latest(device->address, [device]
+    {
+        if (g_device_found_callback)
         {
-            NamedLog("Caught exception code {} while connecting\n", e.code().value);
-                
-            co_return false;
+            TraceSpan span("device found callback");
+            g_device_found_callback(device->identifier.c_str(), device->name.c_str());
         }
-        catch (...)
+    }, WorkPriority::Discovery);
+}
+
+// Runs on the die's callback strand
+static void deliver_packet(const char* identifier, uint32_t data_size, uint8_t* data)
+{
+    if (const GDDataCallbackFunction callback = g_data_received_callback.load(std::memory_order_relaxed))
+    {
+        TraceSpan span("data callback");
+        callback(identifier, data_size, data);
+    }
+    if (const GDEventCallbackFunction callback = g_event_callback.load(std::memory_order_relaxed))
+    {
+        GDEvent event;
+        if (godice::protocol::decode(data, data_size, event))
         {
-            auto e = std::current_exception();
-            NamedLog("Caught exception while connecting\n");
-                
-            co_return false;
+            TraceSpan span("event callback");
+            callback(identifier, &event);
         }
     }
+}
 
-    IAsyncOperation<bool> lockedSend(const IBuffer& msg)
+static void set_connection(const string& identifier, GDConnectionState connection)
+{
+    uint64_t address;
+    if (godice::parse_identifier(identifier.c_str(), address))
     {
-        if (!connected_)
-        {
-            NamedLog("Attempting to write while not connected");
-            co_return false;
-        }
-        
-        if (write_characteristic_ == nullptr)
-        {
-            NamedLog("No write characteristic found for\n");
-            co_return false;
-        }
+        g_device_states.set_connection(address, connection);
+    }
+}
 
-        try
-        {
-            auto status = co_await write_characteristic_.WriteValueAsync(msg, GattWriteOption::WriteWithoutResponse);
-            if (status != GattCommunicationStatus::Success)
-            {
-                NamedLog("Write data failed with status {}\n", (int)status);
-                co_return false;
-            }
+static void notify_disconnected(const string& identifier)
+{
+    set_connection(identifier, GD_CONNECTION_DISCONNECTED);
+    if (post_event(GD_POLL_DISCONNECTED, identifier)) return;
 
-            co_return true;
-        }
-        catch (std::exception& e)
-        {
-            NamedLog("Caught exception while writing! {}\n", e.what());
-        }
-        catch (winrt::hresult_error& e)
-        {
-            NamedLog("Caught exception while writing! {}\n", to_string(e.message()));
-        }
-        catch (...)
+    callback_queue(identifier).enqueue([identifier]
+    {
+        if (g_device_disconnected_callback)
         {
-            auto e = std::current_exception();
-            NamedLog("Caught exception while writing!\n");
+            TraceSpan span("disconnected callback");
+            g_device_disconnected_callback(identifier.c_str());
         }
+    }, WorkPriority::Data);
+}
 
-        co_return false;
-    }
-    
-public:
-    static Concurrency::task<shared_ptr<DeviceSession>> MakeSession(uint64_t bluetoothAddr)
+static void notify_connection_result(const string& identifier, bool success)
+{
+    log_info("Result was {}\n", success);
+    set_connection(identifier, success ? GD_CONNECTION_CONNECTED : GD_CONNECTION_FAILED);
+    if (post_event(success ? GD_POLL_CONNECTED : GD_POLL_CONNECTION_FAILED, identifier)) return;
+
+    if (success && g_device_connected_callback)
     {
-        return Concurrency::create_task([bluetoothAddr]
+        callback_queue(identifier).enqueue([identifier]
         {
-            try
-            {
-                auto device = BluetoothLEDevice::FromBluetoothAddressAsync(bluetoothAddr).get();
-
-                return std::make_shared<DeviceSession>(device, bluetoothAddr, nullptr, nullptr,
-                                                       nullptr);
-            }
-            catch (std::exception& e)
-            {
-                log("Caught exception while creating session {}\n", e.what());
-            }
-            catch (winrt::hresult_error& e)
-            {
-                log("Caught exception while creating session {}\n", to_string(e.message()));
-            }
-            catch (...)
-            {
-                auto e = std::current_exception();
-                log("Caught exception while creating new session\n");
-            }
-
-            return shared_ptr<DeviceSession>(nullptr);
-        });
+            TraceSpan span("connected callback");
+            g_device_connected_callback(identifier.c_str());
+        }, WorkPriority::Data);
     }
-
-    DeviceSession(
-        const BluetoothLEDevice& dev,
-        const uint64_t btAddr,
-        const GattDeviceService& service,
-        const GattCharacteristic& notifyCh,
-        const GattCharacteristic& writeCh
-    ) : device_(dev), bluetoothAddress_(btAddr), identifier_(std::to_string(btAddr)), name_(to_string(dev.Name())), service_(service),
-        notify_characteristic_(notifyCh), write_characteristic_(writeCh), gatt_session_(nullptr)
+    if (!success && g_device_connection_failed_callback)
     {
+        callback_queue(identifier).enqueue([identifier]
+        {
+            TraceSpan span("connection failed callback");
+            g_device_connection_failed_callback(identifier.c_str());
+        }, WorkPriority::Data);
     }
+}
 
-    void notify_characteristic_value_changed(const GattValueChangedEventArgs& args) const
+// Called for every advertisement that passes the coalescer; for a die we already know this allocates nothing
+static void report_advertisement(uint64_t address, std::string_view name)
+{
     {
-        if (g_data_received_callback != nullptr)
+        std::shared_lock lk(g_devices_mutex);
+        const auto* known = g_devices.find(address);
+        if (known != nullptr && (name.empty() || (*known)->name == name))
         {
-            const IBuffer& data = args.CharacteristicValue();
-            const string ident = this->identifier_;
-            g_callback_queue.enqueue([data, ident]
-            {
-                g_data_received_callback(ident.c_str(), data.Length(), data.data());
-            });
+            enqueue_device_found(known->get());
+            return;
         }
     }
 
-    IAsyncOperation<bool> Connect()
+    vector<shared_ptr<const Device>> retired;
     {
-        bool success = false;
-        
-        use_sema_.acquire();
-        if (device_.ConnectionStatus() == BluetoothConnectionStatus::Disconnected && notify_characteristic_ != nullptr)
-        {
-            co_await lockedDisconnect();
-        }
-        
-        if (connected_)
+        std::unique_lock lk(g_devices_mutex);
+        string device_name(name);
+        if (const auto* current = g_devices.find(address); current != nullptr)
         {
-            NamedLog("Already connected\n");
-            success = true;
-        }
-        else
-        {
-            if (bool result = co_await lockedConnect())
-            {
-                success = true;
-            }
-            else
+            if (device_name.empty())
             {
-                co_await lockedDisconnect();
+                device_name = (*current)->name;
             }
+            retired.push_back(*current);
         }
-        use_sema_.release();
 
-        co_return success;
+        const auto device = std::make_shared<const Device>(Device{ address, godice::identifier_string(address), device_name });
+        g_devices.insert_or_assign(address, device);
+        g_device_states.add(address);
+        enqueue_device_found(device.get());
     }
+    retire_devices(std::move(retired));
 
-    IAsyncOperation<bool> send(const IBuffer& msg)
+    g_device_cache.update(address, [&name](CachedDevice& device)
     {
-        use_sema_.acquire();
-        NamedLog("Attempting to write {} bytes\n", msg.Length());
-        auto result = co_await lockedSend(msg);
+        if (!name.empty())
+        {
+            DeviceCache::copy_string(device.name, name);
+        }
+    });
+}
 
-        use_sema_.release();
+void CoreTransportListener::on_advertisement(uint64_t address, std::string_view name, int16_t rssi)
+{
+    const auto started = LatencyHistogram::Clock::now();
+    g_stats.advertisements_received.add();
+    record_traffic(CaptureKind::Advertisement, address, name.data(), static_cast<uint32_t>(name.size()), rssi);
 
-        co_return result;
+    if (g_advertisement_coalescer.admit(address, name, rssi))
+    {
+        report_advertisement(address, name);
     }
+    g_device_states.advertised(address, rssi);
+    g_stats.advertisement_handling.record_since(started);
+}
+
+void CoreTransportListener::on_discovery_stopped()
+{
+    if (post_event(GD_POLL_LISTENER_STOPPED, 0)) return;
 
-    IAsyncOperation<bool> disconnect()
+    callback_queue().enqueue([]
     {
-        try
+        if (g_listener_stopped_callback)
         {
-            use_sema_.acquire();
-            auto result = co_await lockedDisconnect();
-            use_sema_.release();
+            TraceSpan span("listener stopped callback");
+            g_listener_stopped_callback();
+        }
+    }, WorkPriority::Discovery);
+}
 
-            const string ident = identifier_;
-            g_callback_queue.enqueue([ident]
-            {
-                if (g_device_disconnected_callback) {
-                    g_device_disconnected_callback(ident.c_str());
-                }
-            });
+// To the poll queue while polling, otherwise to the die's callback strand
+static void post_packet(uint64_t address, const uint8_t* data, uint32_t size)
+{
+    if (g_poll_queue.enabled())
+    {
+        GDPollEvent event{};
+        event.device = address;
+        event.type = GD_POLL_DATA;
+        event.data_size = std::min<uint32_t>(size, GD_POLL_DATA_SIZE);
+        std::memcpy(event.data, data, event.data_size);
+        godice::protocol::decode(data, size, event.event);
+        if (g_poll_queue.post(event)) return;
+    }
 
-            co_return result;
-        }
-        catch (winrt::hresult_error& e)
+    if (g_data_received_callback.load(std::memory_order_relaxed) == nullptr && g_event_callback.load(std::memory_order_relaxed) == nullptr) return;
+
+    char identifier[godice::k_identifier_buffer_size];
+    godice::format_identifier(address, identifier);
+
+    // Steady state: copy the few bytes into a pooled record so nothing is allocated per packet
+    if (PacketRecord* record = g_packet_pool.acquire(identifier, data, size))
+    {
+        callback_queue(address).enqueue([record]
         {
-            NamedLog("Caught exception while disconnecting {}\n", e.code().value);
-            co_return false;
-        }
+            deliver_packet(record->identifier, record->size, record->payload);
+            g_packet_pool.release(record);
+        }, WorkPriority::Data);
+        return;
     }
 
-    const string& DeviceName() const { return name_; }
+    callback_queue(address).enqueue([ident = string(identifier), packet = vector<uint8_t>(data, data + size)]() mutable
+    {
+        deliver_packet(ident.c_str(), static_cast<uint32_t>(packet.size()), packet.data());
+    }, WorkPriority::Data);
+}
 
-    ~DeviceSession()
+void CoreTransportListener::on_notification(uint64_t address, const uint8_t* data, uint32_t size)
+{
+    g_stats.notifications_received.add();
+    record_traffic(CaptureKind::Notification, address, data, size);
+    if (size >= 4 && (data[0] == 'B' || data[0] == 'C'))
     {
-        use_sema_.acquire();
-        lockedDisconnect();
+        remember_status(address, data, size);
+    }
+    g_device_states.notified(address, data, size);
+    post_packet(address, data, size);
+    // Once the packet's own callbacks are queued, so a throw it completes goes behind them
+    g_roll_aggregator.observe(address, data, size);
+}
 
-        device_.Close();
-        device_ = nullptr;
+void CoreTransportListener::on_link_lost(uint64_t address)
+{
+    g_stats.link_losses.add();
+    record_traffic(CaptureKind::LinkLost, address);
+    g_bluetooth_queue.enqueue([address]
+    {
+        const shared_ptr<const Device> device = find_device(address);
+        if (device == nullptr) return;
 
-        use_sema_.release();
-    }
-};
+        log_info("Got a disconnection event for {}\n", device->identifier);
+        g_write_pipeline.forget(address);
+        transport().disconnect(address, on_bluetooth_queue([identifier = device->identifier](bool)
+        {
+            notify_disconnected(identifier);
+        }));
+    });
+}
 
 void godice_set_callbacks(
     GDDeviceFoundCallbackFunction deviceFoundCallback,
@@ -522,7 +652,7 @@ void godice_set_callbacks(
     g_bluetooth_queue.enqueue([=]
     {
         g_device_found_callback = deviceFoundCallback;
-        g_data_received_callback = dataReceivedCallback;
+        g_data_received_callback.store(dataReceivedCallback, std::memory_order_relaxed);
         g_device_connected_callback = deviceConnectedCallback;
         g_device_connection_failed_callback = deviceConnectionFailedCallback;
         g_device_disconnected_callback = deviceDisconnectedCallback;
@@ -530,55 +660,57 @@ void godice_set_callbacks(
     });
 }
 
+void godice_set_event_callback(GDEventCallbackFunction eventCallback)
+{
+    g_bluetooth_queue.enqueue([eventCallback]
+    {
+        g_event_callback.store(eventCallback, std::memory_order_relaxed);
+    });
+}
+
 void godice_set_logger(GDLogger logger)
 {
     g_bluetooth_queue.enqueue([logger]
     {
-        g_logger = logger;
+        godice::set_logger(logger);
     });
 }
 
+void godice_set_log_level(uint32_t level)
+{
+    godice::set_log_level(level);
+}
+
 void godice_start_listening()
 {
     g_bluetooth_queue.enqueue([]
     {
-        if (g_watcher == nullptr)
-        {
-            g_watcher = BluetoothLEAdvertisementWatcher();
-        }
-        g_watcher.ScanningMode(BluetoothLEScanningMode::Active);
-        g_watcher.AdvertisementFilter().Advertisement().ServiceUuids().Append(k_service_guid);
+        // Creating the transport loads the device cache, so do it before reporting known devices
+        Transport& listener_transport = transport();
 
-        auto result = g_watcher.Received(received_device_found_event);
-
-        g_watcher.Stopped([=](auto&&, auto&&)
+        if (g_poll_queue.enabled())
         {
-            log("Watcher Stopped\n");
-
-            g_callback_queue.enqueue([]
+            std::shared_lock lk(g_devices_mutex);
+            g_devices.for_each([](uint64_t, const shared_ptr<const Device>& device)
             {
-                if (g_listener_stopped_callback)
-                {
-                    g_listener_stopped_callback();
-                }
+                post_device_found(*device);
             });
-        });
-
-        if (g_device_found_callback)
+        }
+        else if (g_device_found_callback)
         {
-            // Make a copy of sessions inside the queue
-            unordered_map<string, shared_ptr<DeviceSession>> sessions = g_devices_by_identifier;
-
-            g_callback_queue.enqueue([sessions]
+            // Each callback holds its device, on that device's strand
+            std::shared_lock lk(g_devices_mutex);
+            g_devices.for_each([](uint64_t address, const shared_ptr<const Device>& device)
             {
-                for (const auto& kv : sessions)
+                callback_queue(address).enqueue_latest(address, [device]
                 {
-                    g_device_found_callback(kv.first.c_str(), kv.second->DeviceName().c_str());
-                }
+                    TraceSpan span("device found callback");
+                    g_device_found_callback(device->identifier.c_str(), device->name.c_str());
+                }, WorkPriority::Discovery);
             });
         }
 
-        g_watcher.Start();
+        listener_transport.start_discovery();
     });
 }
 
@@ -587,9 +719,72 @@ void godice_connect(const char* inIdent)
     string identifier = inIdent;
     g_bluetooth_queue.enqueue([identifier]
     {
-        log("Trying to connect to {}\n", identifier);
-        bool result = on_queue_internal_connect(identifier).get();
-        log("Result was {}\n", result);
+        log_info("Trying to connect to {}\n", identifier);
+
+        const shared_ptr<const Device> device = find_device(identifier);
+        if (device == nullptr)
+        {
+            log_warning("No session for {}\n", identifier);
+            notify_connection_result(identifier, false);
+            return;
+        }
+
+        const uint64_t address = device->address;
+        g_device_states.set_connection(address, GD_CONNECTION_CONNECTING);
+        g_connection_scheduler.submit([identifier, address, requested = godice::trace::Clock::now()](bool start)
+        {
+            const auto started = godice::trace::Clock::now();
+            godice::trace::complete("waiting for a connection slot", address, requested, started);
+            if (!start)
+            {
+                notify_connection_result(identifier, false);
+                return;
+            }
+
+            g_stats.connect_attempts.add();
+            const uint32_t generation = g_connection_scheduler.generation();
+            const auto finish = [identifier, address, generation, started](bool success)
+            {
+                const auto finished = godice::trace::Clock::now();
+                g_stats.connect.record(finished - started);
+                godice::trace::complete("connect", address, started, finished, "success", success);
+                if (!success)
+                {
+                    g_stats.connect_failures.add();
+                }
+                record_traffic(success ? CaptureKind::Connected : CaptureKind::ConnectFailed, address);
+                if (success)
+                {
+                    g_device_cache.update(address, [](CachedDevice& device)
+                    {
+                        device.flags |= GD_DEVICE_CONNECTED_BEFORE;
+                    });
+                }
+                notify_connection_result(identifier, success);
+                g_connection_scheduler.finished(generation);
+            };
+
+            transport().connect(address, on_bluetooth_queue([address, finish, started](bool connected)
+            {
+                const auto linked = godice::trace::Clock::now();
+                godice::trace::complete("link", address, started, linked, "success", connected);
+                if (!connected)
+                {
+                    finish(false);
+                    return;
+                }
+
+                transport().subscribe(address, on_bluetooth_queue([address, finish, linked](bool subscribed)
+                {
+                    godice::trace::complete("subscribe", address, linked, godice::trace::Clock::now(), "success", subscribed);
+                    if (!subscribed)
+                    {
+                        transport().disconnect(address, [](bool) {});
+                    }
+                    finish(subscribed);
+                }));
+            }));
+        });
     });
 }
 
@@ -598,179 +793,349 @@ void godice_disconnect(const char* inIdent)
     string identifier = inIdent;
     g_bluetooth_queue.enqueue([identifier]
     {
-        shared_ptr<DeviceSession> session = nullptr;
+        const shared_ptr<const Device> device = find_device(identifier);
+        if (device == nullptr) return;
 
-        session = g_devices_by_identifier[identifier];
-    
-        if (session == nullptr) return;
-        
-        bool result = session->disconnect().get();
+        g_write_pipeline.forget(device->address);
+        transport().disconnect(device->address, on_bluetooth_queue([identifier, address = device->address](bool)
+        {
+            record_traffic(CaptureKind::Disconnected, address);
+            notify_disconnected(identifier);
+        }));
     });
 }
 
 void godice_send(const char* id, uint32_t data_size, uint8_t* data)
 {
-    const string identifier(id);
-
-    const DataWriter writer;
-    writer.WriteBytes(winrt::array_view(data, data + data_size));
+    uint64_t address;
+    if (!godice::parse_identifier(id, address))
+    {
+        log_warning("No session found for {}\n", id);
+        return;
+    }
 
-    const IBuffer buf = writer.DetachBuffer();
-    
-    g_bluetooth_queue.enqueue([identifier, buf]
+    g_bluetooth_queue.enqueue([address, payload = std::make_shared<const vector<uint8_t>>(data, data + data_size)]() mutable
     {
-        bool success = on_queue_send(identifier, buf).get();
+        if (find_device(address) == nullptr)
+        {
+            log_warning("No session found for {}\n", godice::identifier_string(address));
+            return;
+        }
+
+        g_write_pipeline.submit(address, std::move(payload));
     });
 }
 
-static IAsyncOperation<bool> on_queue_send(const string& identifier, const IBuffer& buffer)
+GDDeviceHandle godice_device_handle(const char* identifier)
 {
-    const shared_ptr<DeviceSession> session = g_devices_by_identifier[identifier];
+    uint64_t address;
+    return godice::parse_identifier(identifier, address) ? address : 0;
+}
 
-    if (session == nullptr)
-    {
-        log("No session found for {}\n", identifier);
-    }
-    else
+void godice_send_many_handles(const GDDeviceHandle* handles, uint32_t count, uint32_t data_size, uint8_t* data,
+                              GDSendManyCallbackFunction callback, void* context)
+{
+    if (count == 0) return;
+
+    // One payload for every die; the batch collects their outcomes for a single callback
+    auto payload = std::make_shared<const vector<uint8_t>>(data, data + data_size);
+    auto batch = std::make_shared<WriteBatch>();
+    batch->addresses.assign(handles, handles + count);
+    batch->delivered = std::make_unique<bool[]>(count);
+    batch->remaining = count;
+    if (callback != nullptr)
     {
-        co_return co_await session->send(buffer);
+        batch->done = [callback, context](const shared_ptr<WriteBatch>& finished)
+        {
+            callback_queue().enqueue([callback, context, finished]
+            {
+                TraceSpan span("send many callback");
+                callback(context, static_cast<uint32_t>(finished->addresses.size()), finished->addresses.data(), finished->delivered.get());
+            }, WorkPriority::Control);
+        };
     }
-    co_return false;
-}
 
-static void internal_connection_changed_handler(const BluetoothLEDevice& dev, const string& identifier)
-{
-    g_bluetooth_queue.enqueue([dev, identifier]
+    g_bluetooth_queue.enqueue([payload = std::move(payload), batch = std::move(batch)]
     {
-        if (dev.ConnectionStatus() == BluetoothConnectionStatus::Disconnected)
+        for (uint32_t i = 0; i < batch->addresses.size(); i++)
         {
-            log("Got a disconnection event for {}\n", identifier);
-            const auto& session = g_devices_by_identifier[identifier];
-        
-            if (session != nullptr)
+            const uint64_t address = batch->addresses[i];
+            if (find_device(address) == nullptr)
             {
-                session->disconnect().get();
+                WritePipeline::resolve(batch, i, false);
+                continue;
             }
+            g_write_pipeline.submit(address, payload, batch, i);
         }
     });
 }
 
-static IAsyncOperation<bool> on_queue_internal_connect(const string& inIdent)
+void godice_send_many(const char** identifiers, uint32_t count, uint32_t data_size, uint8_t* data,
+                      GDSendManyCallbackFunction callback, void* context)
 {
-    string identifier = inIdent;
-    shared_ptr<DeviceSession> session;
-    bool success = false;
-    
-    session = g_devices_by_identifier[identifier];
-    
-    if (session == nullptr)
-    {
-        log("No session for {}\n", identifier);
-        success = false;
-    }
-    else
+    vector<GDDeviceHandle> handles(count);
+    for (uint32_t i = 0; i < count; i++)
     {
-        success = co_await session->Connect();
+        handles[i] = godice_device_handle(identifiers[i]);
     }
-    
-    if (success && g_device_connected_callback)
-    {
-        g_callback_queue.enqueue([identifier]
-        {
-            g_device_connected_callback(identifier.c_str());
-        });
-    }
-    if (!success && g_device_connection_failed_callback)
+    godice_send_many_handles(handles.data(), count, data_size, data, callback, context);
+}
+
+void godice_set_group(uint32_t group, const GDDeviceHandle* handles, uint32_t count, const GDGroupConfig* inConfig)
+{
+    const GDGroupConfig config = inConfig != nullptr ? *inConfig : RollAggregator::default_config();
+    g_roll_aggregator.set_group(group, handles, handles != nullptr ? count : 0, config);
+}
+
+void godice_set_throw_callback(GDThrowCallbackFunction callback, void* context)
+{
+    // On the strand that reports throws, in order with them
+    callback_queue().enqueue([callback, context]
     {
-        g_callback_queue.enqueue([identifier]
-        {
-            g_device_connection_failed_callback(identifier.c_str());
-        });
-    }
-    
-    co_return success;
+        g_throw_callback = callback;
+        g_throw_context = context;
+    }, WorkPriority::Data);
 }
 
-static void received_device_found_event(const BluetoothLEAdvertisementWatcher& watcher,
-                                     const BluetoothLEAdvertisementReceivedEventArgs& args)
+void godice_set_write_mode(uint32_t mode, uint32_t max_in_flight)
 {
-    uint64_t btAddr = args.BluetoothAddress();
-    string identifier = std::to_string(btAddr);
+    const WriteMode write_mode = mode == GD_WRITE_WITH_RESPONSE ? WriteMode::WithResponse : WriteMode::WithoutResponse;
 
-    g_bluetooth_queue.enqueue([btAddr, identifier]
+    g_bluetooth_queue.enqueue([write_mode, max_in_flight]
     {
-        on_queue_received_device_found_event(btAddr).get();
+        g_write_pipeline.configure(write_mode, max_in_flight);
     });
 }
 
-static IAsyncOperation<bool> on_queue_received_device_found_event(const uint64_t inBtAddr) {
-    auto btAddr = inBtAddr;
-    
-    auto identifier =  std::to_string(btAddr);;
-    
-    shared_ptr<DeviceSession> session = nullptr;
-
-    bool needsNewSession = true;
-    
-    if (g_devices_in_progress.contains(identifier))
+void godice_stop_listening()
+{
+    g_bluetooth_queue.enqueue([]
     {
-        needsNewSession = false;
-        g_devices_in_progress.insert(identifier);
-    }
-    else if (g_devices_by_identifier.contains(identifier))
+        transport().stop_discovery();
+    });
+}
+
+void godice_reset()
+{
+    g_bluetooth_queue.enqueue([]
     {
-        needsNewSession = false;
-    }
+        transport().reset();
+        g_connection_scheduler.clear();
+        g_write_pipeline.clear();
+        clear_devices();
+        g_device_cache.flush();
+        seed_devices_from_cache();
+    });
+}
 
-    if (needsNewSession)
+void install_transport(std::unique_ptr<Transport> transport)
+{
+    // Shared so the work item stays copyable
+    g_bluetooth_queue.enqueue([transport = shared_ptr<Transport>(std::move(transport))]
     {
-        session = co_await DeviceSession::MakeSession(btAddr);
-        
-        if (session != nullptr)
+        if (g_transport != nullptr)
         {
-            g_devices_by_identifier.emplace(std::make_pair(identifier, session));
-            g_devices_in_progress.erase(identifier);
+            g_transport->reset();
         }
-        else
+        g_connection_scheduler.clear();
+        g_write_pipeline.clear();
+        clear_devices();
+        // Dice from other transports must not end up in the cache
+        g_device_cache.close();
+        g_using_platform_transport = false;
+
+        use_transport(transport);
+    });
+}
+
+void godice_set_device_cache_path(const char* inPath)
+{
+    string path = inPath != nullptr ? inPath : "";
+    g_bluetooth_queue.enqueue([path]
+    {
+        g_device_cache_path = path;
+        if (g_using_platform_transport)
         {
-            log("Failed to create new session\n");
+            open_device_cache();
         }
-    }
-    else
-    {
-        session = g_devices_by_identifier[identifier];
-    }
+    });
+}
 
-    if (session && g_device_found_callback)
+bool godice_get_device_info(const char* identifier, GDDeviceInfo* info)
+{
+    uint64_t address;
+    CachedDevice device;
+    if (info == nullptr || !godice::parse_identifier(identifier, address) || !g_device_cache.find(address, device))
     {
-        g_callback_queue.enqueue([identifier, session]
-        {
-            g_device_found_callback(identifier.c_str(), session->DeviceName().c_str());
-        });
+        return false;
     }
-    co_return session != nullptr;
+
+    *info = DeviceCache::to_info(device);
+    return true;
 }
 
-void godice_stop_listening()
+void godice_set_die_type(const char* identifier, uint32_t die_type)
 {
-    g_bluetooth_queue.enqueue([]
+    uint64_t address;
+    if (!godice::parse_identifier(identifier, address)) return;
+
+    g_device_cache.update(address, [die_type](CachedDevice& device)
     {
-        g_watcher.Stop();
+        device.die_type = static_cast<uint8_t>(die_type);
+        device.flags |= GD_DEVICE_HAS_DIE_TYPE;
     });
+    g_device_states.set_die_type(address, static_cast<uint8_t>(die_type));
 }
 
-void godice_reset()
+void godice_set_max_concurrent_connections(uint32_t max_connections)
 {
-    g_bluetooth_queue.enqueue([]
+    g_bluetooth_queue.enqueue([max_connections]
     {
-        g_watcher.Stop();
+        g_connection_scheduler.set_max_concurrent(max_connections);
+    });
+}
 
-        while (g_devices_in_progress.size() > 0)
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-    
-        g_devices_by_identifier.clear();
+void godice_set_coalescing(const GDCoalescingConfig* inConfig)
+{
+    const GDCoalescingConfig config = inConfig != nullptr ? *inConfig : AdvertisementCoalescer::default_config();
+
+    g_bluetooth_queue.enqueue([config]
+    {
+        g_advertisement_coalescer.configure(config);
     });
 }
 
+bool godice_configure_executor(const GDExecutorConfig* inConfig)
+{
+    const GDExecutorConfig config = inConfig != nullptr ? *inConfig : Executor::default_config();
+    if (!Executor::configure(config))
+    {
+        log_warning("The executor has already started; configure it before anything else\n");
+        return false;
+    }
+
+    g_parallel_callbacks = config.parallel_callbacks;
+    return true;
+}
+
+void godice_set_queue_config(uint32_t priority, const GDQueueConfig* inConfig)
+{
+    if (priority >= GD_PRIORITY_COUNT) return;
+
+    const auto lane = static_cast<WorkPriority>(priority);
+    const GDQueueConfig config = inConfig != nullptr ? *inConfig : default_queue_config(lane);
+    for (const auto& strand : g_callback_strands)
+    {
+        strand->configure(lane, config);
+    }
+}
+
+bool godice_start_capture(const char* path, const GDCaptureConfig* inConfig)
+{
+    const GDCaptureConfig config = inConfig != nullptr ? *inConfig : TrafficCapture::default_config();
+    return g_capture.start(path != nullptr ? path : "", config);
+}
+
+void godice_stop_capture()
+{
+    g_capture.stop();
+}
+
+void godice_start_trace(uint32_t capacity)
+{
+    godice::trace::start(capacity);
+}
+
+void godice_stop_trace()
+{
+    godice::trace::stop();
+}
+
+bool godice_write_trace(const char* path)
+{
+    return path != nullptr && godice::trace::write_json(path);
+}
+
+void godice_use_simulated_transport(const GDSimulationConfig* inConfig)
+{
+    const GDSimulationConfig config = inConfig != nullptr ? *inConfig : SimulatedTransport::default_config();
+    install_transport(std::make_unique<SimulatedTransport>(config));
+}
+
+bool godice_use_replay_transport(const char* path, const GDReplayConfig* inConfig)
+{
+    const GDReplayConfig config = inConfig != nullptr ? *inConfig : ReplayTransport::default_config();
+    auto replay = ReplayTransport::open(path != nullptr ? path : "", config);
+    if (replay == nullptr) return false;
+
+    install_transport(std::move(replay));
+    return true;
+}
+
+bool godice_start_publishing(const char* name, uint32_t capacity)
+{
+    return g_publisher.start(name != nullptr ? name : "", capacity);
+}
+
+void godice_stop_publishing()
+{
+    g_publisher.stop();
+}
+
+bool godice_use_shared_transport(const char* name)
+{
+    auto shared = SharedTransport::open(name != nullptr ? name : "");
+    if (shared == nullptr) return false;
+
+    install_transport(std::move(shared));
+    return true;
+}
+
+void godice_enable_polling(uint32_t capacity)
+{
+    g_poll_queue.set_capacity(capacity);
+}
+
+uint32_t godice_poll_events(GDPollEvent* events, uint32_t max_events)
+{
+    return g_poll_queue.poll(events, max_events);
+}
+
+intptr_t godice_get_wait_handle(void)
+{
+    return g_poll_queue.wait_handle();
+}
+
+void godice_get_stats(GDStats* stats)
+{
+    if (stats == nullptr) return;
+
+    *stats = GDStats{};
+    g_bluetooth_stats.snapshot(stats->bluetooth_queue);
+    g_callback_stats.snapshot(stats->callback_queue);
+    stats->advertisements_received = g_stats.advertisements_received.load();
+    stats->advertisements_reported = g_stats.advertisements_reported.load();
+    g_stats.advertisement_handling.snapshot(stats->advertisement_handling);
+    stats->notifications_received = g_stats.notifications_received.load();
+    stats->connect_attempts = g_stats.connect_attempts.load();
+    stats->connect_failures = g_stats.connect_failures.load();
+    g_stats.connect.snapshot(stats->connect);
+    stats->link_losses = g_stats.link_losses.load();
+    stats->writes_sent = g_write_pipeline.sent();
+    stats->writes_coalesced = g_write_pipeline.coalesced();
+    stats->writes_failed = g_write_pipeline.failed();
+    g_stats.write.snapshot(stats->write);
+    stats->capture_recorded = g_capture.recorded();
+    stats->capture_dropped = g_capture.dropped();
+    stats->poll_events_dropped = g_poll_queue.dropped();
+    stats->shared_published = g_publisher.published();
+    stats->shared_lost = SharedTransport::total_lost();
+    stats->shared_unlisted = g_publisher.unlisted();
+    stats->throws_completed = g_roll_aggregator.completed();
+    stats->throws_timed_out = g_roll_aggregator.timed_out();
+}
+
+uint32_t godice_snapshot(GDDeviceState* states, uint32_t max_states)
+{
+    return g_device_states.snapshot(states, max_states);
+}
@@ -1,6 +1,12 @@
 #pragma once
 
-#include "stdafx.h"
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define GODICE_API __declspec(dllexport)
+#else
+#define GODICE_API __attribute__((visibility("default")))
+#endif
 
 extern "C" {
 	typedef void (*GDDeviceFoundCallbackFunction)(const char* identifier, const char* name);
@@ -12,20 +18,452 @@ extern "C" {
 
 	typedef void (*GDLogger)(const char* str);
 
-	__declspec(dllexport) void godice_set_callbacks(
+	// See godice_set_log_level
+	typedef enum GDLogLevel
+	{
+		GD_LOG_ERROR = 0,
+		GD_LOG_WARNING = 1,
+		GD_LOG_INFO = 2,
+		GD_LOG_DEBUG = 3,
+	} GDLogLevel;
+
+	// Decoded die messages, see GoDiceProtocol.h for the wire format
+	typedef enum GDEventType
+	{
+		GD_EVENT_UNKNOWN = 0,
+		GD_EVENT_ROLL_STARTED = 1,
+		GD_EVENT_STABLE = 2,
+		GD_EVENT_FAKE_STABLE = 3,
+		GD_EVENT_TILT_STABLE = 4,
+		GD_EVENT_MOVE_STABLE = 5,
+		GD_EVENT_BATTERY_LEVEL = 6,
+		GD_EVENT_COLOR = 7,
+	} GDEventType;
+
+	typedef struct GDEvent
+	{
+		uint32_t type;		// GDEventType
+		int8_t x;			// accelerometer vector, set for the *_STABLE types
+		int8_t y;
+		int8_t z;
+		uint8_t value;		// battery percentage or color index
+	} GDEvent;
+
+	typedef void (*GDEventCallbackFunction)(const char* identifier, const GDEvent* event);
+
+	// GoDice shells. The die reports the same kind of vector in every shell, so the
+	// face lookup needs to know which one it is wearing.
+	typedef enum GDDieType
+	{
+		GD_DIE_D6 = 0,
+		GD_DIE_D20 = 1,
+		GD_DIE_D10 = 2,
+		GD_DIE_D10X = 3,
+		GD_DIE_D4 = 4,
+		GD_DIE_D8 = 5,
+		GD_DIE_D12 = 6,
+	} GDDieType;
+
+	typedef struct GDVector
+	{
+		int8_t x;
+		int8_t y;
+		int8_t z;
+	} GDVector;
+
+	enum
+	{
+		GD_DEVICE_HAS_DIE_TYPE = 1 << 0,
+		GD_DEVICE_HAS_COLOR = 1 << 1,
+		GD_DEVICE_HAS_BATTERY = 1 << 2,
+		GD_DEVICE_CONNECTED_BEFORE = 1 << 3,
+	};
+
+	// What the device cache remembers about a die, across runs
+	typedef struct GDDeviceInfo
+	{
+		char name[32];
+		uint64_t last_seen_ms;				// Unix time
+		uint8_t die_type;					// GDDieType, valid with GD_DEVICE_HAS_DIE_TYPE
+		uint8_t color;						// value of the last GD_EVENT_COLOR
+		uint8_t battery;					// value of the last GD_EVENT_BATTERY_LEVEL
+		uint8_t flags;						// GD_DEVICE_* bits
+	} GDDeviceInfo;
+
+	// How godice_send reaches the die, see godice_set_write_mode
+	typedef enum GDWriteMode
+	{
+		GD_WRITE_WITHOUT_RESPONSE = 0,
+		GD_WRITE_WITH_RESPONSE = 1,
+	} GDWriteMode;
+
+	// A die's Bluetooth address, the numeric value of its identifier. 0 is never valid.
+	typedef uint64_t GDDeviceHandle;
+
+	typedef enum GDConnectionState
+	{
+		GD_CONNECTION_NONE = 0,				// seen, never asked to connect
+		GD_CONNECTION_CONNECTING = 1,		// waiting for a connection slot, or connecting
+		GD_CONNECTION_CONNECTED = 2,
+		GD_CONNECTION_FAILED = 3,
+		GD_CONNECTION_DISCONNECTED = 4,
+	} GDConnectionState;
+
+	enum { GD_MAX_DEVICES = 1024 };
+
+	// What godice_snapshot reports about a die as of its latest packet or advertisement
+	typedef struct GDDeviceState
+	{
+		GDDeviceHandle device;
+		uint64_t last_seen_ms;				// Unix time of the latest advertisement or packet, to within a few ms
+		uint32_t connection;				// GDConnectionState
+		uint32_t roll;						// GDEventType: ROLL_STARTED while rolling, a *_STABLE type at rest, UNKNOWN before the first roll
+		GDVector vector;					// with a *_STABLE roll
+		uint8_t face;						// with a *_STABLE roll, for die_type; 0 where godice_classify_face has no table
+		uint8_t die_type;					// GDDieType, GD_DIE_D6 unless given with godice_set_die_type or remembered by the device cache
+		uint8_t color;						// valid with GD_DEVICE_HAS_COLOR
+		uint8_t battery;					// valid with GD_DEVICE_HAS_BATTERY
+		uint8_t flags;						// GD_DEVICE_* bits
+		int16_t rssi;						// of the latest advertisement
+	} GDDeviceState;
+
+	// Reports a godice_send_many call once every die has an outcome, in the order they were
+	// given. delivered[i] is false if the write failed, a newer command replaced it, or the
+	// die is unknown or went away. The arrays are only valid during the call.
+	typedef void (*GDSendManyCallbackFunction)(void* context, uint32_t count, const GDDeviceHandle* handles, const bool* delivered);
+
+	// One die's part in a throw, see godice_set_group
+	typedef struct GDDieResult
+	{
+		GDDeviceHandle device;
+		GDEvent event;						// the *_STABLE event it came to rest with; GD_EVENT_UNKNOWN if it had not by the timeout
+		uint8_t face;						// for the die type given to godice_set_die_type, D6 if none; 0 if it had not settled
+		uint32_t settle_ms;					// from the first roll of the throw until this die came to rest
+	} GDDieResult;
+
+	// Reports a throw of a group once the last of its dice has come to rest, or its settle
+	// timeout has run out. results has one entry per die, in the order given to
+	// godice_set_group, and is only valid during the call.
+	typedef void (*GDThrowCallbackFunction)(void* context, uint32_t group, uint32_t count, const GDDieResult* results);
+
+	// Rotation policy for godice_start_capture
+	typedef struct GDCaptureConfig
+	{
+		uint32_t max_file_bytes;			// a new file is started rather than grow past this
+		uint32_t max_files;					// including the one being written; the oldest is deleted
+	} GDCaptureConfig;
+
+	enum { GD_LATENCY_BUCKETS = 24 };
+
+	// Durations in power-of-two buckets: buckets[0] counts samples under 1 us, buckets[i]
+	// those from 2^(i-1) us up to 2^i us, and the last bucket everything longer
+	typedef struct GDLatencyHistogram
+	{
+		uint64_t count;
+		uint64_t total_ns;
+		uint64_t max_ns;
+		uint64_t buckets[GD_LATENCY_BUCKETS];
+	} GDLatencyHistogram;
+
+	// The order in which queued callbacks run: data first, discovery last. Within a
+	// priority they run in the order they were queued.
+	typedef enum GDPriority
+	{
+		GD_PRIORITY_DATA = 0,				// packets, and connection changes, so a die's data never overtakes its connected callback
+		GD_PRIORITY_CONTROL = 1,			// send results and other commands
+		GD_PRIORITY_DISCOVERY = 2,			// device found, listener stopped
+	} GDPriority;
+
+	enum { GD_PRIORITY_COUNT = 3 };
+
+	// What happens to a callback queued at a priority that already holds `capacity`, counting
+	// one that is running
+	typedef enum GDOverflowPolicy
+	{
+		GD_OVERFLOW_BLOCK = 0,				// the thread queueing it sleeps until a callback finishes, which holds up the Bluetooth stack; the framework's own threads queue past capacity instead, since waiting there could deadlock
+		GD_OVERFLOW_DROP_OLDEST = 1,		// the oldest queued callback is dropped to make room
+		GD_OVERFLOW_DROP_NEWEST = 2,		// this one is dropped
+	} GDOverflowPolicy;
+
+	// Limits for the callbacks queued at one GDPriority; see godice_set_queue_config
+	typedef struct GDQueueConfig
+	{
+		uint32_t capacity;					// 1 to 1024
+		uint32_t overflow;					// GDOverflowPolicy
+		bool coalesce;						// a newer event of the same kind for a die replaces one still queued
+	} GDQueueConfig;
+
+	typedef struct GDQueueStats
+	{
+		uint64_t enqueued;
+		uint64_t executed;
+		uint64_t depth;						// waiting or running when the snapshot was taken
+		uint64_t promoted;					// run ahead of higher priorities because they had waited too long
+		uint64_t dropped;					// by the GDOverflowPolicy
+		uint64_t coalesced;					// replaced by a newer event before they ran
+		// Sampled: each thread that enqueues times one item in 16, and every item below GD_PRIORITY_DATA
+		GDLatencyHistogram wait;			// from enqueue until the item starts
+		GDLatencyHistogram run;				// how long items take; on the callback queue, the client's callbacks
+		GDLatencyHistogram priority_wait[GD_PRIORITY_COUNT];	// wait, by GDPriority
+	} GDQueueStats;
+
+	// Totals since the framework was loaded; take differences between snapshots for rates
+	typedef struct GDStats
+	{
+		GDQueueStats bluetooth_queue;
+		GDQueueStats callback_queue;
+		uint64_t advertisements_received;
+		uint64_t advertisements_reported;	// passed on to the device found callback
+		GDLatencyHistogram advertisement_handling;
+		uint64_t notifications_received;
+		uint64_t connect_attempts;
+		uint64_t connect_failures;
+		GDLatencyHistogram connect;			// link, service discovery and subscription, once a connection slot is free
+		uint64_t link_losses;
+		uint64_t writes_sent;
+		uint64_t writes_coalesced;			// replaced by a newer command before they were sent
+		uint64_t writes_failed;
+		GDLatencyHistogram write;			// from starting a write until the transport completes it
+		uint64_t capture_recorded;
+		uint64_t capture_dropped;
+		uint64_t poll_events_dropped;		// packets and advertisements posted while the godice_poll_events queue was full
+		uint64_t shared_published;			// by godice_start_publishing
+		uint64_t shared_lost;				// skipped by godice_use_shared_transport after falling a whole ring behind
+		uint64_t shared_unlisted;			// advertisements from dice past GD_MAX_DEVICES, which godice_start_publishing could not list
+		uint64_t throws_completed;			// every die in the group came to rest
+		uint64_t throws_timed_out;			// reported by the settle timeout, with some dice still rolling
+	} GDStats;
+
+	// What a GDPollEvent reports; each corresponds to one of the callbacks
+	typedef enum GDPollEventType
+	{
+		GD_POLL_DEVICE_FOUND = 0,
+		GD_POLL_CONNECTED = 1,
+		GD_POLL_CONNECTION_FAILED = 2,
+		GD_POLL_DISCONNECTED = 3,
+		GD_POLL_DATA = 4,
+		GD_POLL_LISTENER_STOPPED = 5,
+	} GDPollEventType;
+
+	enum { GD_POLL_DATA_SIZE = 20 };
+
+	// One entry filled in by godice_poll_events. Fixed size and free of pointers, so an
+	// array of them can be passed straight from managed code.
+	typedef struct GDPollEvent
+	{
+		GDDeviceHandle device;				// 0 for GD_POLL_LISTENER_STOPPED
+		uint32_t type;						// GDPollEventType
+		uint32_t data_size;					// GD_POLL_DATA; longer packets are cut to GD_POLL_DATA_SIZE
+		GDEvent event;						// GD_POLL_DATA, decoded; GD_EVENT_UNKNOWN if not a recognised message
+		uint8_t data[GD_POLL_DATA_SIZE];
+		char name[32];						// GD_POLL_DEVICE_FOUND, NUL terminated
+	} GDPollEvent;
+
+	// Playback of a godice_start_capture file by godice_use_replay_transport
+	typedef struct GDReplayConfig
+	{
+		float speed;						// 1 keeps the captured timing, 10 plays ten times faster, 0 as fast as possible
+		uint32_t repeat_count;				// plays the capture back to back this many times; 0 counts as 1
+	} GDReplayConfig;
+
+	// Virtual dice for load testing without hardware. Rates are per die; the transport
+	// applies exponential inter-arrival times around them.
+	typedef struct GDSimulationConfig
+	{
+		uint32_t dice_count;
+		float rolls_per_second;				// while connected
+		float advertisements_per_second;	// while listening
+		uint32_t jitter_us;					// uniform random delay added to every delivered event
+		uint32_t connect_latency_ms;
+		float connect_failure_rate;			// probability that a connect attempt fails, 0-1
+		float disconnects_per_second;		// spontaneous link losses while connected
+		uint32_t seed;
+	} GDSimulationConfig;
+
+	// Filtering of repeated advertisements before they reach the device found callback.
+	// A known die is reported again only when its name changes, its smoothed RSSI moves
+	// by at least rssi_change_db, or suppression_window_ms has passed since it was last
+	// reported. A window of 0 reports every advertisement.
+	typedef struct GDCoalescingConfig
+	{
+		uint32_t suppression_window_ms;
+		float rssi_smoothing;				// weight of each new sample in the moving average, 0-1
+		uint32_t rssi_change_db;
+	} GDCoalescingConfig;
+
+	// The thread pool that runs the framework's Bluetooth work and callbacks
+	typedef struct GDExecutorConfig
+	{
+		uint32_t threads;					// 0 for the number of cores, between 2 and 8
+		uint64_t affinity_mask;				// worker i runs on the i-th cpu set in the mask, wrapping around; 0 leaves them unpinned
+		int32_t priority;					// -2 (lowest) to 2 (highest); 0 leaves it alone
+		bool parallel_callbacks;			// callbacks for different dice may run at once; each die's stay in order
+	} GDExecutorConfig;
+
+	// How godice_set_group decides a throw is over. A throw starts when any die in the
+	// group starts rolling and ends once every one has come to rest since; a die that is
+	// knocked over again goes back to rolling.
+	typedef struct GDGroupConfig
+	{
+		uint32_t settle_timeout_ms;			// from the first roll until the throw is reported with whatever has settled; 0 waits for every die
+	} GDGroupConfig;
+
+	GODICE_API void godice_set_callbacks(
 		GDDeviceFoundCallbackFunction deviceFoundCallback,
 		GDDataCallbackFunction dataReceivedCallback,
 		GDDeviceConnectedCallbackFunction deviceConnectedCallback,
 		GDDeviceConnectionFailedCallbackFunction deviceConnectionFailedCallback,
 		GDDeviceDisconnectedCallbackFunction deviceDisconnectedCallback,
 		GDListenerStoppedCallbackFunction listenerStoppedCallback);
-	__declspec(dllexport) void godice_set_logger(GDLogger logger);
-	__declspec(dllexport) void godice_start_listening();
-	__declspec(dllexport) void godice_stop_listening();
+	GODICE_API void godice_set_event_callback(GDEventCallbackFunction eventCallback);
+	// The logger is called on a background thread of its own, one message at a time and in order.
+	// Should info and debug messages come faster than it returns, the excess is dropped and a
+	// count of each is logged; errors and warnings are never dropped, though under such a flood
+	// one may be delivered on the thread that logged it, ahead of messages still queued.
+	GODICE_API void godice_set_logger(GDLogger logger);
+	// Messages above `level` are dropped where they are logged. Defaults to GD_LOG_INFO;
+	// GD_LOG_DEBUG adds every connect stage and write.
+	GODICE_API void godice_set_log_level(uint32_t level);
+	// Off Windows there is no platform BLE transport: listening stops straight away, with
+	// the listener stopped callback, unless one of the godice_use_*_transport calls below
+	// has replaced it.
+	GODICE_API void godice_start_listening();
+	GODICE_API void godice_stop_listening();
+
+	GODICE_API void godice_connect(const char* identifier);
+	// How many godice_connect attempts run at once; later ones wait their turn. Defaults to 4.
+	GODICE_API void godice_set_max_concurrent_connections(uint32_t max_connections);
+	GODICE_API void godice_disconnect(const char* identifier);
+	// Commands are queued per die. A newer LED command replaces one still waiting for the
+	// same die, and so does a repeated battery or color request.
+	GODICE_API void godice_send(const char* identifier, uint32_t data_size, uint8_t* data);
+	// Writes without response are pipelined, up to max_in_flight per die; writes with
+	// response go one at a time. Defaults to GD_WRITE_WITHOUT_RESPONSE with 4 in flight.
+	// A die that only supports the other kind of write gets that kind instead.
+	GODICE_API void godice_set_write_mode(uint32_t mode, uint32_t max_in_flight);
+
+	// Returns 0 if the identifier is malformed
+	GODICE_API GDDeviceHandle godice_device_handle(const char* identifier);
+	// Sends one command to many dice at once: the payload is copied once and every die's
+	// write starts straight away. callback may be null.
+	GODICE_API void godice_send_many(const char** identifiers, uint32_t count, uint32_t data_size, uint8_t* data,
+		GDSendManyCallbackFunction callback, void* context);
+	GODICE_API void godice_send_many_handles(const GDDeviceHandle* handles, uint32_t count, uint32_t data_size, uint8_t* data,
+		GDSendManyCallbackFunction callback, void* context);
 
-	__declspec(dllexport) void godice_connect(const char* identifier);
-	__declspec(dllexport) void godice_disconnect(const char* identifier);
-	__declspec(dllexport) void godice_send(const char* identifier, uint32_t data_size, uint8_t* data);
+	// Groups dice that are thrown together, such as everything on one table, and reports
+	// each throw with a single callback instead of leaving the host to piece it together
+	// from every die's events. A die belongs to one group at a time; adding it to another
+	// takes it out of the first. A count of 0 removes the group. Pass nullptr for the
+	// defaults (a 5s settle timeout).
+	GODICE_API void godice_set_group(uint32_t group, const GDDeviceHandle* handles, uint32_t count, const GDGroupConfig* config);
+	// Called on the callback threads, even while godice_enable_polling is on, after the
+	// data and event callbacks of every packet that led up to the throw, parallel_callbacks
+	// or not. Throws are reported one at a time, in order.
+	GODICE_API void godice_set_throw_callback(GDThrowCallbackFunction callback, void* context);
 	
-	__declspec(dllexport) void godice_reset();
+	GODICE_API void godice_reset();
+
+	// Dice seen in earlier runs are remembered in a memory-mapped file, reported by
+	// godice_start_listening straight away, and reconnect without full GATT discovery.
+	// Defaults to %LOCALAPPDATA%\GoDice\devices.cache on Windows and off elsewhere.
+	// Pass nullptr or "" to disable. Call before godice_start_listening.
+	GODICE_API void godice_set_device_cache_path(const char* path);
+	// Returns false if the cache is disabled or has no entry for the die
+	GODICE_API bool godice_get_device_info(const char* identifier, GDDeviceInfo* info);
+	GODICE_API void godice_set_die_type(const char* identifier, uint32_t die_type);
+
+	// Replaces the platform BLE transport with simulated dice. Pass nullptr for the defaults.
+	// Resets all known devices, so call it before godice_start_listening.
+	GODICE_API void godice_use_simulated_transport(const GDSimulationConfig* config);
+	// Replaces the platform BLE transport with a capture from godice_start_capture, played
+	// back through the usual callbacks. godice_start_listening starts playback, and
+	// listening stops when the capture has played out. Rotated files (path.1, ...) are
+	// played first. Returns false if path is not a capture. Pass nullptr for the defaults
+	// (original timing, once). Like the simulator, call it before godice_start_listening.
+	GODICE_API bool godice_use_replay_transport(const char* path, const GDReplayConfig* config);
+
+	// Daemon mode, for several processes on one host sharing the dice this one owns.
+	// Publishes every advertisement, packet and connection change the transport reports
+	// into shared memory called `name`, where each process that called
+	// godice_use_shared_transport(name) reads it independently. The last `capacity`
+	// events are kept (0 for 4096); a reader that falls further behind skips ahead and
+	// counts the loss in its GDStats. Up to GD_MAX_DEVICES dice are listed for readers
+	// that attach later. Connecting to the dice is still up to this process.
+	// Returns false if the shared memory could not be created.
+	GODICE_API bool godice_start_publishing(const char* name, uint32_t capacity);
+	// Readers stay attached, and carry on if publishing restarts under the same name
+	GODICE_API void godice_stop_publishing(void);
+	// Replaces the platform BLE transport with the dice a daemon publishes as `name`, and
+	// reports them through the usual callbacks or godice_poll_events. Connecting completes
+	// once the daemon holds the die, and fails if it does not within 10s; godice_send
+	// always fails, since only the daemon can write. Returns false if nothing is published
+	// as `name`, or 16 processes still running are already reading it. Call it before
+	// godice_start_listening.
+	GODICE_API bool godice_use_shared_transport(const char* name);
+
+	// Instead of calling the callbacks, queues every event for godice_poll_events, e.g. to
+	// drain them once per frame on a game's main thread. Up to `capacity` packets and
+	// advertisements wait; more are dropped and counted in GDStats. Connection changes and
+	// listener stopped are never dropped: they have room of their own beyond `capacity`,
+	// and should even that fill up, they go to their callbacks instead. 0 goes back to
+	// callbacks and discards whatever is still queued. godice_send_many still reports
+	// through its callback.
+	GODICE_API void godice_enable_polling(uint32_t capacity);
+	// Moves up to max_events queued events into `events`, oldest first, and returns how many.
+	// Call from one thread at a time.
+	GODICE_API uint32_t godice_poll_events(GDPollEvent* events, uint32_t max_events);
+	// A handle that is signalled while godice_poll_events has events to return, for hosts
+	// that wait in their own event loop (epoll, select, libuv, WaitForMultipleObjects):
+	// an eventfd on Linux, the read end of a pipe on other POSIX systems, and a
+	// manual-reset event HANDLE on Windows. godice_poll_events resets it, or leaves it set
+	// if events remain. Get it before godice_start_listening. The framework owns the
+	// handle; never read from, write to or close it. Returns -1 if it could not be created.
+	GODICE_API intptr_t godice_get_wait_handle(void);
+
+	// Pass nullptr for the defaults (1s window, 0.25 smoothing, 6dB)
+	GODICE_API void godice_set_coalescing(const GDCoalescingConfig* config);
+
+	// Pass nullptr for the defaults (a thread per core, unpinned, normal priority, callbacks
+	// one at a time). Returns false once the framework has started its threads, so call it
+	// before anything else.
+	GODICE_API bool godice_configure_executor(const GDExecutorConfig* config);
+	// Bounds the callbacks waiting at one GDPriority, so a host that stops taking them (a
+	// debugger break, a long GC pause) costs a fixed amount of memory. Pass nullptr for the
+	// defaults: every priority holds 1024, data and control block, and discovery drops the
+	// oldest and coalesces device found per die. Only device found coalesces. Takes effect
+	// at once.
+	GODICE_API void godice_set_queue_config(uint32_t priority, const GDQueueConfig* config);
+
+	// Appends every advertisement, notification, write and connection change to a binary
+	// file at path; see TrafficCapture.h for the format. Earlier captures at path are kept
+	// as path.1, path.2, ... Pass nullptr for the defaults (64 MiB files, 4 files).
+	GODICE_API bool godice_start_capture(const char* path, const GDCaptureConfig* config);
+	GODICE_API void godice_stop_capture();
+
+	// Records connect stages, queue hops and callbacks into a ring that keeps the most recent
+	// `capacity` spans (0 for 65536). Off by default; costs one atomic load per span while off.
+	GODICE_API void godice_start_trace(uint32_t capacity);
+	GODICE_API void godice_stop_trace();
+	// Writes the spans in the ring as Chrome trace-event JSON, for chrome://tracing or
+	// ui.perfetto.dev. Each die gets a track of its own. Works while tracing runs.
+	GODICE_API bool godice_write_trace(const char* path);
+
+	// Snapshots the framework's counters without pausing it. Safe from any thread.
+	GODICE_API void godice_get_stats(GDStats* stats);
+	// Copies the state of up to max_states dice, in the order they were first seen, and
+	// returns how many it copied; GD_MAX_DEVICES is always enough. Takes no locks and
+	// never hops onto the framework's threads, so it can be called every frame. Each die
+	// is consistent in itself; dice are copied one after another. godice_reset starts it
+	// over from the dice in the device cache.
+	GODICE_API uint32_t godice_snapshot(GDDeviceState* states, uint32_t max_states);
+
+	// Returns false (and sets type to GD_EVENT_UNKNOWN) if the packet is not a recognised message
+	GODICE_API bool godice_decode_packet(uint32_t data_size, const uint8_t* data, GDEvent* event);
+
+	// Map stable vectors to face values (1-based; 10-100 for GD_DIE_D10X). Returns 0 for an unknown die type,
+	// and for now for every type but GD_DIE_D6 and GD_DIE_D20, whose face vectors are not verified yet.
+	GODICE_API uint8_t godice_classify_face(uint32_t die_type, GDVector vector);
+	// Classifies `count` vectors of one die type in a single vectorised pass
+	GODICE_API void godice_classify_faces(uint32_t die_type, uint32_t count, const GDVector* vectors, uint8_t* faces);
 }
@@ -0,0 +1,29 @@
+#include "GoDiceProtocol.h"
+
+namespace
+{
+    constexpr auto decodes_to(std::array<uint8_t, 5> packet, uint32_t size, GDEventType type) -> bool
+    {
+        GDEvent event{};
+        return godice::protocol::decode(packet.data(), size, event) && event.type == type;
+    }
+
+    static_assert(decodes_to({ 'R' }, 1, GD_EVENT_ROLL_STARTED));
+    static_assert(decodes_to({ 'S', 1, 2, 3 }, 4, GD_EVENT_STABLE));
+    static_assert(decodes_to({ 'T', 'S', 1, 2, 3 }, 5, GD_EVENT_TILT_STABLE));
+    static_assert(decodes_to({ 'C', 'o', 'l', 2 }, 4, GD_EVENT_COLOR));
+    static_assert(!decodes_to({ 'F', 'X', 1, 2, 3 }, 5, GD_EVENT_FAKE_STABLE));
+
+    constexpr uint8_t k_pulse_red[] = { 16, 5, 4, 4, 0xFF, 0, 0, 1, 0 };
+    constexpr uint8_t k_solid_blue[] = { 8, 0, 0, 0xFF, 0, 0, 0xFF };
+    static_assert(godice::protocol::command_class(k_pulse_red, 9) == godice::protocol::command_class(k_solid_blue, 7));
+    static_assert(godice::protocol::command_class(k_pulse_red, 0) == 0);
+}
+
+bool godice_decode_packet(uint32_t data_size, const uint8_t* data, GDEvent* event)
+{
+    if (event == nullptr) return false;
+    if (data == nullptr) data_size = 0;
+
+    return godice::protocol::decode(data, data_size, *event);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "GoDiceDll.h"
+
+// GoDice notification format. The first byte selects the message:
+//
+//   'R'                 roll started
+//   'S' x y z           stable, with the resting accelerometer vector
+//   'F' 'S' x y z       fake stable
+//   'T' 'S' x y z       tilt stable
+//   'M' 'S' x y z       move stable
+//   'B' 'a' 't' level   battery level, 0-100
+//   'C' 'o' 'l' color   die color index
+//
+// Vector components are signed bytes.
+namespace godice::protocol
+{
+    enum class PacketKind : uint8_t
+    {
+        Unknown,
+        RollStarted,
+        Stable,
+        PrefixedStable,
+        Battery,
+        Color,
+    };
+
+    inline constexpr std::array<PacketKind, 256> k_dispatch = []
+    {
+        std::array<PacketKind, 256> table{};
+        table['R'] = PacketKind::RollStarted;
+        table['S'] = PacketKind::Stable;
+        table['F'] = PacketKind::PrefixedStable;
+        table['T'] = PacketKind::PrefixedStable;
+        table['M'] = PacketKind::PrefixedStable;
+        table['B'] = PacketKind::Battery;
+        table['C'] = PacketKind::Color;
+        return table;
+    }();
+
+    constexpr auto stable_type(uint8_t prefix) -> GDEventType
+    {
+        switch (prefix)
+        {
+        case 'F':
+            return GD_EVENT_FAKE_STABLE;
+        case 'T':
+            return GD_EVENT_TILT_STABLE;
+        case 'M':
+            return GD_EVENT_MOVE_STABLE;
+        default:
+            return GD_EVENT_STABLE;
+        }
+    }
+
+    constexpr auto read_vector(const uint8_t* vector, GDEvent& event) -> void
+    {
+        event.x = static_cast<int8_t>(vector[0]);
+        event.y = static_cast<int8_t>(vector[1]);
+        event.z = static_cast<int8_t>(vector[2]);
+    }
+
+    constexpr auto decode(const uint8_t* data, uint32_t size, GDEvent& event) -> bool
+    {
+        event = GDEvent{ GD_EVENT_UNKNOWN, 0, 0, 0, 0 };
+        if (size == 0) return false;
+
+        switch (k_dispatch[data[0]])
+        {
+        case PacketKind::RollStarted:
+            event.type = GD_EVENT_ROLL_STARTED;
+            return true;
+
+        case PacketKind::Stable:
+            if (size < 4) return false;
+            event.type = GD_EVENT_STABLE;
+            read_vector(data + 1, event);
+            return true;
+
+        case PacketKind::PrefixedStable:
+            if (size < 5 || data[1] != 'S') return false;
+            event.type = stable_type(data[0]);
+            read_vector(data + 2, event);
+            return true;
+
+        case PacketKind::Battery:
+            if (size < 4 || data[1] != 'a' || data[2] != 't') return false;
+            event.type = GD_EVENT_BATTERY_LEVEL;
+            event.value = data[3];
+            return true;
+
+        case PacketKind::Color:
+            if (size < 4 || data[1] != 'o' || data[2] != 'l') return false;
+            event.type = GD_EVENT_COLOR;
+            event.value = data[3];
+            return true;
+
+        case PacketKind::Unknown:
+            break;
+        }
+        return false;
+    }
+
+    // Commands written to the die, selected by their first byte (see GoDiceDataParser.swift)
+    inline constexpr uint8_t k_battery_level_request = 3;
+    inline constexpr uint8_t k_set_led = 8;
+    inline constexpr uint8_t k_set_led_toggle = 16;
+    inline constexpr uint8_t k_color_request = 23;
+
+    // Queued commands with the same non-zero class supersede each other: only the newest
+    // LED state matters, and a second identical request adds nothing
+    constexpr auto command_class(const uint8_t* data, uint32_t size) -> uint8_t
+    {
+        if (size == 0) return 0;
+
+        switch (data[0])
+        {
+        case k_set_led:
+        case k_set_led_toggle:
+            return k_set_led;
+        case k_battery_level_request:
+        case k_color_request:
+            return size == 1 ? data[0] : 0;
+        default:
+            return 0;
+        }
+    }
+}
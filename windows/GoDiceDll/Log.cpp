@@ -0,0 +1,271 @@
+#include "Log.h"
+
+#include <array>
+#include <mutex>
+#include <thread>
+
+#include "MpscRing.h"
+
+using godice::logging::Record;
+
+std::atomic<GDLogger> godice::logging::g_logger = nullptr;
+std::atomic<uint32_t> godice::logging::g_level = GD_LOG_INFO;
+
+namespace
+{
+    constexpr size_t k_ring_capacity = 1024;
+    // Room beyond k_ring_capacity that only errors and warnings may take
+    constexpr size_t k_reserved_capacity = 64;
+
+    template <typename T>
+    auto read(const Record& record, size_t& offset) -> T
+    {
+        T value;
+        std::memcpy(&value, record.payload + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    // Appends the next argument, or returns false once they run out
+    auto append_arg(std::string& out, const Record& record, size_t& offset) -> bool
+    {
+        if (offset >= record.used) return false;
+
+        switch (record.payload[offset++])
+        {
+        case godice::logging::k_bool:
+            out += read<bool>(record, offset) ? "true" : "false";
+            break;
+        case godice::logging::k_char:
+            out += read<char>(record, offset);
+            break;
+        case godice::logging::k_signed:
+            out += std::to_string(read<int64_t>(record, offset));
+            break;
+        case godice::logging::k_unsigned:
+            out += std::to_string(read<uint64_t>(record, offset));
+            break;
+        case godice::logging::k_double:
+            out += std::to_string(read<double>(record, offset));
+            break;
+        case godice::logging::k_string:
+        {
+            const auto length = read<uint16_t>(record, offset);
+            out.append(record.payload + offset, length);
+            offset += length;
+            break;
+        }
+        default:
+            return false;
+        }
+        return true;
+    }
+
+    void format_record(std::string& out, const Record& record)
+    {
+        size_t offset = 0;
+        if (record.tagged)
+        {
+            out += '[';
+            append_arg(out, record, offset);
+            out += "] ";
+        }
+
+        std::string_view format = record.format;
+        for (auto placeholder = format.find("{}"); placeholder != std::string_view::npos; placeholder = format.find("{}"))
+        {
+            out += format.substr(0, placeholder);
+            if (!append_arg(out, record, offset))
+            {
+                // Arguments that did not fit in the record
+                out += "...";
+            }
+            format.remove_prefix(placeholder + 2);
+        }
+        out += format;
+    }
+
+    // Owns the ring and the thread that empties it. The ring is never freed, so a thread
+    // still logging while the process shuts down pushes into it harmlessly.
+    class AsyncLog
+    {
+    public:
+        ~AsyncLog()
+        {
+            godice::logging::g_logger.store(nullptr);
+            if (thread_.joinable())
+            {
+                keep_running_ = false;
+                wake();
+                thread_.join();
+            }
+        }
+
+        void start()
+        {
+            std::call_once(started_, [this]
+            {
+                auto* ring = new MpscRing<Record>(k_ring_capacity + k_reserved_capacity);
+                thread_ = std::thread(&AsyncLog::run, this, ring);
+                // Published after thread_, which flush() reads once it sees the ring
+                ring_.store(ring, std::memory_order_release);
+            });
+        }
+
+        void submit(const Record& record)
+        {
+            MpscRing<Record>* ring = ring_.load(std::memory_order_acquire);
+            if (ring == nullptr) return;
+
+            const bool droppable = record.level > godice::LogLevel::Warning;
+            if (droppable && ring->size() >= k_ring_capacity)
+            {
+                dropped_[static_cast<size_t>(record.level)].fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (ring->try_push(record))
+            {
+                pushed_.fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (droppable)
+            {
+                dropped_[static_cast<size_t>(record.level)].fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                // Even the reserve is full; an error is worth the caller's time, and its place in line
+                std::string line;
+                format_record(line, record);
+                deliver(line);
+            }
+            wake_if_parked();
+        }
+
+        void flush()
+        {
+            if (ring_.load(std::memory_order_acquire) == nullptr || std::this_thread::get_id() == thread_.get_id()) return;
+
+            const uint64_t target = pushed_.load(std::memory_order_relaxed);
+            while (delivered_.load(std::memory_order_acquire) < target && keep_running_.load(std::memory_order_relaxed))
+            {
+                wake();
+                std::this_thread::yield();
+            }
+        }
+
+    private:
+        std::atomic<MpscRing<Record>*> ring_ = nullptr;
+        std::once_flag started_;
+        std::thread thread_;
+
+        std::atomic<uint64_t> pushed_ = 0;
+        std::atomic<uint64_t> delivered_ = 0;
+        // Indexed by LogLevel; only Info and Debug are ever counted
+        std::array<std::atomic<uint64_t>, 4> dropped_{};
+        // Keeps the logger to one message at a time when a caller delivers its own error
+        std::recursive_mutex deliver_mutex_;
+
+        std::atomic<bool> keep_running_ = true;
+        std::atomic<bool> parked_ = false;
+        std::atomic<uint32_t> wake_sequence_ = 0;
+
+        void wake()
+        {
+            wake_sequence_.fetch_add(1, std::memory_order_release);
+            wake_sequence_.notify_one();
+        }
+
+        // Same handshake as WorkQueue: only a producer that sees the thread parked pays for the notify
+        void wake_if_parked()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (parked_.load(std::memory_order_relaxed) && parked_.exchange(false, std::memory_order_relaxed))
+            {
+                wake();
+            }
+        }
+
+        void run(MpscRing<Record>* ring)
+        {
+            Record record{};
+            std::string line;
+
+            while (keep_running_.load(std::memory_order_relaxed))
+            {
+                report_dropped();
+
+                if (ring->try_pop(record))
+                {
+                    line.clear();
+                    format_record(line, record);
+                    deliver(line);
+                    delivered_.fetch_add(1, std::memory_order_release);
+                    continue;
+                }
+
+                const uint32_t key = wake_sequence_.load(std::memory_order_acquire);
+                parked_.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                if (ring->size() == 0 && !any_dropped() && keep_running_.load(std::memory_order_relaxed))
+                {
+                    wake_sequence_.wait(key, std::memory_order_acquire);
+                }
+                parked_.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        [[nodiscard]] auto any_dropped() const -> bool
+        {
+            return std::any_of(dropped_.begin(), dropped_.end(), [](const std::atomic<uint64_t>& count)
+            {
+                return count.load(std::memory_order_relaxed) != 0;
+            });
+        }
+
+        void report_dropped()
+        {
+            const uint64_t info = dropped_[static_cast<size_t>(godice::LogLevel::Info)].exchange(0, std::memory_order_relaxed);
+            const uint64_t debug = dropped_[static_cast<size_t>(godice::LogLevel::Debug)].exchange(0, std::memory_order_relaxed);
+            if (info + debug == 0) return;
+
+            deliver("[log] " + std::to_string(info + debug) + " messages dropped, the logger fell behind: " +
+                    std::to_string(info) + " info, " + std::to_string(debug) + " debug\n");
+        }
+
+        void deliver(const std::string& line)
+        {
+            const std::lock_guard lock(deliver_mutex_);
+            if (const GDLogger logger = godice::logging::g_logger.load(std::memory_order_acquire))
+            {
+                logger(line.c_str());
+            }
+        }
+    };
+
+    AsyncLog g_async_log;
+}
+
+void godice::set_logger(GDLogger logger)
+{
+    if (logger != nullptr)
+    {
+        g_async_log.start();
+    }
+    g_async_log.flush();
+    logging::g_logger.store(logger, std::memory_order_release);
+}
+
+void godice::set_log_level(uint32_t level)
+{
+    logging::g_level.store(level, std::memory_order_relaxed);
+}
+
+void godice::flush_log()
+{
+    g_async_log.flush();
+}
+
+void godice::logging::submit(const Record& record)
+{
+    g_async_log.submit(record);
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "GoDiceDll.h"
+
+// Levels above this are compiled out entirely; define it as e.g. GD_LOG_INFO to drop
+// the debug messages from a build
+#ifndef GODICE_LOG_LEVEL
+#define GODICE_LOG_LEVEL GD_LOG_DEBUG
+#endif
+
+// Logging shared by the core and the transports. Messages use "{}" placeholders;
+// only plain substitution is supported, which is all the framework has ever used,
+// and it keeps us independent of <format> support in the toolchain.
+//
+// Logging never formats on the caller's thread. A message's arguments are copied into
+// a fixed-size record on a lock-free ring, and a background thread formats the records
+// and hands them to the logger in order. The format string is kept by pointer, so it
+// must be a string literal. A full ring drops info and debug messages rather than
+// blocking, and the logger is told how many of each were lost. Errors and warnings are
+// never dropped: the ring keeps a few records beyond its capacity for them, and one
+// that finds even those taken is formatted and delivered on the caller's thread. A level that is compiled out or filtered out at
+// runtime costs at most two relaxed loads, though its arguments are still evaluated.
+namespace godice
+{
+    enum class LogLevel : uint8_t
+    {
+        Error = GD_LOG_ERROR,
+        Warning = GD_LOG_WARNING,
+        Info = GD_LOG_INFO,
+        Debug = GD_LOG_DEBUG,
+    };
+
+    // Waits until everything logged so far has reached the old logger
+    void set_logger(GDLogger logger);
+    void set_log_level(uint32_t level);
+    void flush_log();
+
+    namespace logging
+    {
+        extern std::atomic<GDLogger> g_logger;
+        extern std::atomic<uint32_t> g_level;
+
+        inline auto enabled(LogLevel level) -> bool
+        {
+            return static_cast<uint32_t>(level) <= g_level.load(std::memory_order_relaxed) &&
+                   g_logger.load(std::memory_order_relaxed) != nullptr;
+        }
+
+        struct Record
+        {
+            static constexpr size_t k_size = 256;
+
+            const char* format;
+            LogLevel level;
+            // The first argument is a tag, printed as "[tag] " before the message
+            bool tagged;
+            uint16_t used;
+            // Each argument is a type byte followed by its value; strings carry a 16-bit length
+            char payload[k_size - 16];
+        };
+
+        enum ArgType : char
+        {
+            k_bool = 'b',
+            k_char = 'c',
+            k_signed = 'i',
+            k_unsigned = 'u',
+            k_double = 'd',
+            k_string = 's',
+        };
+
+        template <typename T>
+        void put(Record& record, ArgType type, const T& value)
+        {
+            if (record.used + 1 + sizeof(T) > sizeof(record.payload)) return;
+
+            record.payload[record.used] = type;
+            std::memcpy(record.payload + record.used + 1, &value, sizeof(T));
+            record.used = static_cast<uint16_t>(record.used + 1 + sizeof(T));
+        }
+
+        // Truncates the string to whatever room is left
+        inline void put_string(Record& record, std::string_view text)
+        {
+            constexpr size_t header = 1 + sizeof(uint16_t);
+            if (record.used + header > sizeof(record.payload)) return;
+
+            const auto length = static_cast<uint16_t>(std::min(text.size(), sizeof(record.payload) - record.used - header));
+            record.payload[record.used] = k_string;
+            std::memcpy(record.payload + record.used + 1, &length, sizeof(length));
+            std::memcpy(record.payload + record.used + header, text.data(), length);
+            record.used = static_cast<uint16_t>(record.used + header + length);
+        }
+
+        template <typename T>
+        void capture(Record& record, const T& value)
+        {
+            using V = std::decay_t<T>;
+            if constexpr (std::is_same_v<V, bool>)
+            {
+                put(record, k_bool, value);
+            }
+            else if constexpr (std::is_same_v<V, char>)
+            {
+                put(record, k_char, value);
+            }
+            else if constexpr (std::is_integral_v<V> && std::is_signed_v<V>)
+            {
+                put(record, k_signed, static_cast<int64_t>(value));
+            }
+            else if constexpr (std::is_integral_v<V>)
+            {
+                put(record, k_unsigned, static_cast<uint64_t>(value));
+            }
+            else if constexpr (std::is_floating_point_v<V>)
+            {
+                put(record, k_double, static_cast<double>(value));
+            }
+            else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+            {
+                put_string(record, std::string_view(value));
+            }
+            else
+            {
+                // Anything else only has operator<<, so this one is formatted up front
+                std::ostringstream stream;
+                stream << value;
+                put_string(record, stream.str());
+            }
+        }
+
+        // Takes a copy of the record; never blocks
+        void submit(const Record& record);
+
+        template <LogLevel Level, typename... P>
+        void write(const std::string_view* tag, const char* format, const P&... args)
+        {
+            if constexpr (static_cast<uint32_t>(Level) <= GODICE_LOG_LEVEL)
+            {
+                if (!enabled(Level)) return;
+
+                Record record;
+                record.format = format;
+                record.level = Level;
+                record.tagged = tag != nullptr;
+                record.used = 0;
+                if (tag != nullptr)
+                {
+                    put_string(record, *tag);
+                }
+                (capture(record, args), ...);
+                submit(record);
+            }
+        }
+    }
+
+    template <typename... P>
+    void log_error(const char* format, const P&... args)
+    {
+        logging::write<LogLevel::Error>(nullptr, format, args...);
+    }
+
+    template <typename... P>
+    void log_warning(const char* format, const P&... args)
+    {
+        logging::write<LogLevel::Warning>(nullptr, format, args...);
+    }
+
+    template <typename... P>
+    void log_info(const char* format, const P&... args)
+    {
+        logging::write<LogLevel::Info>(nullptr, format, args...);
+    }
+
+    template <typename... P>
+    void log_debug(const char* format, const P&... args)
+    {
+        logging::write<LogLevel::Debug>(nullptr, format, args...);
+    }
+
+    // Prefixes the message with "[tag] ", e.g. a die's name
+    template <LogLevel Level, typename... P>
+    void log_tagged(std::string_view tag, const char* format, const P&... args)
+    {
+        logging::write<Level>(&tag, format, args...);
+    }
+}
@@ -0,0 +1,117 @@
+#include "MappedFile.h"
+
+#include <filesystem>
+#include <system_error>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+auto MappedFile::open(const std::string& path, size_t size) -> bool
+{
+    close();
+    if (size == 0) return false;
+
+    const std::filesystem::path file_path(path);
+    if (file_path.has_parent_path())
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(file_path.parent_path(), ec);
+    }
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileW(file_path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    // Mapping a range beyond the end of the file extends it with zeros
+    const auto high = static_cast<DWORD>(static_cast<uint64_t>(size) >> 32);
+    const auto low = static_cast<DWORD>(size);
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, high, low, nullptr);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, size);
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    file_ = file;
+    mapping_ = mapping;
+    data_ = static_cast<uint8_t*>(view);
+#else
+    const int fd = ::open(file_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || (static_cast<size_t>(st.st_size) < size && ftruncate(fd, static_cast<off_t>(size)) != 0))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    fd_ = fd;
+    data_ = static_cast<uint8_t*>(view);
+#endif
+
+    path_ = path;
+    size_ = size;
+    return true;
+}
+
+void MappedFile::flush()
+{
+    if (data_ == nullptr) return;
+
+#if defined(_WIN32)
+    FlushViewOfFile(data_, size_);
+#else
+    msync(data_, size_, MS_ASYNC);
+#endif
+}
+
+void MappedFile::close()
+{
+    if (data_ == nullptr) return;
+
+    flush();
+#if defined(_WIN32)
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_);
+    CloseHandle(file_);
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    munmap(data_, size_);
+    ::close(fd_);
+    fd_ = -1;
+#endif
+
+    data_ = nullptr;
+    size_ = 0;
+    path_.clear();
+}
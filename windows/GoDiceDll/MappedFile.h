@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A file mapped read-write into memory. Stores to data() reach the file without
+// further calls; flush() asks the OS to write dirty pages back now.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Opens or creates `path` (and its parent directory) and maps the first `size`
+    // bytes, growing the file with zeros if it is shorter. Returns false on failure.
+    auto open(const std::string& path, size_t size) -> bool;
+    void close();
+
+    void flush();
+
+    [[nodiscard]] auto is_open() const -> bool { return data_ != nullptr; }
+    [[nodiscard]] auto data() const -> uint8_t* { return data_; }
+    [[nodiscard]] auto size() const -> size_t { return size_; }
+    [[nodiscard]] auto path() const -> const std::string& { return path_; }
+
+private:
+    std::string path_;
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+
+#if defined(_WIN32)
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
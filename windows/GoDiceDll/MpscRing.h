@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+// Bounded multi-producer/single-consumer ring. Each slot carries a sequence number
+// (Vyukov-style), so producers only contend on a single fetch position and the
+// consumer never takes a lock. Capacity is rounded up to a power of two.
+template <typename T>
+class MpscRing
+{
+private:
+    static constexpr size_t k_cache_line = 64;
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    const size_t mask_;
+    const std::unique_ptr<Slot[]> slots_;
+
+    alignas(k_cache_line) std::atomic<size_t> enqueue_pos_ = 0;
+    alignas(k_cache_line) std::atomic<size_t> dequeue_pos_ = 0;
+
+    static auto round_up_pow2(size_t n) -> size_t
+    {
+        size_t result = 2;
+        while (result < n)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+public:
+    explicit MpscRing(size_t capacity) : mask_(round_up_pow2(capacity) - 1), slots_(new Slot[mask_ + 1])
+    {
+        for (size_t i = 0; i <= mask_; i++)
+        {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    // Safe to call from any number of threads. Returns false if the ring is full.
+    template <typename U>
+    auto try_push(U&& item) -> bool
+    {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Slot& slot = slots_[pos & mask_];
+            const size_t seq = slot.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.value = std::forward<U>(item);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Only the single consumer thread may call this.
+    auto try_pop(T& out) -> bool
+    {
+        const size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[pos & mask_];
+        const size_t seq = slot.sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0)
+        {
+            return false;
+        }
+
+        out = std::move(slot.value);
+        slot.value = T();
+        slot.sequence.store(pos + mask_ + 1, std::memory_order_release);
+        dequeue_pos_.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called concurrently with producers.
+    [[nodiscard]] auto size() const -> size_t
+    {
+        const size_t head = enqueue_pos_.load(std::memory_order_acquire);
+        const size_t tail = dequeue_pos_.load(std::memory_order_acquire);
+        return head >= tail ? head - tail : 0;
+    }
+
+    [[nodiscard]] auto capacity() const -> size_t { return mask_ + 1; }
+};
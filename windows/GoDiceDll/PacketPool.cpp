@@ -0,0 +1,91 @@
+#include "PacketPool.h"
+
+#include <chrono>
+#include <cstring>
+
+PacketPool::PacketPool(uint32_t capacity) : capacity_(capacity), records_(new PacketRecord[capacity])
+{
+    for (uint32_t i = 0; i < capacity_; i++)
+    {
+        records_[i].pooled_ = true;
+        records_[i].next_free_.store(i + 1 < capacity_ ? i + 1 : k_end_of_list, std::memory_order_relaxed);
+    }
+    free_head_.store(capacity_ > 0 ? 0 : k_end_of_list);
+}
+
+auto PacketPool::pop_free() -> PacketRecord*
+{
+    uint64_t head = free_head_.load(std::memory_order_acquire);
+    for (;;)
+    {
+        const auto index = static_cast<uint32_t>(head);
+        if (index == k_end_of_list)
+        {
+            return nullptr;
+        }
+
+        const uint64_t tag = (head >> 32) + 1;
+        const uint64_t next = (tag << 32) | records_[index].next_free_.load(std::memory_order_relaxed);
+        if (free_head_.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            return &records_[index];
+        }
+    }
+}
+
+void PacketPool::push_free(PacketRecord* record)
+{
+    const auto index = static_cast<uint32_t>(record - records_.get());
+    uint64_t head = free_head_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        record->next_free_.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        const uint64_t tag = (head >> 32) + 1;
+        const uint64_t next = (tag << 32) | index;
+        if (free_head_.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+}
+
+auto PacketPool::acquire(const char* identifier, const uint8_t* data, uint32_t size) -> PacketRecord*
+{
+    const size_t identifier_length = std::strlen(identifier);
+    if (size > PacketRecord::k_max_payload_size || identifier_length >= PacketRecord::k_max_identifier_length)
+    {
+        return nullptr;
+    }
+
+    PacketRecord* record = pop_free();
+    if (record == nullptr)
+    {
+        record = new PacketRecord();
+        record->pooled_ = false;
+    }
+
+    std::memcpy(record->identifier, identifier, identifier_length + 1);
+    if (size > 0)
+    {
+        std::memcpy(record->payload, data, size);
+    }
+    record->size = size;
+    record->timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    return record;
+}
+
+void PacketPool::release(PacketRecord* record)
+{
+    if (record == nullptr) return;
+
+    if (record->pooled_)
+    {
+        push_free(record);
+    }
+    else
+    {
+        delete record;
+    }
+}
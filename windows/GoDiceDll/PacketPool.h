@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// One received notification. Identifier and payload are stored inline so that
+// queueing a packet for the callback thread never touches the heap.
+struct PacketRecord
+{
+    static constexpr size_t k_max_identifier_length = 24;
+    static constexpr size_t k_max_payload_size = 64;
+
+    char identifier[k_max_identifier_length];
+    uint8_t payload[k_max_payload_size];
+    uint32_t size;
+    // steady_clock time at which the packet was handed to us, in nanoseconds
+    int64_t timestamp_ns;
+
+private:
+    friend class PacketPool;
+    std::atomic<uint32_t> next_free_;
+    bool pooled_;
+};
+
+// Fixed-size slab of PacketRecords recycled through a lock-free free list.
+// acquire() may be called from any thread (WinRT raises ValueChanged on pool
+// threads) and release() from the callback thread. If the slab is exhausted the
+// record comes from the heap instead, so a burst degrades to the old behaviour
+// rather than dropping data.
+class PacketPool
+{
+private:
+    static constexpr uint32_t k_end_of_list = UINT32_MAX;
+
+    const uint32_t capacity_;
+    const std::unique_ptr<PacketRecord[]> records_;
+
+    // low 32 bits: index of the first free record, high 32 bits: ABA tag
+    std::atomic<uint64_t> free_head_;
+
+    auto pop_free() -> PacketRecord*;
+    void push_free(PacketRecord* record);
+
+public:
+    explicit PacketPool(uint32_t capacity);
+
+    PacketPool(const PacketPool&) = delete;
+    PacketPool& operator=(const PacketPool&) = delete;
+
+    // Returns nullptr if the packet or identifier does not fit in a record.
+    auto acquire(const char* identifier, const uint8_t* data, uint32_t size) -> PacketRecord*;
+    void release(PacketRecord* record);
+
+    [[nodiscard]] auto capacity() const -> uint32_t { return capacity_; }
+};
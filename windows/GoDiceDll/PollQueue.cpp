@@ -0,0 +1,92 @@
+#include "PollQueue.h"
+
+// The Unity sample mirrors the layout in C#
+static_assert(sizeof(GDPollEvent) == 80);
+
+void PollQueue::set_capacity(uint32_t capacity)
+{
+    std::scoped_lock lk(mutex_);
+    if (capacity == 0)
+    {
+        ring_.store(nullptr, std::memory_order_release);
+        return;
+    }
+
+    capacity_.store(capacity, std::memory_order_relaxed);
+    rings_.push_back(std::make_unique<MpscRing<GDPollEvent>>(static_cast<size_t>(capacity) + k_state_headroom));
+    ring_.store(rings_.back().get(), std::memory_order_release);
+}
+
+auto PollQueue::post(const GDPollEvent& event) -> bool
+{
+    MpscRing<GDPollEvent>* ring = ring_.load(std::memory_order_acquire);
+    if (ring == nullptr) return false;
+
+    // A host that missed a connection change would have the wrong idea of its dice for good,
+    // whereas packets and advertisements keep coming
+    const bool droppable = event.type == GD_POLL_DATA || event.type == GD_POLL_DEVICE_FOUND;
+    if (droppable && ring->size() >= capacity_.load(std::memory_order_relaxed))
+    {
+        dropped_.add();
+        return true;
+    }
+    if (!ring->try_push(event))
+    {
+        if (!droppable) return false;
+
+        dropped_.add();
+        return true;
+    }
+    signal();
+    return true;
+}
+
+void PollQueue::signal()
+{
+    WaitableEvent* waitable = event_.load(std::memory_order_acquire);
+    if (waitable != nullptr && !signaled_.exchange(true))
+    {
+        waitable->set();
+    }
+}
+
+auto PollQueue::poll(GDPollEvent* events, uint32_t max_events) -> uint32_t
+{
+    MpscRing<GDPollEvent>* ring = ring_.load(std::memory_order_acquire);
+    if (ring == nullptr || events == nullptr) return 0;
+
+    // Reset before clearing the flag: a post that finds the flag still set is then seen
+    // by the drain below, and one that finds it clear sets the event after this reset
+    if (WaitableEvent* waitable = event_.load(std::memory_order_acquire); waitable != nullptr && signaled_.load())
+    {
+        waitable->reset();
+        signaled_.exchange(false);
+    }
+
+    uint32_t count = 0;
+    while (count < max_events && ring->try_pop(events[count]))
+    {
+        count++;
+    }
+
+    // The caller's array filled up with events still waiting
+    if (count == max_events && ring->size() > 0)
+    {
+        signal();
+    }
+    return count;
+}
+
+auto PollQueue::wait_handle() -> intptr_t
+{
+    std::scoped_lock lk(mutex_);
+    if (owned_event_ == nullptr)
+    {
+        owned_event_ = std::make_unique<WaitableEvent>();
+        event_.store(owned_event_.get());
+        // Anything posted before the host asked would otherwise never be signalled
+        signaled_.store(true);
+        owned_event_->set();
+    }
+    return owned_event_->handle();
+}
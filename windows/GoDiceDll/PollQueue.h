@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "GoDiceDll.h"
+#include "MpscRing.h"
+#include "Stats.h"
+#include "WaitableEvent.h"
+
+// Events for a host that drains them with godice_poll_events rather than taking
+// callbacks. Transport threads, the watcher and the bluetooth queue all post
+// straight into one MPSC ring, so an event is a single copy and no thread hop away
+// from the host. A full ring drops the event instead of stalling the radio thread.
+// Only packets and advertisements are ever dropped: the ring keeps room beyond the
+// host's capacity for changes in connection state, and should even that run out,
+// post() hands them back for the callbacks.
+//
+// Once a host asks for the wait handle, it is set when the first event lands in an
+// empty queue and reset by the next poll, so each burst costs at most one syscall on
+// each side.
+class PollQueue
+{
+public:
+    // 0 turns polling off
+    void set_capacity(uint32_t capacity);
+
+    [[nodiscard]] auto enabled() const -> bool
+    {
+        return ring_.load(std::memory_order_relaxed) != nullptr;
+    }
+
+    // Safe from any thread. Returns false if polling is off, or for a change in connection
+    // state that found no room, so the caller falls back to callbacks.
+    auto post(const GDPollEvent& event) -> bool;
+
+    // Only one thread may poll at a time
+    auto poll(GDPollEvent* events, uint32_t max_events) -> uint32_t;
+
+    // Created on first use and kept for the life of the process
+    auto wait_handle() -> intptr_t;
+
+    [[nodiscard]] auto dropped() const -> uint64_t { return dropped_.load(); }
+
+private:
+    // Kept beyond the capacity for events that must not be dropped
+    static constexpr uint32_t k_state_headroom = 256;
+
+    std::atomic<MpscRing<GDPollEvent>*> ring_ = nullptr;
+    // What packets and advertisements may fill
+    std::atomic<uint32_t> capacity_ = 0;
+    // Replaced rings are kept, since a producer may still be posting to one
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<MpscRing<GDPollEvent>>> rings_;
+    StatCounter dropped_;
+
+    std::atomic<WaitableEvent*> event_ = nullptr;
+    std::unique_ptr<WaitableEvent> owned_event_;
+    // True from the post that set the event until the poll that resets it
+    std::atomic<bool> signaled_ = false;
+
+    void signal();
+};
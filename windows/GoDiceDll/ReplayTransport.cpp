@@ -0,0 +1,350 @@
+#include "ReplayTransport.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <system_error>
+
+#include "Log.h"
+
+using godice::log_info;
+using godice::log_warning;
+
+namespace
+{
+    struct CaptureFile
+    {
+        uint32_t index;
+        std::vector<uint8_t> bytes;
+    };
+
+    template <typename T>
+    auto read_value(const std::vector<uint8_t>& bytes, size_t offset) -> T
+    {
+        T value;
+        std::memcpy(&value, bytes.data() + offset, sizeof(T));
+        return value;
+    }
+
+    auto read_file(const std::string& path, std::vector<uint8_t>& bytes) -> bool
+    {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) return false;
+
+        const std::streamsize size = in.tellg();
+        if (size < 0) return false;
+        bytes.resize(static_cast<size_t>(size));
+        in.seekg(0);
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(bytes.data()), size));
+    }
+
+    auto is_capture(const std::vector<uint8_t>& bytes) -> bool
+    {
+        return bytes.size() >= TrafficCapture::k_header_size &&
+               std::memcmp(bytes.data(), TrafficCapture::k_magic, sizeof(TrafficCapture::k_magic)) == 0 &&
+               read_value<uint32_t>(bytes, 8) == TrafficCapture::k_version &&
+               read_value<uint32_t>(bytes, 12) >= TrafficCapture::k_header_size &&
+               read_value<uint32_t>(bytes, 12) <= bytes.size();
+    }
+
+    auto origin_of(const std::vector<uint8_t>& bytes) -> uint64_t
+    {
+        return read_value<uint64_t>(bytes, 16);
+    }
+}
+
+auto ReplayTransport::default_config() -> GDReplayConfig
+{
+    GDReplayConfig config{};
+    config.speed = 1.0f;
+    config.repeat_count = 1;
+    return config;
+}
+
+auto ReplayTransport::open(const std::string& path, const GDReplayConfig& config) -> std::unique_ptr<ReplayTransport>
+{
+    std::vector<CaptureFile> files(1);
+    if (!read_file(path, files[0].bytes) || !is_capture(files[0].bytes))
+    {
+        log_warning("[replay] {} is not a capture\n", path);
+        return nullptr;
+    }
+    files[0].index = read_value<uint32_t>(files[0].bytes, 24);
+
+    // Older files of the same capture were rotated to path.1, path.2, ...
+    const uint64_t origin = origin_of(files[0].bytes);
+    for (uint32_t rotation = 1;; rotation++)
+    {
+        const std::string older = path + "." + std::to_string(rotation);
+        std::error_code ec;
+        if (!std::filesystem::exists(std::filesystem::path(older), ec)) break;
+
+        CaptureFile file;
+        if (!read_file(older, file.bytes) || !is_capture(file.bytes) || origin_of(file.bytes) != origin) break;
+        file.index = read_value<uint32_t>(file.bytes, 24);
+        files.push_back(std::move(file));
+    }
+    std::sort(files.begin(), files.end(), [](const CaptureFile& a, const CaptureFile& b) { return a.index < b.index; });
+
+    auto replay = std::unique_ptr<ReplayTransport>(new ReplayTransport(config));
+    for (const auto& file : files)
+    {
+        replay->load_file(file.bytes);
+    }
+    // Producers stamp events before they reach the ring, so neighbours can be out of order
+    std::stable_sort(replay->events_.begin(), replay->events_.end(),
+                     [](const Event& a, const Event& b) { return a.timestamp_ns < b.timestamp_ns; });
+
+    log_info("[replay] {} events for {} dice from {} files\n", replay->events_.size(), replay->connect_outcomes_.size(), files.size());
+    replay->player_thread_ = std::thread(&ReplayTransport::player, replay.get());
+    return replay;
+}
+
+ReplayTransport::ReplayTransport(const GDReplayConfig& config) : config_(config)
+{
+}
+
+ReplayTransport::~ReplayTransport()
+{
+    {
+        std::scoped_lock lk(mutex_);
+        keep_running_ = false;
+        condition_.notify_one();
+    }
+    if (player_thread_.joinable())
+    {
+        player_thread_.join();
+    }
+}
+
+void ReplayTransport::load_file(const std::vector<uint8_t>& bytes)
+{
+    // Stops at the end marker, or at a record cut short by a crash
+    size_t position = read_value<uint32_t>(bytes, 12);
+    while (position + TrafficCapture::k_record_header_size <= bytes.size())
+    {
+        const auto kind = static_cast<CaptureKind>(bytes[position + 16]);
+        const auto size = read_value<uint16_t>(bytes, position + 20);
+        const size_t payload = position + TrafficCapture::k_record_header_size;
+        if (kind == CaptureKind::End || payload + size > bytes.size()) break;
+
+        Event event;
+        event.timestamp_ns = read_value<uint64_t>(bytes, position);
+        event.address = read_value<uint64_t>(bytes, position + 8);
+        event.kind = kind;
+        event.rssi = read_value<int16_t>(bytes, position + 18);
+        event.size = size;
+        event.offset = static_cast<uint32_t>(payloads_.size());
+        position = payload + ((size + 7u) & ~7u);
+
+        if (event.address == 0) continue;
+        auto& outcomes = connect_outcomes_[event.address];
+
+        switch (kind)
+        {
+        case CaptureKind::Advertisement:
+        case CaptureKind::Notification:
+        case CaptureKind::LinkLost:
+            payloads_.insert(payloads_.end(), bytes.begin() + static_cast<ptrdiff_t>(payload),
+                             bytes.begin() + static_cast<ptrdiff_t>(payload + size));
+            events_.push_back(event);
+            break;
+
+        case CaptureKind::Connected:
+        case CaptureKind::ConnectFailed:
+            outcomes.push_back(kind == CaptureKind::Connected);
+            break;
+
+        default:
+            // Writes and disconnects were the client's doing, and will be again
+            break;
+        }
+    }
+}
+
+void ReplayTransport::set_listener(TransportListener* listener)
+{
+    listener_ = listener;
+}
+
+void ReplayTransport::start_discovery()
+{
+    std::scoped_lock lk(mutex_);
+    discovering_ = true;
+    if (!playing_)
+    {
+        playing_ = true;
+        condition_.notify_one();
+    }
+}
+
+void ReplayTransport::stop_discovery()
+{
+    if (!discovering_.exchange(false)) return;
+
+    if (TransportListener* listener = listener_.load())
+    {
+        listener->on_discovery_stopped();
+    }
+}
+
+void ReplayTransport::connect(uint64_t address, TransportCompletion completion)
+{
+    bool success = false;
+    {
+        std::scoped_lock lk(mutex_);
+        if (const auto it = connect_outcomes_.find(address); it != connect_outcomes_.end())
+        {
+            // Dice that were already connected when the capture started have no outcome to repeat
+            size_t& attempt = connect_attempts_[address];
+            success = attempt < it->second.size() ? it->second[attempt] : true;
+            attempt++;
+        }
+        if (success)
+        {
+            connected_.insert(address);
+        }
+    }
+    completion(success);
+}
+
+void ReplayTransport::subscribe(uint64_t address, TransportCompletion completion)
+{
+    bool success;
+    {
+        std::scoped_lock lk(mutex_);
+        success = connected_.contains(address);
+    }
+    completion(success);
+}
+
+void ReplayTransport::write(uint64_t address, const uint8_t*, uint32_t, WriteMode, TransportCompletion completion)
+{
+    bool success;
+    {
+        std::scoped_lock lk(mutex_);
+        success = connected_.contains(address);
+    }
+    completion(success);
+}
+
+void ReplayTransport::disconnect(uint64_t address, TransportCompletion completion)
+{
+    {
+        std::scoped_lock lk(mutex_);
+        connected_.erase(address);
+    }
+    completion(true);
+}
+
+void ReplayTransport::reset()
+{
+    std::scoped_lock lk(mutex_);
+    discovering_ = false;
+    connected_.clear();
+}
+
+void ReplayTransport::player()
+{
+    for (;;)
+    {
+        {
+            std::unique_lock lk(mutex_);
+            condition_.wait(lk, [this] { return !keep_running_ || playing_; });
+            if (!keep_running_) return;
+            connect_attempts_.clear();
+        }
+
+        if (!play()) return;
+
+        // The capture is over, so nothing more will be found
+        bool was_discovering;
+        {
+            std::scoped_lock lk(mutex_);
+            playing_ = false;
+            was_discovering = discovering_.exchange(false);
+        }
+        log_info("[replay] finished\n");
+
+        TransportListener* listener = listener_.load();
+        if (was_discovering && listener != nullptr)
+        {
+            listener->on_discovery_stopped();
+        }
+    }
+}
+
+auto ReplayTransport::play() -> bool
+{
+    using Clock = std::chrono::steady_clock;
+
+    if (events_.empty()) return true;
+
+    const uint64_t first = events_.front().timestamp_ns;
+    const uint64_t span = events_.back().timestamp_ns - first;
+    const uint32_t passes = std::max(config_.repeat_count, 1u);
+    const auto start = Clock::now();
+
+    for (uint32_t pass = 0; pass < passes; pass++)
+    {
+        for (const Event& event : events_)
+        {
+            if (config_.speed > 0.0f)
+            {
+                const double offset_ns = static_cast<double>(pass * span + event.timestamp_ns - first) / config_.speed;
+                const auto due = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::nano>(offset_ns));
+                if (Clock::now() < due)
+                {
+                    std::unique_lock lk(mutex_);
+                    condition_.wait_until(lk, due, [this] { return !keep_running_; });
+                }
+            }
+            if (!keep_running_.load(std::memory_order_relaxed)) return false;
+
+            if (TransportListener* listener = listener_.load(std::memory_order_relaxed))
+            {
+                emit(event, listener);
+            }
+        }
+    }
+    return true;
+}
+
+void ReplayTransport::emit(const Event& event, TransportListener* listener)
+{
+    const uint8_t* payload = payloads_.data() + event.offset;
+
+    switch (event.kind)
+    {
+    case CaptureKind::Advertisement:
+        if (discovering_.load(std::memory_order_relaxed))
+        {
+            listener->on_advertisement(event.address, std::string_view(reinterpret_cast<const char*>(payload), event.size), event.rssi);
+        }
+        break;
+
+    case CaptureKind::Notification:
+        listener->on_notification(event.address, payload, event.size);
+        break;
+
+    case CaptureKind::LinkLost:
+    {
+        bool was_connected;
+        {
+            std::scoped_lock lk(mutex_);
+            was_connected = connected_.erase(event.address) > 0;
+        }
+        if (was_connected)
+        {
+            listener->on_link_lost(event.address);
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
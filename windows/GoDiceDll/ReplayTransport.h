@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "GoDiceDll.h"
+#include "TrafficCapture.h"
+#include "Transport.h"
+
+// Plays a TrafficCapture back as if the dice in it were in the room. A player thread
+// re-emits the captured advertisements, notifications and link losses in their
+// original order, spaced by their original timestamps divided by the speed, or back
+// to back with a speed of 0.
+//
+// Notifications are delivered whether or not the client has connected the die, so
+// what the client sees does not depend on how quickly it connects. Connects succeed
+// or fail as they did in the capture, in order per die; everything else succeeds.
+class ReplayTransport final : public Transport
+{
+public:
+    static auto default_config() -> GDReplayConfig;
+
+    // Reads the capture at `path` and its older rotations. Returns null if `path`
+    // is not a capture.
+    static auto open(const std::string& path, const GDReplayConfig& config) -> std::unique_ptr<ReplayTransport>;
+
+    ~ReplayTransport() override;
+
+    void set_listener(TransportListener* listener) override;
+
+    // Starts playback, unless it is already running
+    void start_discovery() override;
+    // Stops advertisements; the rest of the capture keeps playing
+    void stop_discovery() override;
+
+    void connect(uint64_t address, TransportCompletion completion) override;
+    void subscribe(uint64_t address, TransportCompletion completion) override;
+    void write(uint64_t address, const uint8_t* data, uint32_t size, WriteMode mode, TransportCompletion completion) override;
+    void disconnect(uint64_t address, TransportCompletion completion) override;
+
+    void reset() override;
+
+private:
+    struct Event
+    {
+        uint64_t timestamp_ns;
+        uint64_t address;
+        // Into payloads_
+        uint32_t offset;
+        uint16_t size;
+        int16_t rssi;
+        CaptureKind kind;
+    };
+
+    explicit ReplayTransport(const GDReplayConfig& config);
+
+    void load_file(const std::vector<uint8_t>& bytes);
+    void player();
+    // Returns false if the transport is shutting down
+    auto play() -> bool;
+    void emit(const Event& event, TransportListener* listener);
+
+    const GDReplayConfig config_;
+
+    // Immutable once open() returns
+    std::vector<Event> events_;
+    std::vector<uint8_t> payloads_;
+    std::unordered_map<uint64_t, std::vector<bool>> connect_outcomes_;
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool playing_ = false;
+    std::unordered_set<uint64_t> connected_;
+    std::unordered_map<uint64_t, size_t> connect_attempts_;
+
+    std::atomic<bool> keep_running_ = true;
+    std::atomic<bool> discovering_ = false;
+    std::atomic<TransportListener*> listener_ = nullptr;
+
+    std::thread player_thread_;
+};
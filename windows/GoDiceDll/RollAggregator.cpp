@@ -0,0 +1,241 @@
+#include "RollAggregator.h"
+
+#include <algorithm>
+
+#include "GoDiceProtocol.h"
+
+auto RollAggregator::default_config() -> GDGroupConfig
+{
+    GDGroupConfig config{};
+    config.settle_timeout_ms = 5000;
+    return config;
+}
+
+RollAggregator::RollAggregator(ThrowHandler handler) : handler_(std::move(handler))
+{
+}
+
+RollAggregator::~RollAggregator()
+{
+    {
+        std::scoped_lock lk(mutex_);
+        keep_running_ = false;
+    }
+    condition_.notify_all();
+    if (timer_thread_.joinable())
+    {
+        timer_thread_.join();
+    }
+}
+
+void RollAggregator::set_group(uint32_t id, const GDDeviceHandle* dice, uint32_t count, const GDGroupConfig& config)
+{
+    std::vector<Throw> finished;
+    {
+        std::scoped_lock lk(mutex_);
+        remove_group_locked(id);
+
+        if (count > 0)
+        {
+            Group& group = groups_[id];
+            group.config = config;
+            group.dice.reserve(count);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const uint64_t address = dice[i];
+                if (address == 0) continue;
+
+                if (const Member* member = members_.find(address); member != nullptr)
+                {
+                    if (member->group == id) continue;
+                    remove_die_locked(address, finished);
+                }
+                members_.try_emplace(address, Member{ id, static_cast<uint32_t>(group.dice.size()) });
+                group.dice.emplace_back().address = address;
+            }
+
+            if (group.dice.empty())
+            {
+                groups_.erase(id);
+            }
+            else if (config.settle_timeout_ms > 0 && !timer_thread_.joinable())
+            {
+                timer_thread_ = std::thread(&RollAggregator::run_timer, this);
+            }
+        }
+        active_.store(!groups_.empty(), std::memory_order_relaxed);
+    }
+
+    for (auto& done : finished)
+    {
+        handler_(done.group, std::move(done.results));
+    }
+}
+
+void RollAggregator::observe(uint64_t address, const uint8_t* data, uint32_t size, Clock::time_point now)
+{
+    if (!active_.load(std::memory_order_relaxed)) return;
+
+    GDEvent event;
+    if (!godice::protocol::decode(data, size, event)) return;
+    if (event.type == GD_EVENT_BATTERY_LEVEL || event.type == GD_EVENT_COLOR) return;
+
+    Throw finished;
+    {
+        std::scoped_lock lk(mutex_);
+        const Member* member = members_.find(address);
+        if (member == nullptr) return;
+
+        const uint32_t id = member->group;
+        Group& group = groups_.at(id);
+        Die& die = group.dice[member->index];
+
+        if (event.type == GD_EVENT_ROLL_STARTED)
+        {
+            if (!group.throwing)
+            {
+                group.throwing = true;
+                group.settled = 0;
+                group.started = now;
+                for (Die& other : group.dice)
+                {
+                    other.state = DieState::Idle;
+                }
+                if (group.config.settle_timeout_ms > 0)
+                {
+                    group.deadline = now + std::chrono::milliseconds(group.config.settle_timeout_ms);
+                    condition_.notify_one();
+                }
+            }
+            if (die.state == DieState::Settled)
+            {
+                group.settled--;
+            }
+            die.state = DieState::Rolling;
+            return;
+        }
+
+        // At rest outside a throw, such as a die being picked up and put down
+        if (!group.throwing) return;
+
+        if (die.state != DieState::Settled)
+        {
+            group.settled++;
+        }
+        die.state = DieState::Settled;
+        die.event = event;
+        die.settled = now;
+        if (group.settled < group.dice.size()) return;
+
+        completed_.fetch_add(1, std::memory_order_relaxed);
+        finished = finish_locked(id, group);
+    }
+
+    handler_(finished.group, std::move(finished.results));
+}
+
+void RollAggregator::remove_group_locked(uint32_t id)
+{
+    const auto it = groups_.find(id);
+    if (it == groups_.end()) return;
+
+    for (const Die& die : it->second.dice)
+    {
+        members_.erase(die.address);
+    }
+    groups_.erase(it);
+}
+
+void RollAggregator::remove_die_locked(uint64_t address, std::vector<Throw>& finished)
+{
+    const Member member = *members_.find(address);
+    members_.erase(address);
+
+    const auto it = groups_.find(member.group);
+    Group& group = it->second;
+    if (group.dice[member.index].state == DieState::Settled)
+    {
+        group.settled--;
+    }
+    group.dice.erase(group.dice.begin() + member.index);
+    for (uint32_t i = member.index; i < group.dice.size(); i++)
+    {
+        members_.find(group.dice[i].address)->index = i;
+    }
+
+    if (group.dice.empty())
+    {
+        groups_.erase(it);
+    }
+    else if (group.throwing && group.settled == group.dice.size())
+    {
+        completed_.fetch_add(1, std::memory_order_relaxed);
+        finished.push_back(finish_locked(member.group, group));
+    }
+}
+
+auto RollAggregator::finish_locked(uint32_t id, Group& group) -> Throw
+{
+    Throw done{ id, {} };
+    done.results.reserve(group.dice.size());
+    for (const Die& die : group.dice)
+    {
+        GDDieResult result{};
+        result.device = die.address;
+        if (die.state == DieState::Settled)
+        {
+            result.event = die.event;
+            result.settle_ms = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(die.settled - group.started).count());
+        }
+        done.results.push_back(result);
+    }
+
+    group.throwing = false;
+    group.deadline = Clock::time_point::max();
+    return done;
+}
+
+void RollAggregator::run_timer()
+{
+    std::unique_lock lk(mutex_);
+    while (keep_running_)
+    {
+        const auto now = Clock::now();
+        auto next = Clock::time_point::max();
+        std::vector<Throw> expired;
+        for (auto& [id, group] : groups_)
+        {
+            if (!group.throwing) continue;
+
+            if (group.deadline <= now)
+            {
+                timed_out_.fetch_add(1, std::memory_order_relaxed);
+                expired.push_back(finish_locked(id, group));
+            }
+            else
+            {
+                next = std::min(next, group.deadline);
+            }
+        }
+
+        if (!expired.empty())
+        {
+            lk.unlock();
+            for (auto& done : expired)
+            {
+                handler_(done.group, std::move(done.results));
+            }
+            lk.lock();
+            continue;
+        }
+
+        if (next == Clock::time_point::max())
+        {
+            condition_.wait(lk);
+        }
+        else
+        {
+            condition_.wait_until(lk, next);
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "FlatAddressMap.h"
+#include "GoDiceDll.h"
+
+// Follows every die in a group through rolling and coming to rest, and hands over a
+// whole throw as soon as its last die settles. Packets from dice in no group cost one
+// atomic load. Settle timeouts are kept by a thread of its own, started with the first
+// group that has one.
+class RollAggregator
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    // Called without the lock held, from the thread that fed in the last die's packet or
+    // from the timeout thread. Faces are left for it to fill in.
+    using ThrowHandler = std::function<void(uint32_t group, std::vector<GDDieResult> results)>;
+
+    static auto default_config() -> GDGroupConfig;
+
+    explicit RollAggregator(ThrowHandler handler);
+    // Stops the timeout thread; throws in progress are not reported
+    ~RollAggregator();
+
+    RollAggregator(const RollAggregator&) = delete;
+    RollAggregator& operator=(const RollAggregator&) = delete;
+
+    // Replaces the group, dropping a throw in progress. Address 0 and repeats are skipped.
+    void set_group(uint32_t group, const GDDeviceHandle* dice, uint32_t count, const GDGroupConfig& config);
+
+    // Safe to call from any thread
+    void observe(uint64_t address, const uint8_t* data, uint32_t size, Clock::time_point now = Clock::now());
+
+    [[nodiscard]] auto completed() const -> uint64_t { return completed_.load(std::memory_order_relaxed); }
+    [[nodiscard]] auto timed_out() const -> uint64_t { return timed_out_.load(std::memory_order_relaxed); }
+
+private:
+    enum class DieState : uint8_t
+    {
+        Idle,
+        Rolling,
+        Settled,
+    };
+
+    struct Die
+    {
+        uint64_t address = 0;
+        DieState state = DieState::Idle;
+        GDEvent event{};
+        Clock::time_point settled;
+    };
+
+    struct Group
+    {
+        GDGroupConfig config{};
+        std::vector<Die> dice;
+        bool throwing = false;
+        uint32_t settled = 0;
+        Clock::time_point started;
+        // Only set with a settle timeout
+        Clock::time_point deadline = Clock::time_point::max();
+    };
+
+    struct Member
+    {
+        uint32_t group = 0;
+        uint32_t index = 0;
+    };
+
+    struct Throw
+    {
+        uint32_t group = 0;
+        std::vector<GDDieResult> results;
+    };
+
+    void remove_group_locked(uint32_t group);
+    // Adds the die's group to finished if taking the die out completed its throw
+    void remove_die_locked(uint64_t address, std::vector<Throw>& finished);
+    auto finish_locked(uint32_t id, Group& group) -> Throw;
+    void run_timer();
+
+    const ThrowHandler handler_;
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::unordered_map<uint32_t, Group> groups_;
+    FlatAddressMap<Member> members_;
+    // Checked before taking the lock, so dice in no group stay off it
+    std::atomic<bool> active_ = false;
+
+    std::thread timer_thread_;
+    bool keep_running_ = true;
+
+    std::atomic<uint64_t> completed_ = 0;
+    std::atomic<uint64_t> timed_out_ = 0;
+};
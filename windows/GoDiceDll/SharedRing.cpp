@@ -0,0 +1,559 @@
+#include "SharedRing.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <thread>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <signal.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#include "Log.h"
+
+using godice::log_info;
+using godice::log_warning;
+using namespace godice::shared;
+
+namespace
+{
+    constexpr uint32_t k_min_capacity = 64;
+
+    constexpr auto devices_offset() -> size_t
+    {
+        return sizeof(Header);
+    }
+
+    constexpr auto slots_offset() -> size_t
+    {
+        return devices_offset() + k_device_slots * sizeof(SharedDevice);
+    }
+
+    constexpr auto file_size(uint64_t capacity) -> size_t
+    {
+        return slots_offset() + capacity * sizeof(SharedSlot);
+    }
+
+    static_assert(slots_offset() % alignof(SharedSlot) == 0);
+
+    auto complete_stamp(uint64_t sequence) -> uint64_t
+    {
+        return 2 * sequence + 2;
+    }
+
+#if defined(_WIN32)
+    auto event_name(const std::string& name, uint32_t index) -> std::wstring
+    {
+        const std::string full = "Local\\godice-" + name + "-" + std::to_string(index);
+        return std::wstring(full.begin(), full.end());
+    }
+#endif
+
+    // Wakes whoever is parked on `reader`. `event` is that reader's wake event on Windows.
+    void signal(Reader& reader, [[maybe_unused]] void* event)
+    {
+        reader.wake.fetch_add(1, std::memory_order_release);
+#if defined(_WIN32)
+        if (event != nullptr)
+        {
+            SetEvent(event);
+        }
+#elif defined(__linux__)
+        // Not FUTEX_PRIVATE_FLAG: the word is shared with other processes
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&reader.wake), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+    }
+
+    // Fibonacci hashing, as in FlatAddressMap
+    auto device_slot(uint64_t address) -> uint32_t
+    {
+        return static_cast<uint32_t>((address * 0x9E3779B97F4A7C15ull) >> 32) & (k_device_slots - 1);
+    }
+
+    auto find_device(SharedDevice* devices, uint64_t address) -> SharedDevice*
+    {
+        uint32_t i = device_slot(address);
+        for (uint32_t probes = 0; probes < k_device_slots; probes++, i = (i + 1) & (k_device_slots - 1))
+        {
+            const uint64_t current = devices[i].address.load(std::memory_order_acquire);
+            if (current == address) return &devices[i];
+            if (current == 0) return nullptr;
+        }
+        return nullptr;
+    }
+
+    auto current_process() -> uint32_t
+    {
+#if defined(_WIN32)
+        return GetCurrentProcessId();
+#else
+        return static_cast<uint32_t>(getpid());
+#endif
+    }
+
+    // Errs towards alive, so a reader that is merely slow never loses its slot
+    auto process_alive(uint32_t pid) -> bool
+    {
+#if defined(_WIN32)
+        HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+        if (process == nullptr) return GetLastError() != ERROR_INVALID_PARAMETER;
+
+        DWORD code = 0;
+        const bool alive = !GetExitCodeProcess(process, &code) || code == STILL_ACTIVE;
+        CloseHandle(process);
+        return alive;
+#else
+        return kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH;
+#endif
+    }
+}
+
+auto godice::shared::path_for(const std::string& name) -> std::string
+{
+#if defined(__linux__)
+    return "/dev/shm/godice-" + name;
+#else
+    std::error_code ec;
+    const std::filesystem::path directory = std::filesystem::temp_directory_path(ec);
+    return (directory / ("godice-" + name + ".shm")).string();
+#endif
+}
+
+SharedRingWriter::~SharedRingWriter()
+{
+    stop();
+#if defined(_WIN32)
+    for (const auto& mapping : mappings_)
+    {
+        for (auto& event : mapping->events)
+        {
+            if (void* handle = event.load())
+            {
+                CloseHandle(handle);
+            }
+        }
+    }
+#endif
+}
+
+auto SharedRingWriter::start(const std::string& name, uint32_t capacity) -> bool
+{
+    stop();
+
+    std::scoped_lock lk(control_mutex_);
+    if (name.empty()) return false;
+
+    const uint64_t slots = capacity != 0 ? std::bit_ceil(std::max(capacity, k_min_capacity)) : k_default_capacity;
+    const size_t size = file_size(slots);
+    auto mapping = std::make_unique<Mapping>();
+    mapping->name = name;
+    if (!mapping->file.open(path_for(name), size))
+    {
+        log_warning("[shared] could not map {}\n", path_for(name));
+        return false;
+    }
+
+    uint8_t* data = mapping->file.data();
+    mapping->header = reinterpret_cast<Header*>(data);
+    mapping->devices = reinterpret_cast<SharedDevice*>(data + devices_offset());
+    mapping->slots = reinterpret_cast<SharedSlot*>(data + slots_offset());
+    mapping->mask = slots - 1;
+
+    Header& header = *mapping->header;
+    std::vector<uint64_t> held;
+    if (std::memcmp(header.magic, k_magic, sizeof(k_magic)) == 0 && header.version == k_version && header.capacity == slots)
+    {
+        // Left by an earlier daemon. Events it claimed but never finished become empty
+        // ones, so no reader waits on them, and the dice it held are no longer connected.
+        const uint64_t next = header.next.load();
+        for (uint64_t sequence = next > slots ? next - slots : 0; sequence < next; sequence++)
+        {
+            SharedSlot& slot = mapping->slots[sequence & mapping->mask];
+            if (slot.stamp.load() != complete_stamp(sequence))
+            {
+                slot.info.store(static_cast<uint64_t>(CaptureKind::End));
+                slot.stamp.store(complete_stamp(sequence));
+            }
+        }
+        for (uint32_t i = 0; i < k_device_slots; i++)
+        {
+            SharedDevice& device = mapping->devices[i];
+            if (device.state.fetch_and(~k_connected) & k_connected)
+            {
+                held.push_back(device.address.load());
+            }
+        }
+    }
+    else
+    {
+        std::memset(data, 0, size);
+        header.version = k_version;
+        header.capacity = static_cast<uint32_t>(slots);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(header.magic, k_magic, sizeof(k_magic));
+    }
+
+    Mapping* published = mapping.get();
+    mappings_.push_back(std::move(mapping));
+    mapping_.store(published, std::memory_order_release);
+    log_info("[shared] publishing {} slots at {}\n", slots, path_for(name));
+
+    for (const uint64_t address : held)
+    {
+        push(*published, CaptureKind::LinkLost, address, nullptr, 0, 0);
+    }
+    return true;
+}
+
+void SharedRingWriter::stop()
+{
+    std::scoped_lock lk(control_mutex_);
+    mapping_.store(nullptr, std::memory_order_release);
+}
+
+void SharedRingWriter::push(Mapping& mapping, CaptureKind kind, uint64_t address, const void* payload, uint32_t size, int16_t rssi)
+{
+    // Readers only care about what the dice did; writes are the daemon's own
+    if (kind == CaptureKind::Write) return;
+
+    update_device(mapping, kind, address, payload, size, rssi);
+
+    const uint64_t sequence = mapping.header->next.fetch_add(1, std::memory_order_relaxed);
+    SharedSlot& slot = mapping.slots[sequence & mapping.mask];
+
+    // Waits out a publisher a lap behind that still holds this slot. One that fell a
+    // whole lap behind finds a newer event already there and drops its own.
+    uint64_t stamp = slot.stamp.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        if (stamp > 2 * sequence) return;
+        if (stamp % 2 == 0 && slot.stamp.compare_exchange_weak(stamp, 2 * sequence + 1, std::memory_order_relaxed)) break;
+        if (stamp % 2 == 1)
+        {
+            std::this_thread::yield();
+            stamp = slot.stamp.load(std::memory_order_relaxed);
+        }
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const uint32_t stored = std::min(size, k_max_payload);
+    const uint8_t flags = size > k_max_payload ? k_capture_truncated : 0;
+    slot.address.store(address, std::memory_order_relaxed);
+    slot.info.store(static_cast<uint64_t>(kind) | static_cast<uint64_t>(flags) << 8 |
+                    static_cast<uint64_t>(static_cast<uint16_t>(rssi)) << 16 | static_cast<uint64_t>(stored) << 32,
+                    std::memory_order_relaxed);
+    uint64_t words[k_max_payload / 8] = {};
+    if (stored > 0)
+    {
+        std::memcpy(words, payload, stored);
+    }
+    for (uint32_t i = 0; i < slot.payload.size(); i++)
+    {
+        slot.payload[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    slot.stamp.store(complete_stamp(sequence), std::memory_order_release);
+    published_.add();
+    wake_readers(mapping);
+}
+
+void SharedRingWriter::update_device(Mapping& mapping, CaptureKind kind, uint64_t address, const void* payload, uint32_t size, int16_t rssi)
+{
+    if (address == 0) return;
+
+    if (kind == CaptureKind::Advertisement)
+    {
+        if (!list_device(mapping, address, payload, size, rssi))
+        {
+            unlisted_.add();
+            if (!mapping.warned_full.exchange(true, std::memory_order_relaxed))
+            {
+                log_warning("[shared] {} already lists {} dice; readers that attach later will not find any more\n",
+                            mapping.name, k_max_devices);
+            }
+        }
+        return;
+    }
+
+    SharedDevice* device = find_device(mapping.devices, address);
+    if (device == nullptr) return;
+
+    switch (kind)
+    {
+    case CaptureKind::Connected:
+        device->state.fetch_or(k_connected, std::memory_order_release);
+        break;
+    case CaptureKind::ConnectFailed:
+    case CaptureKind::Disconnected:
+    case CaptureKind::LinkLost:
+        device->state.fetch_and(~k_connected, std::memory_order_release);
+        break;
+    default:
+        break;
+    }
+}
+
+auto SharedRingWriter::list_device(Mapping& mapping, uint64_t address, const void* name, uint32_t size, int16_t rssi) -> bool
+{
+    std::atomic<uint32_t>& count = mapping.header->devices;
+    uint32_t i = device_slot(address);
+    for (uint32_t probes = 0; probes < k_device_slots; probes++, i = (i + 1) & (k_device_slots - 1))
+    {
+        SharedDevice& device = mapping.devices[i];
+        uint64_t current = device.address.load(std::memory_order_acquire);
+        if (current == address) return true;
+        if (current != 0) continue;
+
+        // Reserve a place in the count first, so racing publishers never list more than k_max_devices
+        if (count.fetch_add(1, std::memory_order_relaxed) >= k_max_devices)
+        {
+            count.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (device.address.compare_exchange_strong(current, address))
+        {
+            const uint32_t length = std::min(size, k_max_name - 1);
+            std::memcpy(device.name, name, length);
+            device.name[length] = '\0';
+            device.rssi = rssi;
+            device.state.fetch_or(k_named, std::memory_order_release);
+            return true;
+        }
+        count.fetch_sub(1, std::memory_order_relaxed);
+        if (current == address) return true;
+    }
+    return false;
+}
+
+// Same handshake as WorkQueue: only a reader seen parked costs the publisher a syscall
+void SharedRingWriter::wake_readers(Mapping& mapping)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (uint32_t i = 0; i < k_max_readers; i++)
+    {
+        Reader& reader = mapping.header->readers[i];
+        if (!reader.parked.load(std::memory_order_relaxed) || !reader.parked.exchange(0, std::memory_order_relaxed)) continue;
+
+        void* event = nullptr;
+#if defined(_WIN32)
+        event = mapping.events[i].load(std::memory_order_acquire);
+        if (event == nullptr)
+        {
+            // The reader creates its event before it first parks
+            void* opened = OpenEventW(EVENT_MODIFY_STATE, FALSE, event_name(mapping.name, i).c_str());
+            if (opened != nullptr && !mapping.events[i].compare_exchange_strong(event, opened))
+            {
+                CloseHandle(opened);
+            }
+            event = mapping.events[i].load(std::memory_order_acquire);
+        }
+#endif
+        signal(reader, event);
+    }
+}
+
+SharedRingReader::~SharedRingReader()
+{
+    close();
+}
+
+auto SharedRingReader::open(const std::string& name) -> bool
+{
+    close();
+
+    const std::string path = path_for(name);
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(std::filesystem::path(path), ec);
+    if (ec || size < sizeof(Header) || !file_.open(path, static_cast<size_t>(size)))
+    {
+        log_warning("[shared] nothing is published as {}\n", name);
+        return false;
+    }
+
+    uint8_t* data = file_.data();
+    auto* header = reinterpret_cast<Header*>(data);
+    if (std::memcmp(header->magic, k_magic, sizeof(k_magic)) != 0 || header->version != k_version ||
+        !std::has_single_bit(header->capacity) || file_size(header->capacity) > size)
+    {
+        log_warning("[shared] {} is not a godice daemon's\n", path);
+        file_.close();
+        return false;
+    }
+
+    const uint32_t self = current_process();
+    uint32_t index = 0;
+    for (; index < k_max_readers; index++)
+    {
+        uint32_t free = 0;
+        if (header->readers[index].owner.compare_exchange_strong(free, self)) break;
+    }
+    // Every slot is taken; take back one whose reader exited without closing
+    for (uint32_t i = 0; index == k_max_readers && i < k_max_readers; i++)
+    {
+        uint32_t owner = header->readers[i].owner.load();
+        if (owner != 0 && owner != self && !process_alive(owner) && header->readers[i].owner.compare_exchange_strong(owner, self))
+        {
+            log_info("[shared] reclaimed reader slot {} from exited process {}\n", i, owner);
+            index = i;
+        }
+    }
+    if (index == k_max_readers)
+    {
+        log_warning("[shared] {} already has {} readers\n", name, k_max_readers);
+        file_.close();
+        return false;
+    }
+
+#if defined(_WIN32)
+    event_ = CreateEventW(nullptr, FALSE, FALSE, event_name(name, index).c_str());
+#endif
+
+    header_ = header;
+    devices_ = reinterpret_cast<SharedDevice*>(data + devices_offset());
+    slots_ = reinterpret_cast<SharedSlot*>(data + slots_offset());
+    mask_ = header->capacity - 1;
+    index_ = index;
+    header_->readers[index_].parked.store(0);
+    cursor_ = header_->next.load(std::memory_order_acquire);
+    return true;
+}
+
+void SharedRingReader::close()
+{
+    if (header_ == nullptr) return;
+
+    header_->readers[index_].owner.store(0, std::memory_order_release);
+    header_ = nullptr;
+    file_.close();
+#if defined(_WIN32)
+    if (event_ != nullptr)
+    {
+        CloseHandle(event_);
+        event_ = nullptr;
+    }
+#endif
+}
+
+auto SharedRingReader::read(Event& event) -> bool
+{
+    if (header_ == nullptr) return false;
+
+    for (;;)
+    {
+        SharedSlot& slot = slots_[cursor_ & mask_];
+        const uint64_t expected = complete_stamp(cursor_);
+        const uint64_t stamp = slot.stamp.load(std::memory_order_acquire);
+        if (stamp < expected) return false;
+
+        if (stamp == expected)
+        {
+            uint64_t words[k_max_payload / 8];
+            event.address = slot.address.load(std::memory_order_relaxed);
+            const uint64_t info = slot.info.load(std::memory_order_relaxed);
+            for (uint32_t i = 0; i < slot.payload.size(); i++)
+            {
+                words[i] = slot.payload[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (slot.stamp.load(std::memory_order_relaxed) == expected)
+            {
+                event.kind = static_cast<CaptureKind>(info & 0xFF);
+                event.flags = static_cast<uint8_t>(info >> 8);
+                event.rssi = static_cast<int16_t>(static_cast<uint16_t>(info >> 16));
+                event.size = static_cast<uint16_t>(std::min<uint64_t>(info >> 32, k_max_payload));
+                std::memcpy(event.payload, words, event.size);
+                cursor_++;
+                return true;
+            }
+        }
+
+        // The daemon lapped us; carry on from the oldest event it still holds
+        const uint64_t next = header_->next.load(std::memory_order_acquire);
+        const uint64_t oldest = next > mask_ + 1 ? next - (mask_ + 1) : 0;
+        const uint64_t resume = std::max(oldest, cursor_ + 1);
+        lost_.fetch_add(resume - cursor_, std::memory_order_relaxed);
+        cursor_ = resume;
+    }
+}
+
+auto SharedRingReader::pending() const -> bool
+{
+    return slots_[cursor_ & mask_].stamp.load(std::memory_order_acquire) >= complete_stamp(cursor_);
+}
+
+void SharedRingReader::wait(std::chrono::milliseconds timeout)
+{
+    if (header_ == nullptr)
+    {
+        std::this_thread::sleep_for(timeout);
+        return;
+    }
+
+    Reader& reader = header_->readers[index_];
+    const uint32_t key = reader.wake.load(std::memory_order_acquire);
+    reader.parked.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (!pending())
+    {
+#if defined(_WIN32)
+        WaitForSingleObject(event_, static_cast<DWORD>(timeout.count()));
+#elif defined(__linux__)
+        const timespec relative{ static_cast<time_t>(timeout.count() / 1000), static_cast<long>(timeout.count() % 1000) * 1000000 };
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&reader.wake), FUTEX_WAIT, key, &relative, nullptr, 0);
+#else
+        // No cross-process wait here, so check back often
+        std::this_thread::sleep_for(std::min(timeout, std::chrono::milliseconds(1)));
+#endif
+    }
+    reader.parked.store(0, std::memory_order_relaxed);
+}
+
+void SharedRingReader::wake()
+{
+    if (header_ != nullptr)
+    {
+        signal(header_->readers[index_], event_);
+    }
+}
+
+auto SharedRingReader::devices() const -> std::vector<Device>
+{
+    std::vector<Device> result;
+    if (header_ == nullptr) return result;
+
+    for (uint32_t i = 0; i < k_device_slots; i++)
+    {
+        const SharedDevice& device = devices_[i];
+        const uint64_t address = device.address.load(std::memory_order_acquire);
+        if (address == 0) continue;
+
+        const uint32_t state = device.state.load(std::memory_order_acquire);
+        if ((state & k_named) == 0) continue;
+
+        result.push_back({ address, device.rssi, (state & k_connected) != 0, std::string(device.name, strnlen(device.name, k_max_name)) });
+    }
+    return result;
+}
+
+auto SharedRingReader::is_connected(uint64_t address) const -> bool
+{
+    if (header_ == nullptr) return false;
+
+    const SharedDevice* device = find_device(devices_, address);
+    return device != nullptr && (device->state.load(std::memory_order_acquire) & k_connected) != 0;
+}
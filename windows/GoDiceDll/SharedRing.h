@@ -0,0 +1,219 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "GoDiceDll.h"
+#include "MappedFile.h"
+#include "Stats.h"
+#include "TrafficCapture.h"
+
+// Transport events that a daemon process publishes for readers in other processes on
+// the same host. The daemon maps a file in shared memory (/dev/shm on Linux, the temp
+// directory elsewhere) and appends each event to a ring of fixed-size slots. Every
+// reader keeps its own cursor, so an extra reader adds nothing to the cost of an event
+// and a slow reader never holds up the others; one that falls a whole ring behind
+// skips ahead and counts what it lost.
+//
+// The file never leaves the host, so it holds native integers and lock-free atomics:
+//
+//   Header                  magic "GDSHARE\0", version, capacity, the next sequence,
+//                           how many dice are listed, and a table of attached readers
+//                           by process id, so a crashed reader's slot can be reclaimed
+//   SharedDevice[2048]      up to GD_MAX_DEVICES dice the daemon has seen, hashed by
+//                           address, and whether it holds each connected, for readers
+//                           that attach late
+//   SharedSlot[capacity]    the ring; a slot's stamp is 2 * sequence + 1 while it is
+//                           written and 2 * sequence + 2 once complete
+//
+// A daemon that restarts on the same name keeps counting from where the last one
+// stopped, so readers that stay attached carry on.
+namespace godice::shared
+{
+    constexpr char k_magic[8] = { 'G', 'D', 'S', 'H', 'A', 'R', 'E', '\0' };
+    constexpr uint32_t k_version = 2;
+    constexpr uint32_t k_max_readers = 16;
+    constexpr uint32_t k_max_devices = GD_MAX_DEVICES;
+    // Open addressing, kept at most half full
+    constexpr uint32_t k_device_slots = k_max_devices * 2;
+    constexpr uint32_t k_max_payload = 40;
+    constexpr uint32_t k_max_name = 32;
+
+    struct Reader
+    {
+        // Process id of the reader, 0 while the slot is free
+        std::atomic<uint32_t> owner;
+        std::atomic<uint32_t> parked;
+        // Bumped to wake the reader; a futex word on Linux
+        std::atomic<uint32_t> wake;
+        uint32_t reserved;
+    };
+
+    struct alignas(64) Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t capacity;
+        std::atomic<uint64_t> next;
+        std::atomic<uint32_t> devices;
+        uint32_t reserved;
+        Reader readers[k_max_readers];
+    };
+
+    enum DeviceState : uint32_t
+    {
+        // name is written before this is set and never changes afterwards
+        k_named = 1 << 0,
+        k_connected = 1 << 1,
+    };
+
+    struct SharedDevice
+    {
+        std::atomic<uint64_t> address;
+        std::atomic<uint32_t> state;
+        int16_t rssi;
+        uint16_t reserved;
+        char name[k_max_name];
+    };
+
+    struct SharedSlot
+    {
+        std::atomic<uint64_t> stamp;
+        std::atomic<uint64_t> address;
+        // kind | flags << 8 | rssi << 16 | size << 32
+        std::atomic<uint64_t> info;
+        std::array<std::atomic<uint64_t>, k_max_payload / 8> payload;
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+                  "the shared ring needs address-free atomics");
+    static_assert(sizeof(SharedSlot) == 64);
+
+    struct Event
+    {
+        uint64_t address;
+        CaptureKind kind;
+        uint8_t flags;
+        int16_t rssi;
+        uint16_t size;
+        uint8_t payload[k_max_payload];
+    };
+
+    struct Device
+    {
+        uint64_t address;
+        int16_t rssi;
+        bool connected;
+        std::string name;
+    };
+
+    // Where the daemon publishing `name` keeps its file
+    auto path_for(const std::string& name) -> std::string;
+}
+
+// The daemon's end. Safe to publish from any thread; costs one atomic load while off.
+class SharedRingWriter
+{
+public:
+    static constexpr uint32_t k_default_capacity = 4096;
+
+    SharedRingWriter() = default;
+    ~SharedRingWriter();
+
+    SharedRingWriter(const SharedRingWriter&) = delete;
+    SharedRingWriter& operator=(const SharedRingWriter&) = delete;
+
+    // capacity is rounded up to a power of two; 0 for the default
+    auto start(const std::string& name, uint32_t capacity) -> bool;
+    // Readers stay attached and simply see no more events
+    void stop();
+
+    void publish(CaptureKind kind, uint64_t address, const void* payload = nullptr, uint32_t size = 0, int16_t rssi = 0)
+    {
+        if (Mapping* mapping = mapping_.load(std::memory_order_acquire))
+        {
+            push(*mapping, kind, address, payload, size, rssi);
+        }
+    }
+
+    [[nodiscard]] auto published() const -> uint64_t { return published_.load(); }
+    // Advertisements from dice past k_max_devices, which late readers will not find
+    [[nodiscard]] auto unlisted() const -> uint64_t { return unlisted_.load(); }
+
+private:
+    struct Mapping
+    {
+        std::string name;
+        MappedFile file;
+        godice::shared::Header* header = nullptr;
+        godice::shared::SharedDevice* devices = nullptr;
+        godice::shared::SharedSlot* slots = nullptr;
+        uint64_t mask = 0;
+        // Windows only: each reader's wake event, opened the first time it parks
+        std::array<std::atomic<void*>, godice::shared::k_max_readers> events{};
+        std::atomic<bool> warned_full = false;
+    };
+
+    void push(Mapping& mapping, CaptureKind kind, uint64_t address, const void* payload, uint32_t size, int16_t rssi);
+    void update_device(Mapping& mapping, CaptureKind kind, uint64_t address, const void* payload, uint32_t size, int16_t rssi);
+    // Returns false if the roster is full
+    static auto list_device(Mapping& mapping, uint64_t address, const void* name, uint32_t size, int16_t rssi) -> bool;
+    static void wake_readers(Mapping& mapping);
+
+    std::mutex control_mutex_;
+    std::atomic<Mapping*> mapping_ = nullptr;
+    // Kept until destruction, since a publisher may still be writing into an old one
+    std::vector<std::unique_ptr<Mapping>> mappings_;
+    StatCounter published_;
+    StatCounter unlisted_;
+};
+
+// A reader's end, in any process on the host. Only one thread may read at a time;
+// wake() may be called from any thread.
+class SharedRingReader
+{
+public:
+    SharedRingReader() = default;
+    ~SharedRingReader();
+
+    SharedRingReader(const SharedRingReader&) = delete;
+    SharedRingReader& operator=(const SharedRingReader&) = delete;
+
+    // Fails if no daemon has published `name`, or every reader slot is taken by a
+    // process that is still running. Reading starts with the next event the daemon
+    // publishes.
+    auto open(const std::string& name) -> bool;
+    void close();
+
+    // Returns false if there is nothing to read yet. Events lost to lapping are
+    // skipped and added to lost().
+    auto read(godice::shared::Event& event) -> bool;
+    // Returns early when an event is published or wake() is called
+    void wait(std::chrono::milliseconds timeout);
+    void wake();
+
+    [[nodiscard]] auto devices() const -> std::vector<godice::shared::Device>;
+    [[nodiscard]] auto is_connected(uint64_t address) const -> bool;
+    [[nodiscard]] auto lost() const -> uint64_t { return lost_.load(std::memory_order_relaxed); }
+
+private:
+    [[nodiscard]] auto pending() const -> bool;
+
+    MappedFile file_;
+    godice::shared::Header* header_ = nullptr;
+    godice::shared::SharedDevice* devices_ = nullptr;
+    godice::shared::SharedSlot* slots_ = nullptr;
+    uint64_t mask_ = 0;
+    uint32_t index_ = 0;
+    void* event_ = nullptr;
+
+    uint64_t cursor_ = 0;
+    std::atomic<uint64_t> lost_ = 0;
+};
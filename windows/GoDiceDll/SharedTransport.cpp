@@ -0,0 +1,249 @@
+#include "SharedTransport.h"
+
+#include <chrono>
+#include <iterator>
+#include <string_view>
+
+#include "Log.h"
+
+using godice::log_info;
+using godice::log_warning;
+
+StatCounter SharedTransport::lost_;
+
+auto SharedTransport::open(const std::string& name) -> std::unique_ptr<SharedTransport>
+{
+    auto transport = std::unique_ptr<SharedTransport>(new SharedTransport());
+    if (!transport->ring_.open(name)) return nullptr;
+
+    log_info("[shared] reading dice from {}\n", name);
+    transport->reader_thread_ = std::thread(&SharedTransport::reader, transport.get());
+    return transport;
+}
+
+SharedTransport::~SharedTransport()
+{
+    keep_running_ = false;
+    ring_.wake();
+    if (reader_thread_.joinable())
+    {
+        reader_thread_.join();
+    }
+}
+
+void SharedTransport::set_listener(TransportListener* listener)
+{
+    listener_ = listener;
+}
+
+void SharedTransport::start_discovery()
+{
+    if (discovering_.exchange(true)) return;
+
+    // Dice the daemon found before we attached will not advertise again while it holds them
+    TransportListener* listener = listener_.load();
+    if (listener == nullptr) return;
+
+    for (const auto& device : ring_.devices())
+    {
+        listener->on_advertisement(device.address, device.name, device.rssi);
+    }
+}
+
+void SharedTransport::stop_discovery()
+{
+    if (!discovering_.exchange(false)) return;
+
+    if (TransportListener* listener = listener_.load())
+    {
+        listener->on_discovery_stopped();
+    }
+}
+
+void SharedTransport::connect(uint64_t address, TransportCompletion completion)
+{
+    {
+        std::scoped_lock lk(mutex_);
+        // The reader thread takes the lock to report the daemon's connects, so a connect
+        // the daemon completes after this check still reaches us
+        if (!ring_.is_connected(address))
+        {
+            connecting_[address].push_back({ Clock::now() + k_connect_timeout, std::move(completion) });
+            return;
+        }
+        connected_.insert(address);
+    }
+    completion(true);
+}
+
+void SharedTransport::subscribe(uint64_t address, TransportCompletion completion)
+{
+    bool success;
+    {
+        std::scoped_lock lk(mutex_);
+        success = connected_.contains(address);
+    }
+    completion(success);
+}
+
+void SharedTransport::write(uint64_t, const uint8_t*, uint32_t, WriteMode, TransportCompletion completion)
+{
+    completion(false);
+}
+
+void SharedTransport::disconnect(uint64_t address, TransportCompletion completion)
+{
+    {
+        std::scoped_lock lk(mutex_);
+        connected_.erase(address);
+    }
+    completion(true);
+}
+
+void SharedTransport::reset()
+{
+    std::unordered_map<uint64_t, std::vector<PendingConnect>> abandoned;
+    {
+        std::scoped_lock lk(mutex_);
+        discovering_ = false;
+        connected_.clear();
+        abandoned.swap(connecting_);
+    }
+    for (auto& [address, pending] : abandoned)
+    {
+        for (auto& connect : pending)
+        {
+            connect.completion(false);
+        }
+    }
+}
+
+void SharedTransport::reader()
+{
+    godice::shared::Event event{};
+    uint64_t reported_lost = 0;
+    // Connects are expired every so many events, and whenever the ring runs dry
+    uint32_t until_expiry = 0;
+
+    while (keep_running_.load(std::memory_order_relaxed))
+    {
+        if (until_expiry-- == 0)
+        {
+            expire_connects(Clock::now());
+            until_expiry = 1024;
+        }
+
+        if (!ring_.read(event))
+        {
+            if (const uint64_t lost = ring_.lost(); lost != reported_lost)
+            {
+                lost_.add(lost - reported_lost);
+                log_warning("[shared] {} events lost, the reader fell behind\n", lost - reported_lost);
+                reported_lost = lost;
+            }
+            ring_.wait(std::chrono::milliseconds(100));
+            until_expiry = 0;
+            continue;
+        }
+
+        if (TransportListener* listener = listener_.load(std::memory_order_relaxed))
+        {
+            emit(event, listener);
+        }
+    }
+}
+
+void SharedTransport::emit(const godice::shared::Event& event, TransportListener* listener)
+{
+    switch (event.kind)
+    {
+    case CaptureKind::Advertisement:
+        if (discovering_.load(std::memory_order_relaxed))
+        {
+            listener->on_advertisement(event.address, std::string_view(reinterpret_cast<const char*>(event.payload), event.size), event.rssi);
+        }
+        break;
+
+    case CaptureKind::Notification:
+        listener->on_notification(event.address, event.payload, event.size);
+        break;
+
+    case CaptureKind::Connected:
+    case CaptureKind::ConnectFailed:
+        complete_connects(event.address, event.kind == CaptureKind::Connected);
+        break;
+
+    case CaptureKind::Disconnected:
+    case CaptureKind::LinkLost:
+    {
+        bool was_connected;
+        {
+            std::scoped_lock lk(mutex_);
+            was_connected = connected_.erase(event.address) > 0;
+        }
+        if (was_connected)
+        {
+            listener->on_link_lost(event.address);
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+void SharedTransport::complete_connects(uint64_t address, bool success)
+{
+    std::vector<PendingConnect> pending;
+    {
+        std::scoped_lock lk(mutex_);
+        const auto it = connecting_.find(address);
+        if (it == connecting_.end()) return;
+
+        pending.swap(it->second);
+        connecting_.erase(it);
+        if (success)
+        {
+            connected_.insert(address);
+        }
+    }
+    for (auto& connect : pending)
+    {
+        connect.completion(success);
+    }
+}
+
+// Fails connects to dice the daemon never connected, or holds without being able to list
+void SharedTransport::expire_connects(Clock::time_point now)
+{
+    std::vector<TransportCompletion> expired;
+    {
+        std::scoped_lock lk(mutex_);
+        for (auto it = connecting_.begin(); it != connecting_.end();)
+        {
+            auto& pending = it->second;
+            for (auto connect = pending.begin(); connect != pending.end();)
+            {
+                if (connect->deadline <= now)
+                {
+                    expired.push_back(std::move(connect->completion));
+                    connect = pending.erase(connect);
+                }
+                else
+                {
+                    ++connect;
+                }
+            }
+            it = pending.empty() ? connecting_.erase(it) : std::next(it);
+        }
+    }
+    if (!expired.empty())
+    {
+        log_warning("[shared] {} connects timed out waiting for the daemon\n", expired.size());
+    }
+    for (auto& completion : expired)
+    {
+        completion(false);
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "SharedRing.h"
+#include "Stats.h"
+#include "Transport.h"
+
+// Dice owned by a daemon process on the same host, as published by its
+// godice_start_publishing. A reader thread turns the daemon's events back into
+// listener calls, so the rest of the framework works as it does over BLE.
+//
+// The daemon holds the sessions. Discovery reports every die it knows about and then
+// whatever it finds; a connect completes once the daemon holds the die connected, and
+// fails if the daemon's own attempt does or the daemon has not connected it within
+// k_connect_timeout. Notifications are delivered whether or not
+// the client has connected the die. Writes always fail, since only the daemon can send.
+class SharedTransport final : public Transport
+{
+public:
+    static constexpr auto k_connect_timeout = std::chrono::seconds(10);
+
+    // Returns null if nothing is published as `name`
+    static auto open(const std::string& name) -> std::unique_ptr<SharedTransport>;
+
+    // Events every SharedTransport in this process missed by falling a whole ring behind
+    static auto total_lost() -> uint64_t { return lost_.load(); }
+
+    ~SharedTransport() override;
+
+    void set_listener(TransportListener* listener) override;
+
+    void start_discovery() override;
+    void stop_discovery() override;
+
+    void connect(uint64_t address, TransportCompletion completion) override;
+    void subscribe(uint64_t address, TransportCompletion completion) override;
+    void write(uint64_t address, const uint8_t* data, uint32_t size, WriteMode mode, TransportCompletion completion) override;
+    void disconnect(uint64_t address, TransportCompletion completion) override;
+
+    void reset() override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingConnect
+    {
+        Clock::time_point deadline;
+        TransportCompletion completion;
+    };
+
+    SharedTransport() = default;
+
+    void reader();
+    void emit(const godice::shared::Event& event, TransportListener* listener);
+    void complete_connects(uint64_t address, bool success);
+    void expire_connects(Clock::time_point now);
+
+    static StatCounter lost_;
+
+    SharedRingReader ring_;
+
+    std::mutex mutex_;
+    std::unordered_set<uint64_t> connected_;
+    // Connects waiting on the daemon's own attempt
+    std::unordered_map<uint64_t, std::vector<PendingConnect>> connecting_;
+
+    std::atomic<bool> keep_running_ = true;
+    std::atomic<bool> discovering_ = false;
+    std::atomic<TransportListener*> listener_ = nullptr;
+
+    std::thread reader_thread_;
+};
@@ -0,0 +1,365 @@
+#include "SimulatedTransport.h"
+
+#include <cstdio>
+
+#include "DeviceIdentifier.h"
+#include "GoDiceProtocol.h"
+#include "Log.h"
+
+using godice::log_info;
+
+namespace
+{
+    // Resting vectors for a d6, matching FaceClassifier's table
+    constexpr int8_t k_d6_vectors[6][3] = {
+        { -64, 0, 0 }, { 0, 0, 64 }, { 0, 64, 0 }, { 0, -64, 0 }, { 0, 0, -64 }, { 64, 0, 0 },
+    };
+}
+
+auto SimulatedTransport::default_config() -> GDSimulationConfig
+{
+    GDSimulationConfig config{};
+    config.dice_count = 6;
+    config.rolls_per_second = 0.2f;
+    config.advertisements_per_second = 2.0f;
+    config.jitter_us = 2000;
+    config.connect_latency_ms = 300;
+    config.connect_failure_rate = 0.0f;
+    config.disconnects_per_second = 0.0f;
+    config.seed = 1;
+    return config;
+}
+
+SimulatedTransport::SimulatedTransport(const GDSimulationConfig& config) : config_(config), rng_(config.seed)
+{
+    std::uniform_int_distribution<int> color(0, 5);
+    std::uniform_int_distribution<int> battery(20, 100);
+    std::uniform_int_distribution<int> rssi(-90, -40);
+
+    for (uint32_t i = 0; i < config_.dice_count; i++)
+    {
+        const uint64_t address = k_first_address + i;
+        char name[32];
+        std::snprintf(name, sizeof(name), "GoDice_%06X_K_v04", static_cast<unsigned>(address & 0xFFFFFF));
+
+        Die die;
+        die.address = address;
+        die.name = name;
+        die.color = static_cast<uint8_t>(color(rng_));
+        die.battery = static_cast<uint8_t>(battery(rng_));
+        die.rssi = static_cast<int16_t>(rssi(rng_));
+        dice_.emplace(address, std::move(die));
+    }
+
+    scheduler_thread_ = std::thread(&SimulatedTransport::scheduler, this);
+}
+
+SimulatedTransport::~SimulatedTransport()
+{
+    {
+        std::unique_lock lk(mutex_);
+        keep_running_ = false;
+        condition_.notify_one();
+    }
+    scheduler_thread_.join();
+}
+
+void SimulatedTransport::set_listener(TransportListener* listener)
+{
+    std::unique_lock lk(mutex_);
+    listener_ = listener;
+}
+
+void SimulatedTransport::start_discovery()
+{
+    std::unique_lock lk(mutex_);
+    if (discovering_) return;
+
+    discovering_ = true;
+    for (const auto& [address, die] : dice_)
+    {
+        schedule_locked(exponential_locked(config_.advertisements_per_second), EventKind::Advertise, address);
+    }
+}
+
+void SimulatedTransport::stop_discovery()
+{
+    TransportListener* listener = nullptr;
+    {
+        std::unique_lock lk(mutex_);
+        if (!discovering_) return;
+        discovering_ = false;
+        discovery_generation_++;
+        listener = listener_;
+    }
+
+    if (listener)
+    {
+        listener->on_discovery_stopped();
+    }
+}
+
+void SimulatedTransport::connect(uint64_t address, TransportCompletion completion)
+{
+    std::unique_lock lk(mutex_);
+    if (!dice_.contains(address))
+    {
+        lk.unlock();
+        completion(false);
+        return;
+    }
+
+    schedule_locked(std::chrono::milliseconds(config_.connect_latency_ms) + jitter_locked(), EventKind::ConnectDone,
+                    address, std::move(completion));
+}
+
+void SimulatedTransport::subscribe(uint64_t address, TransportCompletion completion)
+{
+    std::unique_lock lk(mutex_);
+    schedule_locked(jitter_locked(), EventKind::SubscribeDone, address, std::move(completion));
+}
+
+void SimulatedTransport::write(uint64_t address, const uint8_t* data, uint32_t size, WriteMode, TransportCompletion completion)
+{
+    std::unique_lock lk(mutex_);
+    schedule_locked(jitter_locked(), EventKind::WriteDone, address, std::move(completion),
+                    std::vector<uint8_t>(data, data + size));
+}
+
+void SimulatedTransport::disconnect(uint64_t address, TransportCompletion completion)
+{
+    std::unique_lock lk(mutex_);
+    schedule_locked(jitter_locked(), EventKind::DisconnectDone, address, std::move(completion));
+}
+
+void SimulatedTransport::reset()
+{
+    std::unique_lock lk(mutex_);
+    discovering_ = false;
+    discovery_generation_++;
+    for (auto& [address, die] : dice_)
+    {
+        die.connected = false;
+        die.subscribed = false;
+        die.generation++;
+    }
+}
+
+void SimulatedTransport::scheduler()
+{
+    std::unique_lock lk(mutex_);
+    while (keep_running_)
+    {
+        if (timeline_.empty())
+        {
+            condition_.wait(lk);
+            continue;
+        }
+
+        const auto when = timeline_.top().when;
+        if (Clock::now() < when)
+        {
+            condition_.wait_until(lk, when);
+            continue;
+        }
+
+        Event event = timeline_.top();
+        timeline_.pop();
+
+        if (auto work = process_locked(event))
+        {
+            lk.unlock();
+            work();
+            lk.lock();
+        }
+    }
+}
+
+auto SimulatedTransport::process_locked(Event& event) -> std::function<void()>
+{
+    const auto it = dice_.find(event.address);
+    TransportListener* listener = listener_;
+    auto completion = std::move(event.completion);
+
+    if (it == dice_.end())
+    {
+        return completion ? std::function<void()>([completion] { completion(false); }) : nullptr;
+    }
+
+    Die& die = it->second;
+    const uint64_t address = die.address;
+
+    // A completion must always run, even for a die that was reset underneath it
+    const uint32_t generation = event.kind == EventKind::Advertise ? discovery_generation_ : die.generation;
+    if (event.generation != generation)
+    {
+        return completion ? std::function<void()>([completion] { completion(false); }) : nullptr;
+    }
+
+    switch (event.kind)
+    {
+    case EventKind::Advertise:
+    {
+        if (!discovering_ || listener == nullptr) return nullptr;
+        schedule_locked(exponential_locked(config_.advertisements_per_second), EventKind::Advertise, address);
+
+        const std::string name = die.name;
+        const int16_t rssi = die.rssi;
+        return [listener, address, name, rssi] { listener->on_advertisement(address, name, rssi); };
+    }
+
+    case EventKind::ConnectDone:
+    {
+        const bool success = !chance_locked(config_.connect_failure_rate);
+        die.connected = success;
+        if (success)
+        {
+            schedule_link_loss_locked(die);
+        }
+        return [completion, success] { completion(success); };
+    }
+
+    case EventKind::SubscribeDone:
+    {
+        const bool success = die.connected;
+        if (success && !die.subscribed)
+        {
+            die.subscribed = true;
+            schedule_next_roll_locked(die);
+        }
+        return [completion, success] { completion(success); };
+    }
+
+    case EventKind::WriteDone:
+    {
+        const bool success = die.connected;
+        if (success && die.subscribed && !event.payload.empty())
+        {
+            if (event.payload[0] == godice::protocol::k_color_request)
+            {
+                schedule_locked(jitter_locked(), EventKind::Notify, address, nullptr, { 'C', 'o', 'l', die.color });
+            }
+            else if (event.payload[0] == godice::protocol::k_battery_level_request)
+            {
+                schedule_locked(jitter_locked(), EventKind::Notify, address, nullptr, { 'B', 'a', 't', die.battery });
+            }
+        }
+        return [completion, success] { completion(success); };
+    }
+
+    case EventKind::DisconnectDone:
+    {
+        die.connected = false;
+        die.subscribed = false;
+        die.generation++;
+        return [completion] { completion(true); };
+    }
+
+    case EventKind::RollStarted:
+    {
+        if (!die.subscribed) return nullptr;
+
+        std::uniform_int_distribution<int> settle_ms(300, 1500);
+        schedule_locked(std::chrono::milliseconds(settle_ms(rng_)) + jitter_locked(), EventKind::RollStable, address);
+        return [listener, address]
+        {
+            const uint8_t packet[] = { 'R' };
+            listener->on_notification(address, packet, sizeof(packet));
+        };
+    }
+
+    case EventKind::RollStable:
+    {
+        if (!die.subscribed) return nullptr;
+
+        schedule_next_roll_locked(die);
+        auto packet = stable_packet_locked();
+        return [listener, address, packet] { listener->on_notification(address, packet.data(), static_cast<uint32_t>(packet.size())); };
+    }
+
+    case EventKind::Notify:
+    {
+        if (!die.subscribed) return nullptr;
+
+        auto packet = std::move(event.payload);
+        return [listener, address, packet] { listener->on_notification(address, packet.data(), static_cast<uint32_t>(packet.size())); };
+    }
+
+    case EventKind::LinkLost:
+    {
+        if (!die.connected) return nullptr;
+
+        log_info("[simulator] dropping link to {}\n", die.name);
+        die.connected = false;
+        die.subscribed = false;
+        die.generation++;
+        return listener ? std::function<void()>([listener, address] { listener->on_link_lost(address); }) : nullptr;
+    }
+    }
+
+    return nullptr;
+}
+
+void SimulatedTransport::schedule_locked(Clock::duration delay, EventKind kind, uint64_t address,
+                                         TransportCompletion completion, std::vector<uint8_t> payload)
+{
+    const auto it = dice_.find(address);
+    uint32_t generation = it != dice_.end() ? it->second.generation : 0;
+    if (kind == EventKind::Advertise)
+    {
+        generation = discovery_generation_;
+    }
+
+    timeline_.push(Event{ Clock::now() + delay, next_sequence_++, kind, address, generation, std::move(completion), std::move(payload) });
+    condition_.notify_one();
+}
+
+auto SimulatedTransport::jitter_locked() -> Clock::duration
+{
+    if (config_.jitter_us == 0) return Clock::duration::zero();
+
+    std::uniform_int_distribution<uint32_t> jitter(0, config_.jitter_us);
+    return std::chrono::microseconds(jitter(rng_));
+}
+
+auto SimulatedTransport::exponential_locked(float rate_per_second) -> Clock::duration
+{
+    if (rate_per_second <= 0.0f) return std::chrono::hours(24 * 365);
+
+    std::exponential_distribution<double> interval(rate_per_second);
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(interval(rng_))) + jitter_locked();
+}
+
+auto SimulatedTransport::chance_locked(float probability) -> bool
+{
+    if (probability <= 0.0f) return false;
+
+    std::bernoulli_distribution chance(probability >= 1.0f ? 1.0 : probability);
+    return chance(rng_);
+}
+
+void SimulatedTransport::schedule_next_roll_locked(const Die& die)
+{
+    if (config_.rolls_per_second <= 0.0f) return;
+    schedule_locked(exponential_locked(config_.rolls_per_second), EventKind::RollStarted, die.address);
+}
+
+void SimulatedTransport::schedule_link_loss_locked(const Die& die)
+{
+    if (config_.disconnects_per_second <= 0.0f) return;
+    schedule_locked(exponential_locked(config_.disconnects_per_second), EventKind::LinkLost, die.address);
+}
+
+auto SimulatedTransport::stable_packet_locked() -> std::vector<uint8_t>
+{
+    std::uniform_int_distribution<int> face(0, 5);
+    std::uniform_int_distribution<int> noise(-4, 4);
+
+    const auto& vector = k_d6_vectors[face(rng_)];
+    return {
+        'S',
+        static_cast<uint8_t>(vector[0] + noise(rng_)),
+        static_cast<uint8_t>(vector[1] + noise(rng_)),
+        static_cast<uint8_t>(vector[2] + noise(rng_)),
+    };
+}
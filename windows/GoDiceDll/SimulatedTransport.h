@@ -0,0 +1,117 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "GoDiceDll.h"
+#include "Transport.h"
+
+// In-process stand-in for a room full of GoDice. A single scheduler thread plays
+// out advertisements, connects, rolls and command responses on a timeline, so the
+// rest of the framework sees the same event shapes as it would from real hardware.
+class SimulatedTransport final : public Transport
+{
+public:
+    static constexpr uint64_t k_first_address = 0xC0DE00000000ull;
+
+    static auto default_config() -> GDSimulationConfig;
+
+    explicit SimulatedTransport(const GDSimulationConfig& config);
+    ~SimulatedTransport() override;
+
+    void set_listener(TransportListener* listener) override;
+
+    void start_discovery() override;
+    void stop_discovery() override;
+
+    void connect(uint64_t address, TransportCompletion completion) override;
+    void subscribe(uint64_t address, TransportCompletion completion) override;
+    void write(uint64_t address, const uint8_t* data, uint32_t size, WriteMode mode, TransportCompletion completion) override;
+    void disconnect(uint64_t address, TransportCompletion completion) override;
+
+    void reset() override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    enum class EventKind
+    {
+        Advertise,
+        ConnectDone,
+        SubscribeDone,
+        WriteDone,
+        DisconnectDone,
+        RollStarted,
+        RollStable,
+        Notify,
+        LinkLost,
+    };
+
+    struct Event
+    {
+        Clock::time_point when;
+        uint64_t sequence;
+        EventKind kind;
+        uint64_t address;
+        // Events scheduled before a die was reset are dropped when they come due.
+        // Advertisements carry the discovery generation instead.
+        uint32_t generation;
+        TransportCompletion completion;
+        std::vector<uint8_t> payload;
+
+        auto operator>(const Event& other) const -> bool
+        {
+            return when != other.when ? when > other.when : sequence > other.sequence;
+        }
+    };
+
+    struct Die
+    {
+        uint64_t address;
+        std::string name;
+        uint8_t color;
+        uint8_t battery;
+        int16_t rssi;
+        bool connected = false;
+        bool subscribed = false;
+        uint32_t generation = 0;
+    };
+
+    const GDSimulationConfig config_;
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::priority_queue<Event, std::vector<Event>, std::greater<>> timeline_;
+    std::unordered_map<uint64_t, Die> dice_;
+    std::mt19937_64 rng_;
+    uint64_t next_sequence_ = 0;
+    bool discovering_ = false;
+    // Bumped whenever discovery stops, ending every die's advertisement chain
+    uint32_t discovery_generation_ = 0;
+    bool keep_running_ = true;
+    TransportListener* listener_ = nullptr;
+
+    std::thread scheduler_thread_;
+
+    void scheduler();
+    // Returns the work to run once mutex_ is released
+    auto process_locked(Event& event) -> std::function<void()>;
+
+    void schedule_locked(Clock::duration delay, EventKind kind, uint64_t address, TransportCompletion completion = nullptr,
+                         std::vector<uint8_t> payload = {});
+    auto jitter_locked() -> Clock::duration;
+    auto exponential_locked(float rate_per_second) -> Clock::duration;
+    auto chance_locked(float probability) -> bool;
+    void schedule_next_roll_locked(const Die& die);
+    void schedule_link_loss_locked(const Die& die);
+    auto stable_packet_locked() -> std::vector<uint8_t>;
+};
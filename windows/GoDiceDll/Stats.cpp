@@ -0,0 +1,73 @@
+#include "Stats.h"
+
+#include <algorithm>
+#include <bit>
+
+auto godice::stats::shard_index() -> size_t
+{
+    static std::atomic<size_t> next_shard = 0;
+    thread_local const size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % k_shards;
+    return shard;
+}
+
+auto StatCounter::load() const -> uint64_t
+{
+    uint64_t total = 0;
+    for (const auto& shard : shards_)
+    {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void LatencyHistogram::record(Clock::duration elapsed)
+{
+    const auto ns = static_cast<uint64_t>(std::max<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), 0));
+    Shard& shard = shards_[godice::stats::shard_index()];
+
+    shard.total_ns.fetch_add(ns, std::memory_order_relaxed);
+    shard.buckets[bucket_for(ns)].fetch_add(1, std::memory_order_relaxed);
+
+    // Threads beyond k_shards share a shard, so the maximum still needs a compare-exchange
+    uint64_t max = shard.max_ns.load(std::memory_order_relaxed);
+    while (ns > max && !shard.max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+void LatencyHistogram::snapshot(GDLatencyHistogram& out) const
+{
+    out = GDLatencyHistogram{};
+    for (const auto& shard : shards_)
+    {
+        out.total_ns += shard.total_ns.load(std::memory_order_relaxed);
+        out.max_ns = std::max(out.max_ns, shard.max_ns.load(std::memory_order_relaxed));
+        for (size_t bucket = 0; bucket < GD_LATENCY_BUCKETS; bucket++)
+        {
+            out.buckets[bucket] += shard.buckets[bucket].load(std::memory_order_relaxed);
+        }
+    }
+    for (const uint64_t samples : out.buckets)
+    {
+        out.count += samples;
+    }
+}
+
+auto LatencyHistogram::count() const -> uint64_t
+{
+    uint64_t total = 0;
+    for (const auto& shard : shards_)
+    {
+        for (const auto& samples : shard.buckets)
+        {
+            total += samples.load(std::memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+auto LatencyHistogram::bucket_for(uint64_t ns) -> uint32_t
+{
+    const uint64_t us = ns / 1000;
+    return std::min(static_cast<uint32_t>(std::bit_width(us)), static_cast<uint32_t>(GD_LATENCY_BUCKETS - 1));
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "GoDiceDll.h"
+
+// Counters and latency histograms behind godice_get_stats, cheap enough for the hot
+// paths. Each is split into cache-line shards and a thread always adds to its own, so
+// writers neither lock nor share a line with other threads. A snapshot sums the shards
+// while writers carry on, so it is not a single instant, only close to one.
+namespace godice::stats
+{
+    constexpr size_t k_shards = 16;
+    constexpr size_t k_cache_line = 64;
+
+    // Handed out round-robin, once per thread
+    auto shard_index() -> size_t;
+}
+
+class StatCounter
+{
+public:
+    void add(uint64_t n = 1)
+    {
+        shards_[godice::stats::shard_index()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] auto load() const -> uint64_t;
+
+private:
+    struct alignas(godice::stats::k_cache_line) Shard
+    {
+        std::atomic<uint64_t> value = 0;
+    };
+
+    std::array<Shard, godice::stats::k_shards> shards_{};
+};
+
+// Power-of-two microsecond buckets, as described for GDLatencyHistogram
+class LatencyHistogram
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void record(Clock::duration elapsed);
+    void record_since(Clock::time_point start) { record(Clock::now() - start); }
+
+    void snapshot(GDLatencyHistogram& out) const;
+    [[nodiscard]] auto count() const -> uint64_t;
+
+    static auto bucket_for(uint64_t ns) -> uint32_t;
+
+private:
+    // The count is the sum of the buckets, which saves an atomic per sample
+    struct alignas(godice::stats::k_cache_line) Shard
+    {
+        std::atomic<uint64_t> total_ns = 0;
+        std::atomic<uint64_t> max_ns = 0;
+        std::array<std::atomic<uint64_t>, GD_LATENCY_BUCKETS> buckets{};
+    };
+
+    std::array<Shard, godice::stats::k_shards> shards_{};
+};
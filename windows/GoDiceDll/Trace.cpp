@@ -0,0 +1,249 @@
+#include "Trace.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "DeviceIdentifier.h"
+
+using godice::trace::Clock;
+
+std::atomic<bool> godice::trace::detail::g_enabled = false;
+
+namespace
+{
+    // Thread tracks are told apart from die addresses, which only use 48 bits
+    constexpr uint64_t k_thread_bit = 1ull << 63;
+    constexpr uint32_t k_first_die_tid = 100000;
+
+    struct Slot
+    {
+        // 2 * index + 1 while being written, 2 * index + 2 once complete
+        std::atomic<uint64_t> sequence = 0;
+        std::atomic<uint64_t> begin_ns = 0;
+        std::atomic<uint64_t> duration_ns = 0;
+        std::atomic<uint64_t> track = 0;
+        std::atomic<const char*> name = nullptr;
+        std::atomic<const char*> arg_name = nullptr;
+        std::atomic<int64_t> arg = 0;
+    };
+
+    struct Ring
+    {
+        explicit Ring(uint32_t capacity) : mask(capacity - 1), slots(std::make_unique<Slot[]>(capacity)) {}
+
+        const uint64_t mask;
+        const std::unique_ptr<Slot[]> slots;
+        std::atomic<uint64_t> next = 0;
+        // Spans before this index belong to an earlier start
+        std::atomic<uint64_t> first = 0;
+    };
+
+    struct Span
+    {
+        uint64_t begin_ns;
+        uint64_t duration_ns;
+        uint64_t track;
+        const char* name;
+        const char* arg_name;
+        int64_t arg;
+    };
+
+    std::mutex g_control_mutex;
+    std::atomic<Ring*> g_ring = nullptr;
+    // Every ring ever used; a writer that raced a restart may still hold an old one
+    std::vector<std::unique_ptr<Ring>> g_rings;
+
+    struct ThreadNames
+    {
+        std::mutex mutex;
+        std::unordered_map<uint32_t, std::string> names;
+    };
+
+    // Queues are globals whose threads name themselves during static initialization
+    auto thread_names() -> ThreadNames&
+    {
+        static ThreadNames names;
+        return names;
+    }
+
+    std::atomic<uint32_t> g_next_thread = 1;
+
+    auto thread_id() -> uint32_t
+    {
+        thread_local const uint32_t id = g_next_thread.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    auto nanoseconds(Clock::time_point time) -> uint64_t
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+    }
+
+    auto round_up_pow2(uint32_t n) -> uint32_t
+    {
+        uint32_t result = 2;
+        while (result < n && result < (1u << 31))
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    auto read_slot(const Slot& slot, uint64_t index, Span& span) -> bool
+    {
+        const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != 2 * index + 2) return false;
+
+        span.begin_ns = slot.begin_ns.load(std::memory_order_relaxed);
+        span.duration_ns = slot.duration_ns.load(std::memory_order_relaxed);
+        span.track = slot.track.load(std::memory_order_relaxed);
+        span.name = slot.name.load(std::memory_order_relaxed);
+        span.arg_name = slot.arg_name.load(std::memory_order_relaxed);
+        span.arg = slot.arg.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.sequence.load(std::memory_order_relaxed) == sequence;
+    }
+
+    // Names come from string literals and thread names; only quotes and backslashes need care
+    auto escaped(const std::string& text) -> std::string
+    {
+        std::string out;
+        for (const char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out += '\\';
+            }
+            out += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+        }
+        return out;
+    }
+}
+
+void godice::trace::start(uint32_t capacity)
+{
+    std::scoped_lock lk(g_control_mutex);
+    detail::g_enabled = false;
+
+    capacity = round_up_pow2(capacity != 0 ? capacity : k_default_capacity);
+    Ring* ring = g_ring.load(std::memory_order_relaxed);
+    if (ring == nullptr || ring->mask + 1 != capacity)
+    {
+        g_rings.push_back(std::make_unique<Ring>(capacity));
+        ring = g_rings.back().get();
+        g_ring.store(ring, std::memory_order_release);
+    }
+    ring->first = ring->next.load();
+
+    detail::g_enabled = true;
+}
+
+void godice::trace::stop()
+{
+    std::scoped_lock lk(g_control_mutex);
+    detail::g_enabled = false;
+}
+
+void godice::trace::name_thread(const std::string& name)
+{
+    ThreadNames& threads = thread_names();
+    std::scoped_lock lk(threads.mutex);
+    threads.names[thread_id()] = name;
+}
+
+void godice::trace::complete(const char* name, uint64_t track, Clock::time_point begin, Clock::time_point end,
+                             const char* arg_name, int64_t arg)
+{
+    Ring* ring = g_ring.load(std::memory_order_acquire);
+    if (ring == nullptr || !enabled()) return;
+
+    const uint64_t index = ring->next.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = ring->slots[index & ring->mask];
+
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.begin_ns.store(nanoseconds(begin), std::memory_order_relaxed);
+    slot.duration_ns.store(end > begin ? nanoseconds(end) - nanoseconds(begin) : 0, std::memory_order_relaxed);
+    slot.track.store(track == k_thread_track ? k_thread_bit | thread_id() : track, std::memory_order_relaxed);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.arg_name.store(arg_name, std::memory_order_relaxed);
+    slot.arg.store(arg, std::memory_order_relaxed);
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+auto godice::trace::write_json(const std::string& path) -> bool
+{
+    std::vector<Span> spans;
+    if (Ring* ring = g_ring.load(std::memory_order_acquire))
+    {
+        const uint64_t end = ring->next.load(std::memory_order_acquire);
+        const uint64_t capacity = ring->mask + 1;
+        const uint64_t begin = std::max(ring->first.load(), end > capacity ? end - capacity : 0);
+
+        spans.reserve(static_cast<size_t>(end - begin));
+        for (uint64_t index = begin; index < end; index++)
+        {
+            Span span;
+            if (read_slot(ring->slots[index & ring->mask], index, span))
+            {
+                spans.push_back(span);
+            }
+        }
+    }
+
+    // Viewers want parents before the spans they contain
+    std::sort(spans.begin(), spans.end(), [](const Span& a, const Span& b)
+    {
+        return a.begin_ns != b.begin_ns ? a.begin_ns < b.begin_ns : a.duration_ns > b.duration_ns;
+    });
+
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) return false;
+
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GoDice\"}}");
+
+    const uint64_t origin = spans.empty() ? 0 : spans.front().begin_ns;
+    std::unordered_map<uint64_t, uint32_t> tids;
+    for (const Span& span : spans)
+    {
+        auto [it, added] = tids.try_emplace(span.track, 0);
+        if (added)
+        {
+            std::string track_name;
+            if (span.track & k_thread_bit)
+            {
+                it->second = static_cast<uint32_t>(span.track & ~k_thread_bit);
+                ThreadNames& threads = thread_names();
+                std::scoped_lock lk(threads.mutex);
+                const auto named = threads.names.find(it->second);
+                track_name = named != threads.names.end() ? named->second : "thread " + std::to_string(it->second);
+            }
+            else
+            {
+                it->second = k_first_die_tid + static_cast<uint32_t>(tids.size());
+                track_name = "die " + identifier_string(span.track);
+            }
+            std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%" PRIu32 ",\"args\":{\"name\":\"%s\"}}",
+                         it->second, escaped(track_name).c_str());
+        }
+
+        std::fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"godice\",\"ph\":\"X\",\"pid\":1,\"tid\":%" PRIu32 ",\"ts\":%.3f,\"dur\":%.3f",
+                     escaped(span.name).c_str(), it->second, static_cast<double>(span.begin_ns - origin) / 1000.0,
+                     static_cast<double>(span.duration_ns) / 1000.0);
+        if (span.arg_name != nullptr)
+        {
+            std::fprintf(file, ",\"args\":{\"%s\":%" PRId64 "}", escaped(span.arg_name).c_str(), span.arg);
+        }
+        std::fprintf(file, "}");
+    }
+
+    std::fprintf(file, "\n]}\n");
+    return std::fclose(file) == 0;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Optional span tracing for finding out where connects and dispatch spend their time.
+// While it runs, finished spans go into a ring that keeps the most recent ones and can
+// be written out as Chrome trace-event JSON at any time (chrome://tracing, Perfetto).
+//
+// A span lands on a track: either the thread that recorded it (k_thread_track), or a
+// die's track, named after its identifier, for work such as a connect that moves
+// between threads and coroutines. Spans on one track must nest.
+//
+// Recording is lock-free: a span takes a slot with one fetch_add, and each slot has a
+// sequence number so a writer overtaking the reader never yields a torn span.
+namespace godice::trace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr uint64_t k_thread_track = 0;
+    constexpr uint32_t k_default_capacity = 1 << 16;
+
+    namespace detail
+    {
+        extern std::atomic<bool> g_enabled;
+    }
+
+    // One atomic load; check before doing any work for a span
+    inline auto enabled() -> bool
+    {
+        return detail::g_enabled.load(std::memory_order_relaxed);
+    }
+
+    // Clears the ring. A capacity of 0 means k_default_capacity.
+    void start(uint32_t capacity);
+    void stop();
+    auto write_json(const std::string& path) -> bool;
+
+    // Names the calling thread's track
+    void name_thread(const std::string& name);
+
+    // `name` and `arg_name` must outlive the trace, e.g. string literals
+    void complete(const char* name, uint64_t track, Clock::time_point begin, Clock::time_point end,
+                  const char* arg_name = nullptr, int64_t arg = 0);
+}
+
+// Records a span from construction until end() or destruction, if tracing was on at
+// construction. Fine to hold across co_await.
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char* name, uint64_t track = godice::trace::k_thread_track)
+        : name_(godice::trace::enabled() ? name : nullptr), track_(track)
+    {
+        if (name_ != nullptr)
+        {
+            begin_ = godice::trace::Clock::now();
+        }
+    }
+
+    ~TraceSpan() { end(); }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    // Attaches a value to the span, shown under args
+    void set_arg(const char* arg_name, int64_t arg)
+    {
+        arg_name_ = arg_name;
+        arg_ = arg;
+    }
+
+    void end()
+    {
+        if (name_ == nullptr) return;
+
+        godice::trace::complete(name_, track_, begin_, godice::trace::Clock::now(), arg_name_, arg_);
+        name_ = nullptr;
+    }
+
+private:
+    const char* name_;
+    const uint64_t track_;
+    godice::trace::Clock::time_point begin_{};
+    const char* arg_name_ = nullptr;
+    int64_t arg_ = 0;
+};
@@ -0,0 +1,223 @@
+#include "TrafficCapture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+static constexpr size_t k_ring_capacity = 1 << 16;
+static constexpr uint32_t k_min_file_bytes = 4096;
+
+static auto padded(uint32_t size) -> uint32_t
+{
+    return (size + 7) & ~7u;
+}
+
+auto TrafficCapture::default_config() -> GDCaptureConfig
+{
+    GDCaptureConfig config{};
+    config.max_file_bytes = 64 << 20;
+    config.max_files = 4;
+    return config;
+}
+
+TrafficCapture::~TrafficCapture()
+{
+    stop();
+}
+
+auto TrafficCapture::start(const std::string& path, const GDCaptureConfig& config) -> bool
+{
+    stop();
+
+    std::scoped_lock lk(control_mutex_);
+    if (path.empty()) return false;
+
+    const GDCaptureConfig defaults = default_config();
+    path_ = path;
+    config_.max_file_bytes = config.max_file_bytes != 0 ? std::max(config.max_file_bytes, k_min_file_bytes) : defaults.max_file_bytes;
+    config_.max_files = config.max_files != 0 ? config.max_files : defaults.max_files;
+
+    if (ring_ == nullptr)
+    {
+        ring_ = std::make_unique<MpscRing<Entry>>(k_ring_capacity);
+    }
+    // A producer racing the previous stop() may have left an event behind
+    Entry stale;
+    while (ring_->try_pop(stale))
+    {
+    }
+
+    origin_ = std::chrono::steady_clock::now();
+    origin_unix_ns_ = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    file_index_ = 0;
+    recorded_ = 0;
+    dropped_ = 0;
+    reported_dropped_ = 0;
+
+    rotate_files();
+    if (!open_file()) return false;
+
+    keep_writing_ = true;
+    writer_thread_ = std::thread(&TrafficCapture::writer, this);
+    active_.store(true, std::memory_order_release);
+    return true;
+}
+
+void TrafficCapture::stop()
+{
+    std::scoped_lock lk(control_mutex_);
+    if (!writer_thread_.joinable()) return;
+
+    active_ = false;
+    keep_writing_ = false;
+    writer_thread_.join();
+    close_file();
+}
+
+void TrafficCapture::push(CaptureKind kind, uint64_t address, const void* payload, uint32_t size, int16_t rssi)
+{
+    Entry entry;
+    entry.timestamp_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - origin_).count());
+    entry.address = address;
+    entry.kind = kind;
+    entry.flags = size > k_max_payload ? k_capture_truncated : 0;
+    entry.rssi = rssi;
+    entry.size = static_cast<uint16_t>(std::min(size, k_max_payload));
+    if (entry.size > 0)
+    {
+        std::memcpy(entry.payload, payload, entry.size);
+    }
+
+    if (ring_->try_push(entry))
+    {
+        recorded_.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TrafficCapture::writer()
+{
+    for (;;)
+    {
+        // Read before draining, so nothing pushed before stop() is left behind
+        const bool keep_writing = keep_writing_.load();
+
+        bool wrote = false;
+        Entry entry;
+        while (ring_->try_pop(entry))
+        {
+            append(entry);
+            wrote = true;
+        }
+
+        if (const uint64_t dropped = dropped_.load(std::memory_order_relaxed); dropped != reported_dropped_)
+        {
+            Entry notice{};
+            notice.timestamp_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - origin_).count());
+            notice.kind = CaptureKind::Dropped;
+            notice.size = sizeof(uint64_t);
+            const uint64_t lost = dropped - reported_dropped_;
+            std::memcpy(notice.payload, &lost, sizeof(lost));
+            append(notice);
+            reported_dropped_ = dropped;
+        }
+
+        if (!keep_writing) return;
+        if (!wrote)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+    }
+}
+
+void TrafficCapture::append(const Entry& entry)
+{
+    if (!file_.is_open()) return;
+
+    const uint32_t bytes = k_record_header_size + padded(entry.size);
+    if (position_ + bytes > file_.size())
+    {
+        close_file();
+        file_index_++;
+        rotate_files();
+        if (!open_file())
+        {
+            // Nowhere to write; stop taking events rather than queueing them forever
+            active_ = false;
+            return;
+        }
+    }
+
+    uint8_t* out = file_.data() + position_;
+    std::memcpy(out, &entry.timestamp_ns, 8);
+    std::memcpy(out + 8, &entry.address, 8);
+    out[16] = static_cast<uint8_t>(entry.kind);
+    out[17] = entry.flags;
+    std::memcpy(out + 18, &entry.rssi, 2);
+    std::memcpy(out + 20, &entry.size, 2);
+    std::memcpy(out + k_record_header_size, entry.payload, entry.size);
+    position_ += bytes;
+}
+
+auto TrafficCapture::open_file() -> bool
+{
+    // rotate_files() normally moves any old file away, but a failed rename leaves it in place
+    std::error_code ec;
+    const bool reused = std::filesystem::exists(std::filesystem::path(path_), ec);
+
+    if (!file_.open(path_, config_.max_file_bytes)) return false;
+
+    // Readers stop at the first zero kind, so stale records must not follow ours
+    if (reused)
+    {
+        std::memset(file_.data(), 0, file_.size());
+    }
+
+    uint8_t* header = file_.data();
+    std::memcpy(header, k_magic, sizeof(k_magic));
+    std::memcpy(header + 8, &k_version, 4);
+    std::memcpy(header + 12, &k_header_size, 4);
+    std::memcpy(header + 16, &origin_unix_ns_, 8);
+    std::memcpy(header + 24, &file_index_, 4);
+    position_ = k_header_size;
+    return true;
+}
+
+void TrafficCapture::close_file()
+{
+    if (!file_.is_open()) return;
+
+    const std::string path = file_.path();
+    file_.close();
+
+    std::error_code ec;
+    std::filesystem::resize_file(std::filesystem::path(path), position_, ec);
+}
+
+void TrafficCapture::rotate_files()
+{
+    namespace fs = std::filesystem;
+    std::error_code ec;
+
+    const auto numbered = [this](uint32_t index) { return fs::path(path_ + "." + std::to_string(index)); };
+
+    if (config_.max_files <= 1)
+    {
+        fs::remove(fs::path(path_), ec);
+        return;
+    }
+
+    fs::remove(numbered(config_.max_files - 1), ec);
+    for (uint32_t index = config_.max_files - 1; index > 1; index--)
+    {
+        fs::rename(numbered(index - 1), numbered(index), ec);
+    }
+    fs::rename(fs::path(path_), numbered(1), ec);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "GoDiceDll.h"
+#include "MappedFile.h"
+#include "MpscRing.h"
+
+// Binary capture of everything the transport reports, for replaying what the dice
+// actually did. All integers are little-endian.
+//
+// Each file starts with a 32-byte header:
+//
+//   char    magic[8]        "GDCAPT\0\0"
+//   uint32  version         1
+//   uint32  header_size     32; records start here
+//   uint64  origin_unix_ns  wall-clock time of timestamp 0
+//   uint32  file_index      0 for the first file of a capture, +1 per rotation
+//   uint32  reserved
+//
+// followed by records, each a 24-byte header and a payload padded to 8 bytes:
+//
+//   uint64  timestamp_ns    monotonic, since origin
+//   uint64  address         48-bit Bluetooth address; 0 for Dropped
+//   uint8   kind            CaptureKind; 0 marks the end of the data
+//   uint8   flags           CaptureFlags
+//   int16   rssi            advertisements only
+//   uint16  size            payload bytes, before padding
+//   uint16  reserved
+//   uint8   payload[size]
+//
+// A file is preallocated to the rotation size and cut to length when it is closed,
+// so after a crash the zeroed tail reads as the end marker. When a file is full it
+// is renamed path.1 (older files shift up, the oldest is deleted) and a new one is
+// started at path.
+enum class CaptureKind : uint8_t
+{
+    End = 0,
+    Advertisement = 1,      // payload: the advertised name
+    Notification = 2,       // payload: the packet
+    Write = 3,              // payload: the command sent to the die
+    Connected = 4,
+    ConnectFailed = 5,
+    Disconnected = 6,       // after godice_disconnect
+    LinkLost = 7,           // the transport saw the link drop
+    Dropped = 8,            // payload: uint64 count of records lost because the writer fell behind
+};
+
+enum CaptureFlags : uint8_t
+{
+    k_capture_truncated = 1 << 0,
+};
+
+// Producers copy each event into a preallocated ring and return; a dedicated writer
+// thread appends them to the mapped file. A full ring drops the event and counts it
+// rather than blocking the receive path.
+class TrafficCapture
+{
+public:
+    static constexpr char k_magic[8] = { 'G', 'D', 'C', 'A', 'P', 'T', '\0', '\0' };
+    static constexpr uint32_t k_version = 1;
+    static constexpr uint32_t k_header_size = 32;
+    static constexpr uint32_t k_record_header_size = 24;
+    // Longer payloads are cut and flagged; GoDice packets and names are far shorter
+    static constexpr uint32_t k_max_payload = 40;
+
+    static auto default_config() -> GDCaptureConfig;
+
+    ~TrafficCapture();
+
+    // Existing files at `path` are rotated out of the way first
+    auto start(const std::string& path, const GDCaptureConfig& config) -> bool;
+    void stop();
+
+    // Safe from any thread; costs one atomic load while capture is off
+    void record(CaptureKind kind, uint64_t address, const void* payload = nullptr, uint32_t size = 0, int16_t rssi = 0)
+    {
+        if (active_.load(std::memory_order_acquire))
+        {
+            push(kind, address, payload, size, rssi);
+        }
+    }
+
+    [[nodiscard]] auto recorded() const -> uint64_t { return recorded_.load(std::memory_order_relaxed); }
+    [[nodiscard]] auto dropped() const -> uint64_t { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry
+    {
+        uint64_t timestamp_ns;
+        uint64_t address;
+        CaptureKind kind;
+        uint8_t flags;
+        int16_t rssi;
+        uint16_t size;
+        uint8_t payload[k_max_payload];
+    };
+
+    void push(CaptureKind kind, uint64_t address, const void* payload, uint32_t size, int16_t rssi);
+    void writer();
+    void append(const Entry& entry);
+    auto open_file() -> bool;
+    void close_file();
+    void rotate_files();
+
+    std::mutex control_mutex_;
+    std::atomic<bool> active_ = false;
+    std::atomic<bool> keep_writing_ = false;
+    std::chrono::steady_clock::time_point origin_;
+    // Allocated by the first start and kept, so a producer that saw active_ can always push
+    std::unique_ptr<MpscRing<Entry>> ring_;
+    std::thread writer_thread_;
+
+    std::atomic<uint64_t> recorded_ = 0;
+    std::atomic<uint64_t> dropped_ = 0;
+
+    // Only touched by the writer thread while it runs
+    std::string path_;
+    GDCaptureConfig config_{};
+    MappedFile file_;
+    size_t position_ = 0;
+    uint32_t file_index_ = 0;
+    uint64_t origin_unix_ns_ = 0;
+    uint64_t reported_dropped_ = 0;
+};
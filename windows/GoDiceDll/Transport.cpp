@@ -0,0 +1,44 @@
+#include "Transport.h"
+
+#include "Log.h"
+
+#if defined(_WIN32)
+#include "WinRtTransport.h"
+#endif
+
+namespace
+{
+    // Where there is no BLE stack to talk to. Discovery stops as soon as it starts and
+    // every operation fails, so the host sees no dice rather than made-up ones.
+    class NoTransport final : public Transport
+    {
+    private:
+        TransportListener* listener_ = nullptr;
+
+    public:
+        void set_listener(TransportListener* listener) override { listener_ = listener; }
+
+        void start_discovery() override
+        {
+            godice::log_error("No Bluetooth transport on this platform; use godice_use_simulated_transport or another transport\n");
+            listener_->on_discovery_stopped();
+        }
+
+        void stop_discovery() override {}
+
+        void connect(uint64_t, TransportCompletion completion) override { completion(false); }
+        void subscribe(uint64_t, TransportCompletion completion) override { completion(false); }
+        void write(uint64_t, const uint8_t*, uint32_t, WriteMode, TransportCompletion completion) override { completion(false); }
+        void disconnect(uint64_t, TransportCompletion completion) override { completion(false); }
+        void reset() override {}
+    };
+}
+
+auto make_platform_transport() -> std::unique_ptr<Transport>
+{
+#if defined(_WIN32)
+    return make_winrt_transport();
+#else
+    return std::make_unique<NoTransport>();
+#endif
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+
+// Events raised by a transport. They may arrive on any thread, and must return quickly.
+class TransportListener
+{
+public:
+    virtual ~TransportListener() = default;
+
+    virtual void on_advertisement(uint64_t address, std::string_view name, int16_t rssi) = 0;
+    virtual void on_discovery_stopped() = 0;
+    virtual void on_notification(uint64_t address, const uint8_t* data, uint32_t size) = 0;
+    // The link dropped without a disconnect() having been requested
+    virtual void on_link_lost(uint64_t address) = 0;
+};
+
+using TransportCompletion = std::function<void(bool success)>;
+
+enum class WriteMode : uint8_t
+{
+    // Completes once the stack has accepted the write, so several can be outstanding
+    WithoutResponse,
+    // Completes when the die acknowledges it
+    WithResponse,
+};
+
+class DeviceCache;
+
+// Everything the framework needs from a BLE stack. Operations are asynchronous;
+// completions may run on any thread, and always run exactly once.
+class Transport
+{
+public:
+    virtual ~Transport() = default;
+
+    // Must be called before discovery starts
+    virtual void set_listener(TransportListener* listener) = 0;
+    // Lets a transport remember discovery results between runs; may be null
+    virtual void set_device_cache(DeviceCache*) {}
+
+    virtual void start_discovery() = 0;
+    virtual void stop_discovery() = 0;
+
+    // Establishes the link and finds the GoDice service and characteristics
+    virtual void connect(uint64_t address, TransportCompletion completion) = 0;
+    // Enables notifications on a connected die
+    virtual void subscribe(uint64_t address, TransportCompletion completion) = 0;
+    // Copies `data` before returning. A die that does not support `mode` is written the other way.
+    virtual void write(uint64_t address, const uint8_t* data, uint32_t size, WriteMode mode, TransportCompletion completion) = 0;
+    virtual void disconnect(uint64_t address, TransportCompletion completion) = 0;
+
+    // Stops discovery and forgets every device
+    virtual void reset() = 0;
+};
+
+// WinRT on Windows. Elsewhere there is none: discovery stops straight away and every
+// operation fails, until the host installs a transport of its own.
+auto make_platform_transport() -> std::unique_ptr<Transport>;
+
+// Replaces the transport the framework talks to, forgetting every known device.
+// Takes effect in order with the godice_* calls made before and after it.
+void install_transport(std::unique_ptr<Transport> transport);
@@ -0,0 +1,112 @@
+#include "WaitableEvent.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+#endif
+
+#if defined(_WIN32)
+
+WaitableEvent::WaitableEvent()
+    : event_(CreateEventW(nullptr, TRUE, FALSE, nullptr))
+{
+}
+
+WaitableEvent::~WaitableEvent()
+{
+    if (event_ != nullptr)
+    {
+        CloseHandle(event_);
+    }
+}
+
+auto WaitableEvent::handle() const -> intptr_t
+{
+    return event_ != nullptr ? reinterpret_cast<intptr_t>(event_) : -1;
+}
+
+void WaitableEvent::set()
+{
+    if (event_ != nullptr)
+    {
+        SetEvent(event_);
+    }
+}
+
+void WaitableEvent::reset()
+{
+    if (event_ != nullptr)
+    {
+        ResetEvent(event_);
+    }
+}
+
+#else
+
+WaitableEvent::WaitableEvent()
+{
+#if defined(__linux__)
+    read_fd_ = write_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#else
+    int fds[2];
+    if (pipe(fds) != 0) return;
+
+    for (const int fd : fds)
+    {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+    read_fd_ = fds[0];
+    write_fd_ = fds[1];
+#endif
+}
+
+WaitableEvent::~WaitableEvent()
+{
+    if (read_fd_ >= 0)
+    {
+        close(read_fd_);
+    }
+    if (write_fd_ >= 0 && write_fd_ != read_fd_)
+    {
+        close(write_fd_);
+    }
+}
+
+auto WaitableEvent::handle() const -> intptr_t
+{
+    return read_fd_;
+}
+
+void WaitableEvent::set()
+{
+    if (write_fd_ < 0) return;
+
+    // Fails harmlessly once the counter or the pipe is already full
+#if defined(__linux__)
+    const uint64_t one = 1;
+    [[maybe_unused]] const auto written = write(write_fd_, &one, sizeof(one));
+#else
+    const char one = 1;
+    [[maybe_unused]] const auto written = write(write_fd_, &one, sizeof(one));
+#endif
+}
+
+void WaitableEvent::reset()
+{
+    if (read_fd_ < 0) return;
+
+    // An eventfd is emptied by a single read; a pipe may hold several bytes
+    uint64_t buffer[8];
+    while (read(read_fd_, buffer, sizeof(buffer)) == static_cast<ssize_t>(sizeof(buffer)))
+    {
+    }
+}
+
+#endif
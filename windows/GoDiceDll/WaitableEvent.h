@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+// A kernel object a host can wait on alongside its own sockets and timers: an eventfd
+// on Linux, a pipe on other POSIX systems and a manual-reset event on Windows. set()
+// and reset() are idempotent and safe from any thread.
+class WaitableEvent
+{
+public:
+    WaitableEvent();
+    ~WaitableEvent();
+
+    WaitableEvent(const WaitableEvent&) = delete;
+    WaitableEvent& operator=(const WaitableEvent&) = delete;
+
+    // The fd or HANDLE to wait on, or -1 if it could not be created
+    [[nodiscard]] auto handle() const -> intptr_t;
+
+    void set();
+    void reset();
+
+private:
+#if defined(_WIN32)
+    void* event_ = nullptr;
+#else
+    int read_fd_ = -1;
+    // The same as read_fd_ for an eventfd
+    int write_fd_ = -1;
+#endif
+};
@@ -0,0 +1,877 @@
+// WinRtTransport.cpp
+//
+
+#include "WinRtTransport.h"
+
+#include "stdafx.h"
+
+#include <condition_variable>
+#include <cstring>
+#include <ppltasks.h>
+#include <shared_mutex>
+
+#include <pplawait.h>
+
+#include "AsyncMutex.h"
+#include "DeviceCache.h"
+#include "FlatAddressMap.h"
+#include "Log.h"
+#include "Trace.h"
+
+#pragma comment(lib, "windowsapp")
+
+using namespace winrt;
+
+using namespace Windows::Devices::Bluetooth;
+using namespace Windows::Devices::Bluetooth::Advertisement;
+using namespace Windows::Devices::Bluetooth::GenericAttributeProfile;
+using namespace Windows::Devices::Enumeration;
+
+using namespace Windows::Storage::Streams;
+
+using Windows::Foundation::IAsyncOperation;
+using Windows::Foundation::IInspectable;
+
+using godice::log_info;
+using godice::log_warning;
+using std::exception;
+using std::function;
+using std::shared_ptr;
+using std::string;
+
+static inline constexpr guid k_service_guid = guid("6e400001-b5a3-f393-e0a9-e50e24dcca9e");
+static inline constexpr guid k_write_guid = guid("6e400002-b5a3-f393-e0a9-e50e24dcca9e");
+static inline constexpr guid k_notify_guid = guid("6e400003-b5a3-f393-e0a9-e50e24dcca9e");
+
+static auto has_property(const GattCharacteristic& characteristic, GattCharacteristicProperties property) -> bool
+{
+    return (characteristic.CharacteristicProperties() & property) == property;
+}
+
+class WinRtTransport;
+
+class DeviceSession : public std::enable_shared_from_this<DeviceSession>
+{
+private:
+    BluetoothLEDevice device_;
+    const uint64_t bluetoothAddress_;
+    const string name_;
+    TransportListener* const listener_;
+    DeviceCache* const cache_;
+    GattDeviceService service_;
+    GattSession gatt_session_;
+    GattCharacteristic write_characteristic_;
+    GattCharacteristic notify_characteristic_;
+    // Which write options write_characteristic_ supports; a write asking for the other gets this one
+    bool write_with_response_ = false;
+    bool write_without_response_ = false;
+    event_token notify_token_;
+    event_token connection_status_changed_token_;
+
+    // Serialises GATT operations on this die only; other dice connect in parallel
+    AsyncMutex lock_;
+    bool connected_ = false;
+
+    IAsyncOperation<bool> lockedDisconnect()
+    {
+        NamedLog("Attempting to disconnect\n");
+        connected_ = false;
+
+        if (notify_characteristic_ != nullptr)
+        {
+            try
+            {
+                co_await notify_characteristic_.WriteClientCharacteristicConfigurationDescriptorAsync(GattClientCharacteristicConfigurationDescriptorValue::None);
+                notify_characteristic_.ValueChanged(std::exchange(notify_token_, {}));
+            }
+            catch (winrt::hresult_error& e)
+            {
+                NamedWarning("Failed to disconnect notify characteristic {}\n", e.code().value);
+            }
+            notify_characteristic_ = nullptr;
+        }
+        write_characteristic_ = nullptr;
+
+        if (service_ != nullptr)
+        {
+            service_.Close();
+            service_ = nullptr;
+        }
+        if (device_ != nullptr)
+        {
+            device_.ConnectionStatusChanged(std::exchange(connection_status_changed_token_, {}));
+        }
+
+        co_return true;
+    }
+
+    static string GDSRErrorString(const GattDeviceServicesResult& result)
+    {
+        switch (result.Status())
+        {
+        case GattCommunicationStatus::Success:
+            return "success";
+        case GattCommunicationStatus::Unreachable:
+            return "unreachable";
+        case GattCommunicationStatus::ProtocolError:
+            return "protocol error: " + std::to_string(result.ProtocolError().Value());
+        case GattCommunicationStatus::AccessDenied:
+            return "access denied";
+        default:
+            return "unknown status";
+        }
+    }
+
+    static string GCRErrorString(const GattCharacteristicsResult& result)
+    {
+        switch (result.Status())
+        {
+        case GattCommunicationStatus::Success:
+            return "success";
+        case GattCommunicationStatus::Unreachable:
+            return "unreachable";
+        case GattCommunicationStatus::ProtocolError:
+            return "protocol error: " + std::to_string(result.ProtocolError().Value());
+        case GattCommunicationStatus::AccessDenied:
+            return "access denied";
+        default:
+            return "unknown status";
+        }
+    }
+
+    template <typename ...P>
+    void NamedLog(const char* format, const P&... args)
+    {
+        godice::log_tagged<godice::LogLevel::Debug>(name_, format, args...);
+    }
+
+    template <typename ...P>
+    void NamedWarning(const char* format, const P&... args)
+    {
+        godice::log_tagged<godice::LogLevel::Warning>(name_, format, args...);
+    }
+
+    // Accepts a write characteristic that takes either kind of write, since a die that
+    // cannot write without response still works one write at a time
+    auto acceptWriteCharacteristic() -> bool
+    {
+        write_with_response_ = has_property(write_characteristic_, GattCharacteristicProperties::Write);
+        write_without_response_ = has_property(write_characteristic_, GattCharacteristicProperties::WriteWithoutResponse);
+        if (!write_without_response_ && write_with_response_)
+        {
+            NamedLog("Write characteristic has no WriteWithoutResponse property, writing with response\n");
+        }
+        return write_with_response_ || write_without_response_;
+    }
+
+    void forgetService()
+    {
+        notify_characteristic_ = nullptr;
+        write_characteristic_ = nullptr;
+        if (service_ != nullptr)
+        {
+            service_.Close();
+            service_ = nullptr;
+        }
+    }
+
+    // Reopens the service recorded by an earlier connection, with one cached
+    // characteristics lookup instead of a services query and two lookups by UUID
+    IAsyncOperation<bool> lockedOpenCachedService()
+    {
+        CachedDevice cached;
+        if (cache_ == nullptr || !cache_->find(bluetoothAddress_, cached) || cached.service_id[0] == '\0')
+        {
+            co_return false;
+        }
+
+        TraceSpan span("cached service", bluetoothAddress_);
+        try
+        {
+            NamedLog("Opening cached service\n");
+            const string service_id(cached.service_id, strnlen(cached.service_id, sizeof(cached.service_id)));
+            service_ = co_await GattDeviceService::FromIdAsync(to_hstring(service_id));
+            if (service_ != nullptr && co_await service_.RequestAccessAsync() == DeviceAccessStatus::Allowed)
+            {
+                const auto result = co_await service_.GetCharacteristicsAsync(BluetoothCacheMode::Cached);
+                if (result.Status() == GattCommunicationStatus::Success)
+                {
+                    for (const auto& characteristic : result.Characteristics())
+                    {
+                        if (characteristic.Uuid() == k_notify_guid)
+                        {
+                            notify_characteristic_ = characteristic;
+                        }
+                        else if (characteristic.Uuid() == k_write_guid)
+                        {
+                            write_characteristic_ = characteristic;
+                        }
+                    }
+                }
+            }
+
+            if (notify_characteristic_ != nullptr && write_characteristic_ != nullptr &&
+                has_property(notify_characteristic_, GattCharacteristicProperties::Notify) && acceptWriteCharacteristic())
+            {
+                co_return true;
+            }
+        }
+        catch (winrt::hresult_error& e)
+        {
+            NamedWarning("Caught exception code {} while opening cached service\n", e.code().value);
+        }
+
+        NamedWarning("Cached service unusable, rediscovering\n");
+        forgetService();
+        co_return false;
+    }
+
+    IAsyncOperation<bool> lockedDiscoverService()
+    {
+        TraceSpan span("discover service", bluetoothAddress_);
+
+        NamedLog("Getting services\n");
+        TraceSpan services_span("services", bluetoothAddress_);
+        const auto servicesResult = co_await device_.GetGattServicesForUuidAsync(k_service_guid, BluetoothCacheMode::Cached);
+        services_span.end();
+        if (servicesResult.Status() != GattCommunicationStatus::Success)
+        {
+            auto errString = GDSRErrorString(servicesResult);
+            NamedWarning("Failed to get services, error `{}`\n", errString);
+
+            co_return false;
+        }
+        const auto services = servicesResult.Services();
+        if (services.Size() < 1)
+        {
+            NamedWarning("Failed to get services\n");
+
+            co_return false;
+        }
+        service_ = services.GetAt(0);
+
+        NamedLog("Requesting access\n");
+        TraceSpan access_span("access", bluetoothAddress_);
+        const auto accessStatus = co_await service_.RequestAccessAsync();
+        access_span.end();
+        if (accessStatus != DeviceAccessStatus::Allowed)
+        {
+            NamedWarning("Failed to get access to service for {}\n", name_);
+
+            co_return false;
+        }
+
+        NamedLog("Getting notify characteristic\n");
+        TraceSpan notify_span("notify characteristic", bluetoothAddress_);
+        const auto notifChsResponse = co_await service_.GetCharacteristicsForUuidAsync(k_notify_guid, BluetoothCacheMode::Cached);
+        notify_span.end();
+        if (notifChsResponse.Status() != GattCommunicationStatus::Success)
+        {
+            auto errString = GCRErrorString(notifChsResponse);
+            NamedWarning("Got a failure response from GetCharacteristicsForUuidAsync for notify characteristic with err `{}`\n", errString);
+
+            co_return false;
+        }
+        auto notifChs = notifChsResponse.Characteristics();
+        if (notifChs.Size() < 1)
+        {
+            NamedWarning("Did not find any notification characteristics\n");
+
+            co_return false;
+        }
+        notify_characteristic_ = notifChs.GetAt(0);
+
+        if (!has_property(notify_characteristic_, GattCharacteristicProperties::Notify))
+        {
+            NamedWarning("Did not find characteristic with expected Notify property\n");
+
+            co_return false;
+        }
+
+        NamedLog("Getting write characteristic\n");
+        TraceSpan write_span("write characteristic", bluetoothAddress_);
+        const auto wrChsResult = co_await service_.GetCharacteristicsForUuidAsync(k_write_guid, BluetoothCacheMode::Cached);
+        write_span.end();
+        if (wrChsResult.Status() != GattCommunicationStatus::Success)
+        {
+            auto errString = GCRErrorString(wrChsResult);
+            NamedWarning("Got a failure response from GetCharacteristicsForUuidAsync for write characteristic with err `{}`\n", errString);
+
+            co_return false;
+        }
+        const auto wrChs = wrChsResult.Characteristics();
+        if (wrChs.Size() < 1)
+        {
+            NamedWarning("Did not find any write characteristics\n");
+
+            co_return false;
+        }
+        write_characteristic_ = wrChs.GetAt(0);
+
+        if (!acceptWriteCharacteristic())
+        {
+            NamedWarning("Did not find characteristic with expected Write or WriteWithoutResponse property\n");
+
+            co_return false;
+        }
+
+        co_return true;
+    }
+
+    void rememberService()
+    {
+        if (cache_ == nullptr) return;
+
+        const string service_id = to_string(service_.DeviceId());
+        cache_->update(bluetoothAddress_, [&service_id](CachedDevice& device)
+        {
+            // A truncated id would be useless; leave it empty and rediscover next time
+            DeviceCache::copy_string(device.service_id, service_id.size() < sizeof(device.service_id) ? service_id : string());
+        });
+    }
+
+    IAsyncOperation<bool> lockedConnect()
+    {
+        try
+        {
+            connected_ = false;
+
+            NamedLog("Getting session");
+            TraceSpan session_span("GATT session", bluetoothAddress_);
+            gatt_session_ = co_await GattSession::FromDeviceIdAsync(device_.BluetoothDeviceId());
+            session_span.end();
+            if (gatt_session_ == nullptr)
+            {
+                NamedWarning("Failed to get session\n");
+
+                co_return false;
+            }
+            else
+            {
+                gatt_session_.SessionStatusChanged([this](const GattSession& session, const GattSessionStatusChangedEventArgs& args)
+                {
+                    NamedLog("Session status changed to {}, error was {}\n", int(args.Status()), int(args.Error()));
+                });
+                gatt_session_.MaintainConnection(true);
+            }
+
+            bool found = co_await lockedOpenCachedService();
+            if (!found)
+            {
+                found = co_await lockedDiscoverService();
+            }
+            if (!found)
+            {
+                co_return false;
+            }
+
+            NamedLog("Setting status changed handler\n");
+            connection_status_changed_token_ = device_.ConnectionStatusChanged([this](auto&& dev, auto&& args)
+            {
+                if (dev.ConnectionStatus() == BluetoothConnectionStatus::Disconnected)
+                {
+                    listener_->on_link_lost(bluetoothAddress_);
+                }
+            });
+
+            connected_ = device_.ConnectionStatus() == BluetoothConnectionStatus::Connected;
+            if (connected_)
+            {
+                rememberService();
+            }
+
+            NamedLog("Connection status is {}\n", connected_);
+            co_return connected_;
+        }
+        catch (std::exception& e)
+        {
+            NamedWarning("Caught exception while connecting {}\n", e.what());
+
+            co_return false;
+        }
+        catch (winrt::hresult_error& e)
+        {
+            NamedWarning("Caught exception code {} while connecting\n", e.code().value);
+
+            co_return false;
+        }
+        catch (...)
+        {
+            auto e = std::current_exception();
+            NamedWarning("Caught exception while connecting\n");
+
+            co_return false;
+        }
+    }
+
+    IAsyncOperation<bool> lockedSubscribe()
+    {
+        if (!connected_ || notify_characteristic_ == nullptr)
+        {
+            NamedWarning("Attempting to subscribe while not connected\n");
+            co_return false;
+        }
+
+        try
+        {
+            NamedLog("Setting value changed handler\n");
+            notify_token_ = notify_characteristic_.ValueChanged([this](auto&& ch, auto&& args)
+            {
+                notify_characteristic_value_changed(args);
+            });
+
+            NamedLog("Writing configuration\n");
+            TraceSpan span("CCCD write", bluetoothAddress_);
+            auto configResult = co_await notify_characteristic_
+                                .WriteClientCharacteristicConfigurationDescriptorAsync(
+                                    GattClientCharacteristicConfigurationDescriptorValue::Notify);
+            if (configResult != GattCommunicationStatus::Success)
+            {
+                NamedWarning("Failed to get set notification config with result {}\n", int(configResult));
+
+                co_return false;
+            }
+
+            co_return true;
+        }
+        catch (winrt::hresult_error& e)
+        {
+            NamedWarning("Caught exception code {} while subscribing\n", e.code().value);
+        }
+        catch (...)
+        {
+            NamedWarning("Caught exception while subscribing\n");
+        }
+
+        co_return false;
+    }
+
+    IAsyncOperation<bool> lockedSend(IBuffer msg, GattWriteOption option)
+    {
+        if (!connected_)
+        {
+            NamedWarning("Attempting to write while not connected");
+            co_return false;
+        }
+
+        if (write_characteristic_ == nullptr)
+        {
+            NamedWarning("No write characteristic found for\n");
+            co_return false;
+        }
+
+        if (option == GattWriteOption::WriteWithoutResponse && !write_without_response_)
+        {
+            option = GattWriteOption::WriteWithResponse;
+        }
+        else if (option == GattWriteOption::WriteWithResponse && !write_with_response_)
+        {
+            option = GattWriteOption::WriteWithoutResponse;
+        }
+
+        try
+        {
+            auto status = co_await write_characteristic_.WriteValueAsync(msg, option);
+            if (status != GattCommunicationStatus::Success)
+            {
+                NamedWarning("Write data failed with status {}\n", (int)status);
+                co_return false;
+            }
+
+            co_return true;
+        }
+        catch (std::exception& e)
+        {
+            NamedWarning("Caught exception while writing! {}\n", e.what());
+        }
+        catch (winrt::hresult_error& e)
+        {
+            NamedWarning("Caught exception while writing! {}\n", to_string(e.message()));
+        }
+        catch (...)
+        {
+            auto e = std::current_exception();
+            NamedWarning("Caught exception while writing!\n");
+        }
+
+        co_return false;
+    }
+
+public:
+    static Concurrency::task<shared_ptr<DeviceSession>> MakeSession(uint64_t bluetoothAddr, TransportListener* listener, DeviceCache* cache)
+    {
+        return Concurrency::create_task([bluetoothAddr, listener, cache]
+        {
+            try
+            {
+                auto device = BluetoothLEDevice::FromBluetoothAddressAsync(bluetoothAddr).get();
+
+                return std::make_shared<DeviceSession>(device, bluetoothAddr, listener, cache);
+            }
+            catch (std::exception& e)
+            {
+                log_warning("Caught exception while creating session {}\n", e.what());
+            }
+            catch (winrt::hresult_error& e)
+            {
+                log_warning("Caught exception while creating session {}\n", to_string(e.message()));
+            }
+            catch (...)
+            {
+                auto e = std::current_exception();
+                log_warning("Caught exception while creating new session\n");
+            }
+
+            return shared_ptr<DeviceSession>(nullptr);
+        });
+    }
+
+    DeviceSession(const BluetoothLEDevice& dev, const uint64_t btAddr, TransportListener* listener, DeviceCache* cache)
+        : device_(dev), bluetoothAddress_(btAddr), name_(to_string(dev.Name())), listener_(listener), cache_(cache), service_(nullptr),
+          gatt_session_(nullptr), write_characteristic_(nullptr), notify_characteristic_(nullptr)
+    {
+    }
+
+    void notify_characteristic_value_changed(const GattValueChangedEventArgs& args) const
+    {
+        const IBuffer& data = args.CharacteristicValue();
+        listener_->on_notification(bluetoothAddress_, data.data(), data.Length());
+    }
+
+    IAsyncOperation<bool> Connect()
+    {
+        bool success = false;
+
+        TraceSpan lock_span("session lock", bluetoothAddress_);
+        co_await lock_.lock();
+        lock_span.end();
+        if (device_.ConnectionStatus() == BluetoothConnectionStatus::Disconnected && notify_characteristic_ != nullptr)
+        {
+            co_await lockedDisconnect();
+        }
+
+        if (connected_)
+        {
+            NamedLog("Already connected\n");
+            success = true;
+        }
+        else
+        {
+            if (bool result = co_await lockedConnect())
+            {
+                success = true;
+            }
+            else
+            {
+                co_await lockedDisconnect();
+            }
+        }
+        lock_.unlock();
+
+        co_return success;
+    }
+
+    IAsyncOperation<bool> Subscribe()
+    {
+        co_await lock_.lock();
+        auto result = co_await lockedSubscribe();
+        lock_.unlock();
+
+        co_return result;
+    }
+
+    // Takes the buffer by value: the caller's copy is gone once this suspends
+    IAsyncOperation<bool> send(IBuffer msg, GattWriteOption option)
+    {
+        co_await lock_.lock();
+        NamedLog("Attempting to write {} bytes\n", msg.Length());
+        auto result = co_await lockedSend(msg, option);
+
+        lock_.unlock();
+
+        co_return result;
+    }
+
+    IAsyncOperation<bool> disconnect()
+    {
+        co_await lock_.lock();
+
+        bool result = false;
+        try
+        {
+            result = co_await lockedDisconnect();
+        }
+        catch (winrt::hresult_error& e)
+        {
+            NamedWarning("Caught exception while disconnecting {}\n", e.code().value);
+        }
+        lock_.unlock();
+
+        co_return result;
+    }
+
+    const string& DeviceName() const { return name_; }
+
+    // Operations hold a reference to the session, so none can be in flight here
+    ~DeviceSession()
+    {
+        lockedDisconnect();
+
+        device_.Close();
+        device_ = nullptr;
+    }
+};
+
+// Keeps the session alive until the operation finishes, then reports the result
+static fire_and_forget complete_when_done(shared_ptr<DeviceSession> session, IAsyncOperation<bool> operation,
+                                          TransportCompletion completion)
+{
+    bool result = false;
+    try
+    {
+        result = co_await operation;
+    }
+    catch (...)
+    {
+        log_warning("Caught exception in transport operation\n");
+    }
+    completion(result);
+}
+
+class WinRtTransport final : public Transport
+{
+private:
+    BluetoothLEAdvertisementWatcher watcher_ = nullptr;
+    TransportListener* listener_ = nullptr;
+    DeviceCache* cache_ = nullptr;
+
+    // A null session marks one that is still being created
+    std::shared_mutex mutex_;
+    FlatAddressMap<shared_ptr<DeviceSession>> sessions_;
+    size_t sessions_in_progress_ = 0;
+    std::condition_variable_any sessions_done_;
+
+    // Declared first in a session's continuation, so the session stops counting as in
+    // progress only once the continuation is done with the transport, and reset() cannot
+    // let it be destroyed under it
+    class SessionInProgress
+    {
+    private:
+        WinRtTransport& transport_;
+
+    public:
+        explicit SessionInProgress(WinRtTransport& transport) : transport_(transport) {}
+
+        SessionInProgress(const SessionInProgress&) = delete;
+        SessionInProgress& operator=(const SessionInProgress&) = delete;
+
+        ~SessionInProgress()
+        {
+            // Notified under the lock: once it is released, the transport may be gone
+            std::unique_lock lk(transport_.mutex_);
+            if (--transport_.sessions_in_progress_ == 0)
+            {
+                transport_.sessions_done_.notify_all();
+            }
+        }
+    };
+
+    auto find_session(uint64_t address) -> shared_ptr<DeviceSession>
+    {
+        std::shared_lock lk(mutex_);
+        const auto* session = sessions_.find(address);
+        return session != nullptr ? *session : nullptr;
+    }
+
+    // Stores a newly created session unless another one got there first, and returns
+    // whichever is now current. Call with mutex_ held exclusively.
+    auto adopt_session_locked(uint64_t address, const shared_ptr<DeviceSession>& created) -> shared_ptr<DeviceSession>
+    {
+        shared_ptr<DeviceSession>* stored = sessions_.find(address);
+        if (created == nullptr)
+        {
+            if (stored != nullptr && *stored == nullptr)
+            {
+                sessions_.erase(address);
+            }
+            return stored != nullptr ? *stored : nullptr;
+        }
+
+        if (stored == nullptr)
+        {
+            return *sessions_.insert_or_assign(address, created);
+        }
+        if (*stored == nullptr)
+        {
+            *stored = created;
+        }
+        return *stored;
+    }
+
+    void received_device_found_event(const BluetoothLEAdvertisementReceivedEventArgs& args)
+    {
+        const uint64_t btAddr = args.BluetoothAddress();
+        const int16_t rssi = args.RawSignalStrengthInDBm();
+
+        if (const shared_ptr<DeviceSession> session = find_session(btAddr))
+        {
+            listener_->on_advertisement(btAddr, session->DeviceName(), rssi);
+            return;
+        }
+
+        {
+            std::unique_lock lk(mutex_);
+            if (!sessions_.try_emplace(btAddr, nullptr).second) return;
+            sessions_in_progress_++;
+        }
+
+        DeviceSession::MakeSession(btAddr, listener_, cache_).then([this, btAddr, rssi](shared_ptr<DeviceSession> created)
+        {
+            const SessionInProgress in_progress(*this);
+            {
+                std::unique_lock lk(mutex_);
+                created = adopt_session_locked(btAddr, created);
+            }
+
+            if (created != nullptr)
+            {
+                listener_->on_advertisement(btAddr, created->DeviceName(), rssi);
+            }
+            else
+            {
+                log_warning("Failed to create new session\n");
+            }
+        });
+    }
+
+public:
+    ~WinRtTransport() override
+    {
+        reset();
+    }
+
+    void set_listener(TransportListener* listener) override
+    {
+        listener_ = listener;
+    }
+
+    void set_device_cache(DeviceCache* cache) override
+    {
+        cache_ = cache;
+    }
+
+    void start_discovery() override
+    {
+        if (watcher_ == nullptr)
+        {
+            watcher_ = BluetoothLEAdvertisementWatcher();
+            watcher_.ScanningMode(BluetoothLEScanningMode::Active);
+            watcher_.AdvertisementFilter().Advertisement().ServiceUuids().Append(k_service_guid);
+
+            watcher_.Received([this](auto&&, const BluetoothLEAdvertisementReceivedEventArgs& args)
+            {
+                received_device_found_event(args);
+            });
+
+            watcher_.Stopped([this](auto&&, auto&&)
+            {
+                log_info("Watcher Stopped\n");
+                listener_->on_discovery_stopped();
+            });
+        }
+
+        watcher_.Start();
+    }
+
+    void stop_discovery() override
+    {
+        if (watcher_ != nullptr)
+        {
+            watcher_.Stop();
+        }
+    }
+
+    void connect(uint64_t address, TransportCompletion completion) override
+    {
+        if (auto session = find_session(address))
+        {
+            complete_when_done(session, session->Connect(), std::move(completion));
+            return;
+        }
+
+        // A die remembered from an earlier run can be connected before it has advertised
+        {
+            std::unique_lock lk(mutex_);
+            sessions_in_progress_++;
+        }
+        DeviceSession::MakeSession(address, listener_, cache_).then([this, address, completion](shared_ptr<DeviceSession> created)
+        {
+            const SessionInProgress in_progress(*this);
+            {
+                std::unique_lock lk(mutex_);
+                created = adopt_session_locked(address, created);
+            }
+
+            if (created == nullptr)
+            {
+                log_warning("No session for {}\n", address);
+                completion(false);
+                return;
+            }
+            complete_when_done(created, created->Connect(), completion);
+        });
+    }
+
+    void subscribe(uint64_t address, TransportCompletion completion) override
+    {
+        auto session = find_session(address);
+        if (session == nullptr)
+        {
+            completion(false);
+            return;
+        }
+        complete_when_done(session, session->Subscribe(), std::move(completion));
+    }
+
+    void write(uint64_t address, const uint8_t* data, uint32_t size, WriteMode mode, TransportCompletion completion) override
+    {
+        auto session = find_session(address);
+        if (session == nullptr)
+        {
+            log_warning("No session found for {}\n", address);
+            completion(false);
+            return;
+        }
+
+        const DataWriter writer;
+        writer.WriteBytes(winrt::array_view(data, data + size));
+
+        const auto option = mode == WriteMode::WithResponse ? GattWriteOption::WriteWithResponse : GattWriteOption::WriteWithoutResponse;
+        complete_when_done(session, session->send(writer.DetachBuffer(), option), std::move(completion));
+    }
+
+    void disconnect(uint64_t address, TransportCompletion completion) override
+    {
+        auto session = find_session(address);
+        if (session == nullptr)
+        {
+            completion(false);
+            return;
+        }
+        complete_when_done(session, session->disconnect(), std::move(completion));
+    }
+
+    void reset() override
+    {
+        stop_discovery();
+
+        std::unique_lock lk(mutex_);
+        sessions_done_.wait(lk, [this] { return sessions_in_progress_ == 0; });
+        sessions_.clear();
+    }
+};
+
+auto make_winrt_transport() -> std::unique_ptr<Transport>
+{
+    return std::make_unique<WinRtTransport>();
+}
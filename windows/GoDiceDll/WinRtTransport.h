@@ -0,0 +1,8 @@
+#pragma once
+
+#include <memory>
+
+#include "Transport.h"
+
+// BLE through Windows.Devices.Bluetooth. Only built on Windows.
+auto make_winrt_transport() -> std::unique_ptr<Transport>;
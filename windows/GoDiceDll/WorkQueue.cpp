@@ -1,6 +1,66 @@
 ﻿#include "WorkQueue.h"
 
+#include "Trace.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define WORK_QUEUE_CPU_RELAX() _mm_pause()
+#elif defined(__x86_64__) || defined(__i386__)
+#define WORK_QUEUE_CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define WORK_QUEUE_CPU_RELAX() asm volatile("yield")
+#else
+#define WORK_QUEUE_CPU_RELAX() ((void)0)
+#endif
+
+WorkQueue::WorkQueue(const std::string& nm, WorkQueueBackend backend, size_t capacity)
+    : name_(nm), backend_(backend), spin_iterations_(std::thread::hardware_concurrency() > 1 ? k_spin_iterations : 0)
+{
+    if (backend_ == WorkQueueBackend::LockFree)
+    {
+        ring_ = std::make_unique<MpscRing<Task>>(capacity);
+    }
+    runner_thread_ = std::thread(&WorkQueue::runner, this);
+}
+
 void WorkQueue::runner()
+{
+    godice::trace::name_thread(name_);
+
+    if (backend_ == WorkQueueBackend::LockFree)
+    {
+        lock_free_runner();
+    }
+    else
+    {
+        locked_runner();
+    }
+}
+
+void WorkQueue::run(Task& task)
+{
+    if (task.enqueued == Clock::time_point{})
+    {
+        task.work();
+    }
+    else
+    {
+        const auto started = Clock::now();
+        wait_.record(started - task.enqueued);
+        task.work();
+        const auto finished = Clock::now();
+        run_.record(finished - started);
+
+        if (godice::trace::enabled())
+        {
+            godice::trace::complete(name_.c_str(), godice::trace::k_thread_track, started, finished, "wait_ns",
+                                    std::chrono::duration_cast<std::chrono::nanoseconds>(started - task.enqueued).count());
+        }
+    }
+    executed_.add();
+}
+
+void WorkQueue::locked_runner()
 {
     while (keep_running_)
     {
@@ -8,7 +68,7 @@ void WorkQueue::runner()
 
         do
         {
-            WorkItem work_item = nullptr;
+            Task task;
             {
                 std::unique_lock lk(mutex_);
                 if (!keep_running_) return;
@@ -18,37 +78,135 @@ void WorkQueue::runner()
                 }
                 else
                 {
-                    work_item = work_queue_.front();
+                    task = std::move(work_queue_.front());
                     work_queue_.pop();
                 }
             }
 
-            if (work_item != nullptr)
+            if (task.work != nullptr)
             {
-                work_item();
+                run(task);
                 did_work = true;
             }
         } while (did_work && keep_running_);
     }
 }
 
+void WorkQueue::lock_free_runner()
+{
+    Task task;
+    int idle_spins = 0;
+
+    while (keep_running_.load(std::memory_order_relaxed))
+    {
+        if (ring_->try_pop(task))
+        {
+            run(task);
+            task.work = nullptr;
+            idle_spins = 0;
+            continue;
+        }
+
+        if (idle_spins < spin_iterations_)
+        {
+            idle_spins++;
+            WORK_QUEUE_CPU_RELAX();
+            continue;
+        }
+
+        // Park. Publishing runner_parked_ and then re-checking the ring (with a full fence on both
+        // sides) guarantees a producer either sees us parked or we see its item.
+        const uint32_t key = wake_sequence_.load(std::memory_order_acquire);
+        runner_parked_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (ring_->size() == 0 && keep_running_.load(std::memory_order_relaxed))
+        {
+            wake_sequence_.wait(key, std::memory_order_acquire);
+        }
+        runner_parked_.store(false, std::memory_order_relaxed);
+        idle_spins = 0;
+    }
+}
+
+void WorkQueue::wake_runner()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // Only the producer that observes the park pays for the notify; the rest stay syscall-free
+    if (runner_parked_.load(std::memory_order_relaxed) && runner_parked_.exchange(false, std::memory_order_relaxed))
+    {
+        wake_sequence_.fetch_add(1, std::memory_order_release);
+        wake_sequence_.notify_one();
+    }
+}
+
 void WorkQueue::enqueue(const WorkItem& item)
 {
+    enqueue(WorkItem(item));
+}
+
+void WorkQueue::enqueue(WorkItem&& item)
+{
+    // Reading the clock twice for every item would cost as much as the queue itself; tracing times them all
+    thread_local uint32_t untimed = 0;
+    const bool timed = ++untimed % k_timing_interval == 0 || godice::trace::enabled();
+    Task task{ std::move(item), timed ? Clock::now() : Clock::time_point{} };
+    enqueued_.add();
+
+    if (backend_ == WorkQueueBackend::LockFree)
+    {
+        // Full ring: the runner is behind, so yield to it rather than growing without bound
+        while (!ring_->try_push(std::move(task)))
+        {
+            if (!keep_running_.load(std::memory_order_relaxed)) return;
+            wake_runner();
+            std::this_thread::yield();
+        }
+        wake_runner();
+        return;
+    }
+
     std::unique_lock lk(mutex_);
-    work_queue_.push(item);
+    work_queue_.push(std::move(task));
     condition_.notify_one();
 }
 
 void WorkQueue::stop()
 {
+    if (backend_ == WorkQueueBackend::LockFree)
+    {
+        keep_running_ = false;
+        wake_sequence_.fetch_add(1, std::memory_order_release);
+        wake_sequence_.notify_one();
+        return;
+    }
+
     std::unique_lock lk(mutex_);
-    std::queue<WorkItem>().swap(work_queue_);
+    std::queue<Task>().swap(work_queue_);
     keep_running_ = false;
     condition_.notify_one();
 }
 
+void WorkQueue::snapshot(GDQueueStats& stats) const
+{
+    // Executed first, so while both are moving the depth errs high rather than below zero
+    stats.executed = executed_.load();
+    stats.enqueued = enqueued_.load();
+    stats.depth = stats.enqueued > stats.executed ? stats.enqueued - stats.executed : 0;
+    wait_.snapshot(stats.wait);
+    run_.snapshot(stats.run);
+}
+
 WorkQueue::~WorkQueue()
 {
     stop();
     runner_thread_.join();
+
+    if (ring_ != nullptr)
+    {
+        Task dropped;
+        while (ring_->try_pop(dropped))
+        {
+        }
+    }
 }
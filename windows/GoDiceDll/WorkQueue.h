@@ -1,32 +1,90 @@
 ﻿#pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <queue>
+#include <string>
 #include <thread>
 
+#include "GoDiceDll.h"
+#include "MpscRing.h"
+#include "Stats.h"
+
 using WorkItem = std::function<void()>;
 
+enum class WorkQueueBackend
+{
+    // std::queue guarded by a mutex, woken through a condition variable per item
+    Locked,
+    // bounded MPSC ring; the runner spins briefly before parking, producers only wake a parked runner
+    LockFree,
+};
+
 class WorkQueue
 {
 private:
+    static constexpr size_t k_default_capacity = 4096;
+    static constexpr int k_spin_iterations = 2000;
+    // Each producer thread times one item in this many, for the wait and run histograms,
+    // unless tracing is on
+    static constexpr uint32_t k_timing_interval = 16;
+
     const std::string name_;
+    const WorkQueueBackend backend_;
+    // Spinning only pays off if a producer can run concurrently with the runner
+    const int spin_iterations_;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Task
+    {
+        WorkItem work;
+        // Zero unless the item is timed
+        Clock::time_point enqueued;
+    };
+
     void runner();
-    std::thread runner_thread_;
+    void run(Task& task);
+    void locked_runner();
+    void lock_free_runner();
+    void wake_runner();
 
-    std::queue<WorkItem> work_queue_;
+    std::queue<Task> work_queue_;
     std::mutex mutex_;
     std::condition_variable condition_;
 
-    bool keep_running_ = true;
+    std::unique_ptr<MpscRing<Task>> ring_;
+    std::atomic<bool> runner_parked_ = false;
+    std::atomic<uint32_t> wake_sequence_ = 0;
+
+    std::atomic<bool> keep_running_ = true;
+
+    StatCounter enqueued_;
+    StatCounter executed_;
+    LatencyHistogram wait_;
+    LatencyHistogram run_;
+
+    // Declared last so everything above is constructed before the runner starts
+    std::thread runner_thread_;
     
 public:
-    explicit WorkQueue(const std::string& nm) : name_(nm), runner_thread_(&WorkQueue::runner, this) {}
+    explicit WorkQueue(const std::string& nm,
+                       WorkQueueBackend backend = WorkQueueBackend::Locked,
+                       size_t capacity = k_default_capacity);
     ~WorkQueue();
 
     void enqueue(const WorkItem& item);
+    void enqueue(WorkItem&& item);
 
     void stop();
 
+    // Safe from any thread
+    void snapshot(GDQueueStats& stats) const;
+
     [[nodiscard]] auto name() const -> std::string { return name_; }
+    [[nodiscard]] auto backend() const -> WorkQueueBackend { return backend_; }
 };
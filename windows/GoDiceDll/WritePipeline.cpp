@@ -0,0 +1,149 @@
+#include "WritePipeline.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "GoDiceProtocol.h"
+
+static auto command_class(const WritePayload& payload) -> uint8_t
+{
+    return godice::protocol::command_class(payload->data(), static_cast<uint32_t>(payload->size()));
+}
+
+WritePipeline::WritePipeline(Sender sender) : sender_(std::move(sender))
+{
+}
+
+void WritePipeline::configure(WriteMode mode, uint32_t max_in_flight)
+{
+    mode_ = mode;
+    max_in_flight_ = std::max(max_in_flight, 1u);
+
+    std::vector<uint64_t> addresses;
+    outbound_.for_each([&addresses](uint64_t address, const Outbound&)
+    {
+        addresses.push_back(address);
+    });
+    for (const uint64_t address : addresses)
+    {
+        start_waiting(address);
+    }
+}
+
+void WritePipeline::submit(uint64_t address, WritePayload payload, std::shared_ptr<WriteBatch> batch, uint32_t index)
+{
+    Outbound* outbound = outbound_.try_emplace(address, Outbound{}).first;
+    if (outbound == nullptr || payload == nullptr)
+    {
+        resolve(batch, index, false);
+        return;
+    }
+
+    Command command{ std::move(payload), std::move(batch), index };
+
+    if (const uint8_t kind = command_class(command.payload); kind != 0)
+    {
+        for (auto& waiting : outbound->waiting)
+        {
+            if (command_class(waiting.payload) == kind)
+            {
+                std::swap(waiting, command);
+                coalesced_.add();
+                resolve(command.batch, command.index, false);
+                return;
+            }
+        }
+    }
+
+    outbound->waiting.push_back(std::move(command));
+    start_waiting(address);
+}
+
+void WritePipeline::completed(uint64_t address, uint64_t id, bool success)
+{
+    Outbound* outbound = outbound_.find(address);
+    if (outbound == nullptr) return;
+
+    auto& in_flight = outbound->in_flight;
+    const auto it = std::find_if(in_flight.begin(), in_flight.end(), [id](const Command& command) { return command.id == id; });
+    if (it == in_flight.end()) return;
+
+    const Command command = std::move(*it);
+    in_flight.erase(it);
+    if (!success)
+    {
+        failed_.add();
+    }
+
+    resolve(command.batch, command.index, success);
+    start_waiting(address);
+}
+
+void WritePipeline::forget(uint64_t address)
+{
+    if (Outbound* outbound = outbound_.find(address))
+    {
+        drop(*outbound);
+        outbound_.erase(address);
+    }
+}
+
+void WritePipeline::clear()
+{
+    std::vector<uint64_t> addresses;
+    outbound_.for_each([&addresses](uint64_t address, const Outbound&)
+    {
+        addresses.push_back(address);
+    });
+    for (const uint64_t address : addresses)
+    {
+        forget(address);
+    }
+}
+
+void WritePipeline::resolve(const std::shared_ptr<WriteBatch>& batch, uint32_t index, bool delivered)
+{
+    if (batch == nullptr) return;
+
+    batch->delivered[index] = delivered;
+    if (--batch->remaining == 0 && batch->done)
+    {
+        batch->done(batch);
+    }
+}
+
+void WritePipeline::drop(Outbound& outbound)
+{
+    for (const auto& command : outbound.in_flight)
+    {
+        resolve(command.batch, command.index, false);
+    }
+    for (const auto& command : outbound.waiting)
+    {
+        resolve(command.batch, command.index, false);
+    }
+    outbound.in_flight.clear();
+    outbound.waiting.clear();
+}
+
+void WritePipeline::start_waiting(uint64_t address)
+{
+    const uint32_t limit = mode_ == WriteMode::WithResponse ? 1 : max_in_flight_;
+
+    // Looked up again each time round: the sender may complete, or forget the die, re-entrantly
+    for (;;)
+    {
+        Outbound* outbound = outbound_.find(address);
+        if (outbound == nullptr || outbound->in_flight.size() >= limit || outbound->waiting.empty()) return;
+
+        Command command = std::move(outbound->waiting.front());
+        outbound->waiting.pop_front();
+        command.id = next_id_++;
+
+        const uint64_t id = command.id;
+        const WritePayload payload = command.payload;
+        outbound->in_flight.push_back(std::move(command));
+        sent_.add();
+        sender_(address, *payload, mode_, id);
+    }
+}
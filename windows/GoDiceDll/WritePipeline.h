@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "FlatAddressMap.h"
+#include "Stats.h"
+#include "Transport.h"
+
+using WritePayload = std::shared_ptr<const std::vector<uint8_t>>;
+
+// Collects the outcome of one command sent to several dice
+struct WriteBatch
+{
+    std::vector<uint64_t> addresses;
+    // One per address; bool rather than std::vector<bool> so hosts can be handed the array
+    std::unique_ptr<bool[]> delivered;
+    uint32_t remaining = 0;
+    // Called once every address has an outcome
+    std::function<void(const std::shared_ptr<WriteBatch>&)> done;
+};
+
+// Outbound command queue per die. Up to max_in_flight writes per die are outstanding
+// at once (one with WriteMode::WithResponse); the rest wait in order. A command that
+// supersedes one still waiting for the same die (godice::protocol::command_class)
+// takes its place instead of queueing behind it. Not synchronised: the core only uses
+// it from the bluetooth queue.
+class WritePipeline
+{
+public:
+    static constexpr uint32_t k_default_max_in_flight = 4;
+
+    // Starts one write; the pipeline expects completed(address, id) when it is over
+    using Sender = std::function<void(uint64_t address, const std::vector<uint8_t>& payload, WriteMode mode, uint64_t id)>;
+
+    explicit WritePipeline(Sender sender);
+
+    // A max_in_flight of 0 is treated as 1
+    void configure(WriteMode mode, uint32_t max_in_flight);
+
+    // If `batch` is given, entry `index` of it is filled in once the write is over,
+    // superseded or dropped
+    void submit(uint64_t address, WritePayload payload, std::shared_ptr<WriteBatch> batch = nullptr, uint32_t index = 0);
+    void completed(uint64_t address, uint64_t id, bool success);
+
+    // Drops the die's commands, e.g. when its link goes away; writes already started
+    // count as failed and their completions are ignored
+    void forget(uint64_t address);
+    void clear();
+
+    // Marks entry `index` of the batch, calling its done callback when it was the last
+    static void resolve(const std::shared_ptr<WriteBatch>& batch, uint32_t index, bool delivered);
+
+    // Safe from any thread
+    [[nodiscard]] auto sent() const -> uint64_t { return sent_.load(); }
+    [[nodiscard]] auto coalesced() const -> uint64_t { return coalesced_.load(); }
+    [[nodiscard]] auto failed() const -> uint64_t { return failed_.load(); }
+
+private:
+    struct Command
+    {
+        WritePayload payload;
+        std::shared_ptr<WriteBatch> batch;
+        uint32_t index = 0;
+        uint64_t id = 0;
+    };
+
+    struct Outbound
+    {
+        std::deque<Command> waiting;
+        std::vector<Command> in_flight;
+    };
+
+    void start_waiting(uint64_t address);
+    static void drop(Outbound& outbound);
+
+    Sender sender_;
+    // A transport whose die cannot write without response writes with response instead,
+    // one at a time however many are in flight here
+    WriteMode mode_ = WriteMode::WithoutResponse;
+    uint32_t max_in_flight_ = k_default_max_in_flight;
+    uint64_t next_id_ = 1;
+    FlatAddressMap<Outbound> outbound_;
+
+    StatCounter sent_;
+    StatCounter coalesced_;
+    StatCounter failed_;
+};